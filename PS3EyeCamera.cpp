@@ -4,133 +4,158 @@
 
 #include "PS3EyeCamera.h"
 
+// Capture side of PS3EyeCamera. The interactive calibration members live in main.cpp next to
+// the rest of the calibration UI.
 
-// These can be file-static as they are only used by the calibration function
-static int h_min = 0, s_min = 0, v_min = 0;
-static int h_max = 179, s_max = 255, v_max = 255;
-
-// A simple callback function for the trackbars (does nothing, but is required)
-static void on_trackbar(int, void*) {}
-
-void PS3EyeCamera::calibrateColors(const std::string& output_filename) {
-    std::ofstream outfile(output_filename, std::ios::app);
-    if (!outfile.is_open()) {
-        std::cerr << "Error: Could not open file " << output_filename << " for writing." << std::endl;
-        return;
-    }
-
-    const char* colors[] = {"White", "Red", "Orange", "Yellow", "Green", "Blue"};
-    const char color_chars[] = {'W', 'R', 'O', 'Y', 'G', 'B'};
-
-    cv::namedWindow("Original", cv::WINDOW_AUTOSIZE);
-    cv::namedWindow("Mask", cv::WINDOW_AUTOSIZE);
-    cv::namedWindow("Trackbars", cv::WINDOW_AUTOSIZE);
-
-    // Create trackbars
-    cv::createTrackbar("H_MIN", "Trackbars", &h_min, 179, on_trackbar);
-    cv::createTrackbar("H_MAX", "Trackbars", &h_max, 179, on_trackbar);
-    cv::createTrackbar("S_MIN", "Trackbars", &s_min, 255, on_trackbar);
-    cv::createTrackbar("S_MAX", "Trackbars", &s_max, 255, on_trackbar);
-    cv::createTrackbar("V_MIN", "Trackbars", &v_min, 255, on_trackbar);
-    cv::createTrackbar("V_MAX", "Trackbars", &v_max, 255, on_trackbar);
-
-    for (int i = 0; i < 6; ++i) {
-        std::cout << "Calibrating for color: " << colors[i] << ". Adjust trackbars and press 's' to save." << std::endl;
-
-        while (true) {
-            cv::Mat frame, hsv_frame, mask;
-            this->capture(frame); // Use the class's capture method
-            cv::cvtColor(frame, hsv_frame, cv::COLOR_BGR2HSV);
-
-            // Create mask from trackbar values
-            cv::Scalar lower_bound(h_min, s_min, v_min);
-            cv::Scalar upper_bound(h_max, s_max, v_max);
-            cv::inRange(hsv_frame, lower_bound, upper_bound, mask);
-
-            imshow("Original", frame);
-            imshow("Mask", mask);
-
-            int key = cv::waitKey(30);
-            if (key == 's') {
-                // Save the calibrated values to the file
-                outfile << color_chars[i] << " " << h_min << " " << h_max << " "
-                        << s_min << " " << s_max << " " << v_min << " " << v_max << std::endl;
-                std::cout << colors[i] << " range saved." << std::endl;
-                break; // Move to the next color
-            }
-            if (key == 'q') { // Allow quitting early
-                outfile.close();
-                cv::destroyAllWindows();
-                return;
-            }
-        }
-    }
-
-    outfile.close();
-    cv::destroyAllWindows();
-	std::cout << "Calibration complete. Values saved to " << output_filename << std::endl;
+PS3EyeCamera::PS3EyeCamera(int height, int width, int index, int fps) {
+	this->height = height;
+	this->width = width;
+	this->index = index;
+	this->fps = fps;
+
+	source = std::make_unique<V4L2FrameSource>(index, fps);
+
+	camera_initialized = true;
+	std::cout << "Camera " << index << " initialized successfully" << std::endl;
 }
 
- PS3EyeCamera::PS3EyeCamera(int height, int width, int index, int fps) {
- 	video_capture.open(index, cv::CAP_V4L2);
- 	video_capture.set(cv::CAP_PROP_FRAME_WIDTH, width);
- 	video_capture.set(cv::CAP_PROP_FRAME_HEIGHT, height);
- 	video_capture.set(cv::CAP_PROP_FPS, fps);
- 	video_capture.set(cv::CAP_PROP_BUFFERSIZE, 1);
-
-
- 	video_capture.set(cv::CAP_PROP_AUTO_WB, 1); // Disable Auto White Balance
- 	video_capture.set(cv::CAP_PROP_AUTO_EXPOSURE, 0); // Disable Auto Exposure
- 	video_capture.set(cv::CAP_PROP_EXPOSURE, 15);
- 	video_capture.set(cv::CAP_PROP_GAIN, 10); // Set Gain (adjust as needed)
- 	video_capture.set(cv::CAP_PROP_BRIGHTNESS, 15); // Set Brightness (adjust as needed)
- 	video_capture.set(cv::CAP_PROP_CONTRAST, 9); // Set Contrast (adjust as needed)
- 	video_capture.set(cv::CAP_PROP_SATURATION, 60);
-
- 	if (!video_capture.isOpened()) {
-		std::cerr << "Camera could not be opened" << std::endl;
- 		throw std::exception();
- 	}
-
- 	// Warmup with 5 frames
- 	cv::Mat temp_frames;
- 	for (int i = 0; i < 5; i++) {
- 		video_capture.read(temp_frames);
- 	}
- }
-
-void positionMouseCallback(int event, int x, int y, int flags, void *userdata) {
- 	if (event == cv::EVENT_LBUTTONDOWN) {
-
- 	}
- }
-
-
-bool PS3EyeCamera::calibratePosition(const std::string &filename) {
-	 position_out_file.open(filename, std::ios::app);
-	 if (!position_out_file.is_open()) {
-		 std::cerr << "Error: Could not open pos.txt for writing." << std::endl;
-		 return false;
-	 }
-	 cv::Mat frame;
-	 video_capture.read(frame);
-	 cv::namedWindow("calibration", cv::WINDOW_NORMAL);
-	 cv::resizeWindow("calibration", 1280, 960);
-
-	 for (int i = 0; i < 6; i++) {
-		 for (int j = 0; j < 9; j++) {
-			 std::cout << "Click on face " << i << " facelet " << j;
-		 }
-	 }
-	 cv::setMouseCallback("calibration", positionMouseCallback, this);
-	 imshow("calibration", frame);
-	 int k = cv::waitKey(0);
-	 if (k == 'q') {
-		 position_out_file.close();
-		 return true;
-	 }
- }
+PS3EyeCamera::PS3EyeCamera(std::unique_ptr<FrameSource> source, int index) : source(std::move(source)) {
+	this->index = index;
+
+	camera_initialized = true;
+	std::cout << "Camera " << index << " initialized from frame source" << std::endl;
+}
+
+PS3EyeCamera::~PS3EyeCamera() {
+	stopStreaming();
+}
 
 void PS3EyeCamera::capture(cv::Mat &frame) {
-	video_capture.read(frame);
- }
+	if (!source->deliversYuyv()) {
+		captureRaw(frame);
+		return;
+	}
+	captureRaw(raw_frame);
+	cv::cvtColor(raw_frame, frame, cv::COLOR_YUV2BGR_YUYV);
+}
+
+void PS3EyeCamera::captureRaw(cv::Mat &frame) {
+	if (streaming.load(std::memory_order_acquire)) {
+		int64_t timestamp_us;
+		// Only blocks until the grab thread delivered its very first frame
+		while (!latestFrame(frame, timestamp_us) && streaming.load(std::memory_order_acquire)) {
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+		return;
+	}
+	source->read(frame);
+}
+
+void PS3EyeCamera::captureNewRaw(cv::Mat &frame, uint64_t &seen) {
+	if (!streaming.load(std::memory_order_acquire)) {
+		source->read(frame); // paced by the driver (or the replay clock) already
+		return;
+	}
+	while (ring->frames() <= seen && streaming.load(std::memory_order_acquire)) {
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+	int64_t timestamp_us;
+	uint64_t id;
+	if (ring->readLatest(frame, timestamp_us, id)) seen = id + 1;
+}
+
+void PS3EyeCamera::optimizeForDualCamera() {
+	if (streaming.load(std::memory_order_acquire)) {
+		// The grab thread already drains the driver queue continuously
+		std::cout << "Camera optimized for dual operation (streaming capture)" << std::endl;
+		return;
+	}
+
+	source->minimizeLatency();
+
+	std::cout << "Camera optimized for dual operation (keeping original FPS)" << std::endl;
+}
+
+bool PS3EyeCamera::startStreaming(size_t ring_size) {
+	if (streaming.load(std::memory_order_acquire)) return true;
+	if (!source->paced()) {
+		// Frames would be produced as fast as the grab thread runs; capture on demand instead
+		std::cout << "Camera " << index << ": frame source is unpaced, capturing on demand" << std::endl;
+		return false;
+	}
+
+	// Size the ring from a real frame so the grab thread never reallocates
+	cv::Mat first;
+	if (!source->read(first) || first.empty()) {
+		std::cerr << "Camera " << index << ": could not read a frame to start streaming" << std::endl;
+		return false;
+	}
+	ring = std::make_unique<FrameRing>(ring_size);
+	// Lent buffers stay out of the driver queue while a slot holds them; the driver keeps two to fill
+	const size_t buffers = source->lendableBuffers();
+	lending = buffers >= ring_size + 2;
+	if (buffers > 0 && !lending) {
+		std::cout << "Camera " << index << ": " << buffers << " capture buffers cannot back a " << ring_size
+				  << "-frame ring, copying frames into it" << std::endl;
+	}
+	ring->allocate(first.rows, first.cols, first.type(), !lending);
+
+	streaming.store(true, std::memory_order_release);
+	grab_thread = std::thread(&PS3EyeCamera::grabLoop, this);
+	std::cout << "Camera " << index << " streaming into a " << ring_size << "-frame ring"
+			  << (lending ? " of driver buffers" : "") << std::endl;
+	return true;
+}
+
+void PS3EyeCamera::stopStreaming() {
+	if (!streaming.exchange(false, std::memory_order_acq_rel)) return;
+	if (grab_thread.joinable()) {
+		grab_thread.join();
+	}
+	if (lending) {
+		ring->reclaimLent([this](int buffer) { source->giveBack(buffer); });
+	}
+}
+
+bool PS3EyeCamera::latestFrame(cv::Mat& frame, int64_t& timestamp_us) {
+	if (!ring) return false;
+	uint64_t id;
+	return ring->readLatest(frame, timestamp_us, id);
+}
+
+void PS3EyeCamera::grabLoop() {
+	while (streaming.load(std::memory_order_acquire)) {
+		// grab() waits for the driver; only the decode into the slot happens inside the write window
+		int64_t timestamp_us;
+		if (!source->grab(timestamp_us)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		if (lending) {
+			// The slot takes the driver buffer itself; the one it held before goes back to the driver
+			cv::Mat frame;
+			int buffer;
+			if (source->lend(frame, buffer)) {
+				const int previous = ring->commitLent(frame, buffer, timestamp_us);
+				if (previous >= 0) source->giveBack(previous);
+			}
+			continue;
+		}
+
+		cv::Mat& slot = ring->beginWrite();
+		if (!source->retrieve(slot)) {
+			ring->abortWrite();
+		} else if (!ring->commitWrite(timestamp_us)) {
+			std::cerr << "Camera " << index << ": frame size changed while streaming, dropping it" << std::endl;
+		}
+	}
+}
+
+bool PS3EyeCamera::grabFrame(int64_t& timestamp_us) {
+	return source->grab(timestamp_us);
+}
+
+bool PS3EyeCamera::retrieveFrame(cv::Mat& frame) {
+	return source->retrieve(frame);
+}
@@ -5,26 +5,71 @@
 #ifndef PS3EYECAMERA_H
 #define PS3EYECAMERA_H
 
-#include <opencv4/opencv2/core.hpp>
-#include <opencv4/opencv2/videoio.hpp>
+#include "opencv2/opencv.hpp"
+#include "frame_ring.h"
+#include "frame_source.h"
+#include <atomic>
 #include <chrono>
-#include <opencv4/opencv2/highgui.hpp>
-#include <opencv4/opencv2/imgproc.hpp>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <thread>
 
 class PS3EyeCamera {
 private:
 	int height{}, width{}, index{}, fps{};
-	cv::VideoCapture video_capture;
+	std::unique_ptr<FrameSource> source;
 	bool camera_initialized = false;
 	std::ofstream position_out_file;
+
+	// Streaming mode: a grab thread keeps the newest frames in a preallocated ring
+	std::unique_ptr<FrameRing> ring;
+	std::thread grab_thread;
+	std::atomic<bool> streaming{false};
+	bool lending = false; // the ring holds the source's buffers instead of copies
+	cv::Mat raw_frame; // capture() converts YUYV frames from here
+	void grabLoop();
 public:
 	explicit PS3EyeCamera(int height = 320, int width = 240, int index = 4, int fps = 187);
+	// Camera backed by any frame source, e.g. a recorded session; index is only used in messages
+	PS3EyeCamera(std::unique_ptr<FrameSource> source, int index);
+	~PS3EyeCamera();
 	bool calibratePosition(const std::string &filename);
 	void calibrateColors(const std::string &filename);
 	void friend positionMouseCallback(int event, int x, int y, int flags, void* userdata);
+	// Blocking read in direct mode, newest buffered frame while streaming; always BGR
 	void capture(cv::Mat& frame);
+	// The same in the source's own format (see deliversYuyv()); the ring, readFrame() and
+	// retrieveFrame() hand out frames in this format too
+	void captureRaw(cv::Mat& frame);
+	// captureRaw() for loops that should run at the camera's rate: while streaming, waits until
+	// the grab thread has committed a frame newer than the one the last call returned. `seen`
+	// carries the frame count between calls (start at 0).
+	void captureNewRaw(cv::Mat& frame, uint64_t& seen);
+	bool deliversYuyv() const { return source->deliversYuyv(); }
+	void optimizeForDualCamera();
+
+	// Starts the background grab thread; capture() then returns immediately with the newest frame
+	bool startStreaming(size_t ring_size = 4);
+	void stopStreaming();
+	bool isStreaming() const { return streaming.load(std::memory_order_acquire); }
+	// Newest frame and its capture time (CLOCK_MONOTONIC, microseconds); false if none yet
+	bool latestFrame(cv::Mat& frame, int64_t& timestamp_us);
+
+	// Random access into the streaming ring, for pairing frames across cameras
+	uint64_t frameCount() const { return ring ? ring->frames() : 0; }
+	size_t ringSize() const { return ring ? ring->size() : 0; }
+	bool frameTimestamp(uint64_t id, int64_t& timestamp_us) const { return ring && ring->timestamp(id, timestamp_us); }
+	bool readFrame(uint64_t id, cv::Mat& frame, int64_t& timestamp_us) const {
+		return ring && ring->read(id, frame, timestamp_us);
+	}
+
+	// Direct (non-streaming) two-step capture so two cameras can latch frames back to back
+	bool grabFrame(int64_t& timestamp_us);
+	bool retrieveFrame(cv::Mat& frame);
+
+	// True when timestamps come from the V4L2 buffers (or a recording) rather than from the host clock after grab()
+	bool hasDeviceTimestamps() const { return source->hasDeviceTimestamps(); }
 };
 
 
@@ -1,4 +1,6 @@
 #include "arduino_detection.h"
+#include "cube_geometry.h"
+#include "cube_repair.h"
 #include <fstream>
 #include <iostream>
 #include <cmath>
@@ -6,6 +8,7 @@
 
 ArduinoStyleDetection::ArduinoStyleDetection() {
     // Initialize with default values
+    buildColorTable();
 }
 
 ArduinoStyleDetection::~ArduinoStyleDetection() {
@@ -94,9 +97,40 @@ bool ArduinoStyleDetection::loadColorCalibration(const std::string& color_file)
     }
     
     file.close();
+    buildColorTable();
     return true;
 }
 
+void ArduinoStyleDetection::buildColorTable() {
+    constexpr int cells = 1 << lut_bits;
+    constexpr int half_cell = (1 << lut_shift) / 2;
+    color_lut.resize(static_cast<size_t>(cells) * cells * cells);
+    for (int rq = 0; rq < cells; rq++) {
+        for (int gq = 0; gq < cells; gq++) {
+            for (int bq = 0; bq < cells; bq++) {
+                color_lut[(rq * cells + gq) * cells + bq] = classifyRgbExact(
+                        (rq << lut_shift) + half_cell, (gq << lut_shift) + half_cell, (bq << lut_shift) + half_cell);
+            }
+        }
+    }
+}
+
+char ArduinoStyleDetection::classifyRgbExact(int r, int g, int b) {
+    return applyColorDisambiguation(findClosestColor(r, g, b), r, g, b);
+}
+
+double ArduinoStyleDetection::colorTableAgreement() {
+    size_t agree = 0;
+    for (int r = 0; r < 256; r++) {
+        for (int g = 0; g < 256; g++) {
+            for (int b = 0; b < 256; b++) {
+                agree += classifyRgb(r, g, b) == classifyRgbExact(r, g, b);
+            }
+        }
+    }
+    return static_cast<double>(agree) / (1 << 24);
+}
+
 int ArduinoStyleDetection::calculateColorDistance(int r, int g, int b, int face_index) {
     // Manhattan distance (same as Arduino code)
     return abs(reference_colors[face_index][0] - r) + 
@@ -171,19 +205,29 @@ char ArduinoStyleDetection::applyColorDisambiguation(int min_color, int r, int g
     return face_assign[min_color];
 }
 
-bool ArduinoStyleDetection::isHardFacet(int facet_index) {
-    return std::find(hard_facets.begin(), hard_facets.end(), facet_index) != hard_facets.end();
-}
-
 char ArduinoStyleDetection::inferCornerColor(int facet_index, const std::array<char, 54>& cube_state) {
-    // This is a simplified version - in a real implementation you'd need
-    // to map each corner facet to its adjacent facets and use the lookup table
-    
-    // For now, return unknown - this would need cube geometry mapping
-    return '?';
+    // Two colors of a corner, read in the corner's cyclic facet order, identify the piece and
+    // with it the third color
+    for (const auto& corner : cube_geometry::kCornerFacelets) {
+        for (int k = 0; k < 3; k++) {
+            if (corner[k] != facet_index) continue;
+
+            const char next = cube_state[corner[(k + 1) % 3]];
+            const char after = cube_state[corner[(k + 2) % 3]];
+            for (const auto& colors : cube_geometry::kCornerColors) {
+                for (int twist = 0; twist < 3; twist++) {
+                    if (colors[(twist + 1) % 3] == next && colors[(twist + 2) % 3] == after) {
+                        return colors[twist];
+                    }
+                }
+            }
+            return '?';
+        }
+    }
+    return '?'; // not a corner facet
 }
 
-bool ArduinoStyleDetection::validateCubeConfiguration(const std::array<char, 54>& cube_state) {
+bool ArduinoStyleDetection::validateCubeConfiguration(const std::array<char, 54>& cube_state, bool verbose) {
     int count[6] = {0, 0, 0, 0, 0, 0}; // Count for each color
     
     for (int i = 0; i < 54; i++) {
@@ -205,19 +249,19 @@ bool ArduinoStyleDetection::validateCubeConfiguration(const std::array<char, 54>
     bool valid = true;
     for (int i = 0; i < 6; i++) {
         if (count[i] != 9) {
-            std::cout << "Error: Face " << face_assign[i] << " has " << count[i] << " facets" << std::endl;
+            if (verbose) std::cout << "Error: Face " << face_assign[i] << " has " << count[i] << " facets" << std::endl;
             valid = false;
         }
     }
     
-    if (valid) {
+    if (valid && verbose) {
         std::cout << "✓ Cube Configuration is Correct" << std::endl;
     }
     
     return valid;
 }
 
-int ArduinoStyleDetection::detectCube(cv::Mat& frame1, cv::Mat& frame2, std::array<char, 54>& cube_state) {
+int ArduinoStyleDetection::detectCube(cv::Mat& frame1, cv::Mat& frame2, std::array<char, 54>& cube_state, bool verbose) {
     if (camera_1_points.empty() || camera_2_points.empty()) {
         std::cerr << "Error: Position calibration not loaded" << std::endl;
         return 0;
@@ -231,8 +275,8 @@ int ArduinoStyleDetection::detectCube(cv::Mat& frame1, cv::Mat& frame2, std::arr
         for (int facet = 0; facet < 9; facet++) {
             int facet_index = face * 9 + facet;
             
-            // Skip center facets (they're constant) and hard facets
-            if (facet == 4 || isHardFacet(facet_index)) {
+            // Skip center facets (they're constant); hard facets are read too but stay open to repair
+            if (facet == 4) {
                 continue;
             }
             
@@ -272,11 +316,8 @@ int ArduinoStyleDetection::detectCube(cv::Mat& frame1, cv::Mat& frame2, std::arr
                 int g = bgr_pixel[1];
                 int b = bgr_pixel[0];
                 
-                // Find closest color and apply disambiguation
-                int closest = findClosestColor(r, g, b);
-                char final_color = applyColorDisambiguation(closest, r, g, b);
-                
-                cube_state[facet_index] = final_color;
+                // Closest color plus disambiguation, precomputed per quantized RGB cell
+                cube_state[facet_index] = classifyRgb(r, g, b);
             }
         }
     }
@@ -290,16 +331,36 @@ int ArduinoStyleDetection::detectCube(cv::Mat& frame1, cv::Mat& frame2, std::arr
     cube_state[49] = face_assign[5];  // B center
     
     // Phase 2: Infer hard facets using geometric constraints
-    // (This would require implementing the corner mapping logic)
+    // Unreadable corner facets first take the color implied by the other two facets of their corner
     for (int hard_facet : hard_facets) {
         if (cube_state[hard_facet] == '?') {
-            // For now, mark as unknown - full implementation would use corner inference
-            cube_state[hard_facet] = 'X'; // Mark as undetected
+            cube_state[hard_facet] = inferCornerColor(hard_facet, cube_state);
+        }
+    }
+
+    // Then up to 3 hard or unreadable facets are corrected so the cube consists of real pieces
+    uint64_t changeable = 0;
+    std::array<float, 54> confidence;
+    confidence.fill(1.0f);
+    for (int i = 0; i < 54; i++) {
+        if (cube_state[i] == '?' || isHardFacet(i)) {
+            changeable |= 1ull << i;
+            confidence[i] = cube_state[i] == '?' ? 0.0f : 0.5f;
+        }
+    }
+    const cube_repair::Result repair = cube_repair::repair(cube_state, changeable, confidence, 3);
+    if (verbose && repair.repaired && repair.changes > 0) {
+        std::cout << "Repaired " << repair.changes << " facets from cube geometry" << std::endl;
+    }
+
+    for (char& facet : cube_state) {
+        if (facet == '?') {
+            facet = 'X'; // Mark as undetected
         }
     }
     
     // Validate configuration
-    return validateCubeConfiguration(cube_state) ? 1 : 0;
+    return validateCubeConfiguration(cube_state, verbose) ? 1 : 0;
 }
 
 void ArduinoStyleDetection::calibrateColors(FrameCaptureCallback captureFrames) {
@@ -382,13 +443,13 @@ void ArduinoStyleDetection::calibrateColors(FrameCaptureCallback captureFrames)
                 reference_colors[color_index][1] = g;
                 reference_colors[color_index][2] = b;
                 std::cout << "Calibrated " << face_assign[color_index] << ": RGB(" << r << "," << g << "," << b << ")" << std::endl;
+                buildColorTable();
                 
                 // Save to file
                 std::ofstream outfile("arduino_colors.txt");
                 if (outfile.is_open()) {
-                    char color_chars[] = {'W', 'R', 'G', 'O', 'B', 'Y'};
                     for (int i = 0; i < 6; i++) {
-                        outfile << color_chars[i] << " " << reference_colors[i][0] << " " 
+                        outfile << color_names[i] << " " << reference_colors[i][0] << " " 
                                << reference_colors[i][1] << " " << reference_colors[i][2] << std::endl;
                     }
                     outfile.close();
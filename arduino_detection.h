@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <array>
+#include <cstdint>
 #include <functional>
 
 class ArduinoStyleDetection {
@@ -20,21 +21,24 @@ private:
     
     // Face assignments (characters for each color)
     char face_assign[6] = {'U', 'R', 'F', 'D', 'L', 'B'};
+    // Color letter of each reference, as used in arduino_colors.txt
+    static constexpr char color_names[6] = {'W', 'R', 'G', 'O', 'B', 'Y'};
     
-    // Hard-to-detect facet indices (corners that are difficult to see)
-    std::vector<int> hard_facets = {0, 2, 6, 8, 9, 11, 15, 17, 18, 20, 24, 26, 27, 29, 33, 35, 36, 38, 42, 44, 45, 47, 51, 53};
-    
-    // Corner assignment lookup table [primary_color][secondary_color] -> third_color
-    // Based on cube geometry - if you know 2 colors of a corner, you can deduce the 3rd
-    char corner_assign[6][6] = {
-        //   U  R  F  D  L  B
-        {'?','D','L','R','F','?'}, // U
-        {'D','?','U','F','?','L'}, // R  
-        {'L','U','?','?','D','R'}, // F
-        {'R','F','?','?','B','U'}, // D
-        {'F','?','D','B','?','U'}, // L
-        {'?','L','R','U','?','?'}  // B
-    };
+    // Hard-to-detect facet indices (corners that are difficult to see); their readings may be
+    // overridden by the piece-geometry repair
+    static constexpr std::array<int, 24> hard_facets = {0, 2, 6, 8, 9, 11, 15, 17, 18, 20, 24, 26, 27, 29, 33, 35, 36, 38, 42, 44, 45, 47, 51, 53};
+    static constexpr uint64_t hard_facet_mask = [] {
+        uint64_t mask = 0;
+        for (int facet : hard_facets) mask |= 1ull << facet;
+        return mask;
+    }();
+
+    // Quantized RGB -> face table: findClosestColor() + applyColorDisambiguation() evaluated at the
+    // center of every (r, g, b) cell with lut_bits bits per channel, rebuilt whenever the
+    // reference colors change. 2^18 entries = 256 KB.
+    static constexpr int lut_bits = 6;
+    static constexpr int lut_shift = 8 - lut_bits;
+    std::vector<char> color_lut;
     
     std::vector<cv::Point> camera_1_points;
     std::vector<cv::Point> camera_2_points;
@@ -49,16 +53,35 @@ public:
     // Load color calibration (RGB reference colors)
     bool loadColorCalibration(const std::string& color_file);
     
-    // Main detection function
-    int detectCube(cv::Mat& frame1, cv::Mat& frame2, std::array<char, 54>& cube_state);
+    // Main detection function; verbose = false keeps the per-frame loop quiet
+    int detectCube(cv::Mat& frame1, cv::Mat& frame2, std::array<char, 54>& cube_state, bool verbose = true);
+
+    // Rebuilds the quantized RGB table from reference_colors
+    void buildColorTable();
+    char classifyRgb(int r, int g, int b) const {
+        return color_lut[((r >> lut_shift) << (2 * lut_bits)) | ((g >> lut_shift) << lut_bits) | (b >> lut_shift)];
+    }
+    // What classifyRgb()'s face letter stands for as a color letter (W R G O B Y, 'N' if none)
+    char colorOfFace(char face) const {
+        for (int i = 0; i < 6; i++) {
+            if (face_assign[i] == face) return color_names[i];
+        }
+        return 'N';
+    }
+    // Exact per-pixel classification the table is built from
+    char classifyRgbExact(int r, int g, int b);
+    // Share of all 2^24 RGB values on which the table agrees with the exact classification
+    double colorTableAgreement();
     
     // Helper functions
     int calculateColorDistance(int r, int g, int b, int face_index);
     int findClosestColor(int r, int g, int b);
     char applyColorDisambiguation(int min_color, int r, int g, int b);
-    bool isHardFacet(int facet_index);
+    static constexpr bool isHardFacet(int facet_index) {
+        return facet_index >= 0 && facet_index < 64 && (hard_facet_mask >> facet_index & 1);
+    }
     char inferCornerColor(int facet_index, const std::array<char, 54>& cube_state);
-    bool validateCubeConfiguration(const std::array<char, 54>& cube_state);
+    bool validateCubeConfiguration(const std::array<char, 54>& cube_state, bool verbose = true);
     
     // Calibration helpers
     typedef std::function<bool(cv::Mat&, cv::Mat&)> FrameCaptureCallback;
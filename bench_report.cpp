@@ -0,0 +1,140 @@
+#include "bench_report.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+// Nearest-rank percentile of an ascending sample vector
+static double percentile(const std::vector<double>& sorted, double p) {
+	if (sorted.empty()) return 0;
+	size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+	rank = std::clamp<size_t>(rank, 1, sorted.size());
+	return sorted[rank - 1];
+}
+
+static std::string jsonEscape(const std::string& s) {
+	std::string out;
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if (c == '\n') {
+			out += "\\n";
+		} else if (c == '\t') {
+			out += "\\t";
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			char escaped[7];
+			std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+			out += escaped;
+		} else {
+			out += c;
+		}
+	}
+	return out;
+}
+
+void BenchReport::record(const std::string& stage, double ms) {
+	for (auto& s : stages) {
+		if (s.name == stage) {
+			s.samples_ms.push_back(ms);
+			return;
+		}
+	}
+	stages.push_back({stage, {ms}});
+}
+
+void BenchReport::setInfo(const std::string& key, const std::string& value) {
+	for (auto& kv : info) {
+		if (kv.first == key) {
+			kv.second = value;
+			return;
+		}
+	}
+	info.emplace_back(key, value);
+}
+
+std::vector<BenchReport::Summary> BenchReport::summarize() const {
+	std::vector<Summary> summaries;
+	for (const auto& s : stages) {
+		std::vector<double> sorted = s.samples_ms;
+		std::sort(sorted.begin(), sorted.end());
+
+		Summary summary;
+		summary.stage = s.name;
+		summary.count = sorted.size();
+		summary.p50_ms = percentile(sorted, 50);
+		summary.p90_ms = percentile(sorted, 90);
+		summary.p99_ms = percentile(sorted, 99);
+		summary.max_ms = sorted.empty() ? 0 : sorted.back();
+		summary.mean_ms = sorted.empty() ? 0 : std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+		summaries.push_back(summary);
+	}
+	return summaries;
+}
+
+void BenchReport::print() const {
+	std::cout << std::left << std::setw(20) << "stage" << std::right << std::setw(8) << "count"
+			  << std::setw(11) << "p50 ms" << std::setw(11) << "p90 ms" << std::setw(11) << "p99 ms"
+			  << std::setw(11) << "max ms" << std::endl;
+	std::cout << std::fixed << std::setprecision(4);
+	for (const auto& s : summarize()) {
+		std::cout << std::left << std::setw(20) << s.stage << std::right << std::setw(8) << s.count
+				  << std::setw(11) << s.p50_ms << std::setw(11) << s.p90_ms << std::setw(11) << s.p99_ms
+				  << std::setw(11) << s.max_ms << std::endl;
+	}
+	std::cout << std::defaultfloat;
+}
+
+bool BenchReport::writeCsv(const std::string& filename) const {
+	std::ofstream out(filename);
+	if (!out.is_open()) {
+		std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+		return false;
+	}
+	for (const auto& kv : info) {
+		out << "# " << kv.first << "=" << kv.second << "\n";
+	}
+	out << "stage,count,p50_ms,p90_ms,p99_ms,max_ms,mean_ms\n";
+	out << std::setprecision(6);
+	for (const auto& s : summarize()) {
+		out << s.stage << "," << s.count << "," << s.p50_ms << "," << s.p90_ms << "," << s.p99_ms << ","
+			<< s.max_ms << "," << s.mean_ms << "\n";
+	}
+	out.close();
+	if (!out) {
+		std::cerr << "Error: Could not write " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool BenchReport::writeJson(const std::string& filename) const {
+	std::ofstream out(filename);
+	if (!out.is_open()) {
+		std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+		return false;
+	}
+	out << std::setprecision(6);
+	out << "{\n  \"info\": {";
+	for (size_t i = 0; i < info.size(); i++) {
+		out << (i ? ", " : "") << "\"" << jsonEscape(info[i].first) << "\": \"" << jsonEscape(info[i].second) << "\"";
+	}
+	out << "},\n  \"stages\": [\n";
+	const auto summaries = summarize();
+	for (size_t i = 0; i < summaries.size(); i++) {
+		const auto& s = summaries[i];
+		out << "    {\"stage\": \"" << jsonEscape(s.stage) << "\", \"count\": " << s.count << ", \"p50_ms\": "
+			<< s.p50_ms << ", \"p90_ms\": " << s.p90_ms << ", \"p99_ms\": " << s.p99_ms << ", \"max_ms\": "
+			<< s.max_ms << ", \"mean_ms\": " << s.mean_ms << "}" << (i + 1 < summaries.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+	out.close();
+	if (!out) {
+		std::cerr << "Error: Could not write " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Per-stage latency samples of a benchmark run, summarized as percentiles.
+//
+// Stages are reported in the order they were first recorded. A stage can have fewer samples
+// than there were iterations (e.g. no solve when validation failed); its count says so.
+class BenchReport {
+public:
+	struct Summary {
+		std::string stage;
+		size_t count = 0;
+		double p50_ms = 0, p90_ms = 0, p99_ms = 0, max_ms = 0, mean_ms = 0;
+	};
+
+	void record(const std::string& stage, double ms);
+	// Free-form key/value pairs written alongside the results (source, iterations, ...)
+	void setInfo(const std::string& key, const std::string& value);
+
+	std::vector<Summary> summarize() const;
+
+	void print() const;
+	bool writeCsv(const std::string& filename) const;
+	bool writeJson(const std::string& filename) const;
+
+private:
+	struct Stage {
+		std::string name;
+		std::vector<double> samples_ms;
+	};
+	std::vector<Stage> stages;
+	std::vector<std::pair<std::string, std::string>> info;
+};
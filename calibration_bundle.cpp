@@ -0,0 +1,299 @@
+#include "calibration_bundle.h"
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'R', 'C', 'C', 'A', 'L', 'I', 'B', '\0'};
+
+// The file is exactly this struct. It is zero-filled before writing, so the padding is part of
+// the checksum too.
+struct BundleFile {
+	char magic[8];
+	uint32_t version;
+	uint32_t size; // sizeof(BundleFile)
+	uint64_t checksum; // over everything after this field
+
+	int32_t camera[8]; // width, height, fps, exposure, gain, brightness, contrast, saturation
+	uint32_t point_count[2];
+	int16_t points[2][calibration_bundle::kMaxPoints][2];
+
+	uint32_t rule_count;
+	struct Rule {
+		char color;
+		uint8_t hue_wrap;
+		int16_t h_min, h_max, s_min, s_max, v_min, v_max;
+	} rules[ColorClassifier::kMaxRules];
+	uint32_t h_bits[180];
+	uint32_t s_bits[256];
+	uint32_t v_bits[256];
+	char color_by_width[ColorClassifier::kMaxRules + 1];
+};
+
+constexpr size_t kChecksumStart = offsetof(BundleFile, checksum) + sizeof(uint64_t);
+
+// Word-at-a-time multiplicative hash, as for the solver table manifest
+uint64_t hashBytes(const unsigned char* data, size_t size) {
+	constexpr uint64_t kMul = 0x9E3779B97F4A7C15ull;
+	uint64_t h = 0;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		std::memcpy(&word, data + i, 8);
+		h = (h ^ word) * kMul;
+		h ^= h >> 29;
+	}
+	for (; i < size; i++) {
+		h = (h ^ data[i]) * kMul;
+	}
+	return h;
+}
+
+uint64_t checksumOf(const BundleFile& file) {
+	return hashBytes(reinterpret_cast<const unsigned char*>(&file) + kChecksumStart, sizeof(BundleFile) - kChecksumStart);
+}
+
+bool readPoints(const std::string& filename, std::vector<cv::Point>& points) {
+	std::ifstream in(filename);
+	if (!in.is_open()) {
+		std::cerr << "Could not open position file: " << filename << std::endl;
+		return false;
+	}
+	points.clear();
+	int x, y;
+	while (static_cast<int>(points.size()) < calibration_bundle::kMaxPoints && in >> x >> y) {
+		points.emplace_back(x, y);
+	}
+	return true;
+}
+
+bool modificationTime(const std::string& filename, timespec& mtime) {
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0) return false;
+	mtime = st.st_mtim;
+	return true;
+}
+
+} // namespace
+
+namespace calibration_bundle {
+
+bool write(const std::string& filename, const Calibration& calibration) {
+	auto file = std::make_unique<BundleFile>();
+	std::memset(file.get(), 0, sizeof(BundleFile));
+	std::memcpy(file->magic, kMagic, sizeof(kMagic));
+	file->version = kVersion;
+	file->size = sizeof(BundleFile);
+
+	const Calibration::Camera& camera = calibration.camera;
+	const int32_t settings[8] = {camera.width, camera.height, camera.fps, camera.exposure,
+								 camera.gain, camera.brightness, camera.contrast, camera.saturation};
+	std::memcpy(file->camera, settings, sizeof(settings));
+	for (int cam = 0; cam < 2; cam++) {
+		const std::vector<cv::Point>& points = calibration.points[cam];
+		if (points.size() > static_cast<size_t>(kMaxPoints)) {
+			std::cerr << "Error: Calibration bundle holds at most " << kMaxPoints << " points per camera" << std::endl;
+			return false;
+		}
+		file->point_count[cam] = static_cast<uint32_t>(points.size());
+		for (size_t i = 0; i < points.size(); i++) {
+			file->points[cam][i][0] = static_cast<int16_t>(points[i].x);
+			file->points[cam][i][1] = static_cast<int16_t>(points[i].y);
+		}
+	}
+
+	const ColorClassifier& classifier = calibration.classifier;
+	const std::vector<ColorClassifier::Rule>& rules = classifier.getRules();
+	file->rule_count = static_cast<uint32_t>(rules.size());
+	for (size_t i = 0; i < rules.size(); i++) {
+		const ColorClassifier::Rule& rule = rules[i];
+		file->rules[i] = {rule.color,
+						  static_cast<uint8_t>(rule.hue_wrap),
+						  static_cast<int16_t>(rule.h_min),
+						  static_cast<int16_t>(rule.h_max),
+						  static_cast<int16_t>(rule.s_min),
+						  static_cast<int16_t>(rule.s_max),
+						  static_cast<int16_t>(rule.v_min),
+						  static_cast<int16_t>(rule.v_max)};
+	}
+	std::memcpy(file->h_bits, classifier.hueBits().data(), sizeof(file->h_bits));
+	std::memcpy(file->s_bits, classifier.satBits().data(), sizeof(file->s_bits));
+	std::memcpy(file->v_bits, classifier.valBits().data(), sizeof(file->v_bits));
+	std::memcpy(file->color_by_width, classifier.colorsByWidth().data(), sizeof(file->color_by_width));
+	file->checksum = checksumOf(*file);
+
+	// Write to a temporary and rename, so a watcher or a starting process never sees half a bundle
+	const std::string tmp_path = filename + ".tmp";
+	{
+		std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+		if (!out.is_open()) {
+			std::cerr << "Error: Could not open " << tmp_path << " for writing" << std::endl;
+			return false;
+		}
+		out.write(reinterpret_cast<const char*>(file.get()), sizeof(BundleFile));
+		if (!out) {
+			std::cerr << "Error: Could not write " << tmp_path << std::endl;
+			return false;
+		}
+	}
+	if (std::rename(tmp_path.c_str(), filename.c_str()) != 0) {
+		std::cerr << "Error: Could not replace " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool load(const std::string& filename, Calibration& calibration) {
+	const int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != sizeof(BundleFile)) {
+		close(fd);
+		std::cerr << "Warning: " << filename << " is not a calibration bundle of this version" << std::endl;
+		return false;
+	}
+	void* mapped = mmap(nullptr, sizeof(BundleFile), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		std::cerr << "Warning: Could not map " << filename << std::endl;
+		return false;
+	}
+	const BundleFile& file = *static_cast<const BundleFile*>(mapped);
+
+	bool ok = std::memcmp(file.magic, kMagic, sizeof(kMagic)) == 0 && file.version == kVersion &&
+			  file.size == sizeof(BundleFile) && file.checksum == checksumOf(file) &&
+			  file.point_count[0] <= kMaxPoints && file.point_count[1] <= kMaxPoints &&
+			  file.rule_count <= ColorClassifier::kMaxRules;
+	if (ok) {
+		Calibration::Camera& camera = calibration.camera;
+		camera = {file.camera[0], file.camera[1], file.camera[2], file.camera[3],
+				  file.camera[4], file.camera[5], file.camera[6], file.camera[7]};
+		for (int cam = 0; cam < 2; cam++) {
+			calibration.points[cam].clear();
+			for (uint32_t i = 0; i < file.point_count[cam]; i++) {
+				calibration.points[cam].emplace_back(file.points[cam][i][0], file.points[cam][i][1]);
+			}
+		}
+
+		std::vector<ColorClassifier::Rule> rules(file.rule_count);
+		for (uint32_t i = 0; i < file.rule_count; i++) {
+			const BundleFile::Rule& r = file.rules[i];
+			rules[i] = {r.color, r.h_min, r.h_max, r.s_min, r.s_max, r.v_min, r.v_max, r.hue_wrap != 0};
+		}
+		std::array<uint32_t, 180> h_bits;
+		std::array<uint32_t, 256> s_bits, v_bits;
+		std::array<char, ColorClassifier::kMaxRules + 1> colors;
+		std::memcpy(h_bits.data(), file.h_bits, sizeof(file.h_bits));
+		std::memcpy(s_bits.data(), file.s_bits, sizeof(file.s_bits));
+		std::memcpy(v_bits.data(), file.v_bits, sizeof(file.v_bits));
+		std::memcpy(colors.data(), file.color_by_width, sizeof(file.color_by_width));
+		ok = calibration.classifier.restore(rules, h_bits, s_bits, v_bits, colors);
+	}
+	munmap(mapped, sizeof(BundleFile));
+
+	if (!ok) std::cerr << "Warning: " << filename << " is corrupt or from another version" << std::endl;
+	return ok;
+}
+
+bool compile(const std::string& position_file_1, const std::string& position_file_2,
+			 const std::string& color_range_file, const Calibration::Camera& camera, Calibration& calibration) {
+	if (!readPoints(position_file_1, calibration.points[0]) || !readPoints(position_file_2, calibration.points[1])) {
+		return false;
+	}
+	if (!calibration.classifier.loadFromFile(color_range_file)) {
+		std::cerr << "Could not open LUT file: " << color_range_file << ". Using default hardcoded LUT." << std::endl;
+		calibration.classifier.loadDefaults();
+	}
+	calibration.camera = camera;
+	return true;
+}
+
+bool stale(const std::string& filename, const std::vector<std::string>& sources) {
+	timespec bundle_time;
+	if (!modificationTime(filename, bundle_time)) return true;
+	for (const std::string& source : sources) {
+		timespec source_time;
+		if (!modificationTime(source, source_time)) continue;
+		if (source_time.tv_sec > bundle_time.tv_sec ||
+			(source_time.tv_sec == bundle_time.tv_sec && source_time.tv_nsec > bundle_time.tv_nsec)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace calibration_bundle
+
+CalibrationWatcher::CalibrationWatcher(std::string filename, Callback on_change) :
+	filename(std::move(filename)), on_change(std::move(on_change)) {
+	// The bundle is replaced by a rename, which only the directory sees
+	const size_t slash = this->filename.rfind('/');
+	const std::string directory = slash == std::string::npos ? "." : this->filename.substr(0, slash + 1);
+
+	inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+	stop_fd = eventfd(0, EFD_CLOEXEC);
+	if (inotify_fd < 0 || stop_fd < 0 ||
+		inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		const std::string message = "could not watch " + directory + " (" + std::strerror(errno) + ")";
+		if (inotify_fd >= 0) close(inotify_fd);
+		if (stop_fd >= 0) close(stop_fd);
+		throw std::runtime_error(message);
+	}
+	thread = std::thread(&CalibrationWatcher::watchLoop, this);
+}
+
+CalibrationWatcher::~CalibrationWatcher() {
+	const uint64_t one = 1;
+	if (::write(stop_fd, &one, sizeof(one)) < 0) {
+		std::cerr << "Warning: Could not stop the calibration watcher" << std::endl;
+	}
+	thread.join();
+	close(inotify_fd);
+	close(stop_fd);
+}
+
+void CalibrationWatcher::watchLoop() {
+	const size_t slash = filename.rfind('/');
+	const std::string name = slash == std::string::npos ? filename : filename.substr(slash + 1);
+	alignas(inotify_event) char events[sizeof(inotify_event) + NAME_MAX + 1];
+
+	pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+	while (true) {
+		if (poll(fds, 2, -1) < 0) {
+			// revents are left as they were; only read them after a successful poll
+			if (errno == EINTR) continue;
+			return;
+		}
+		if (fds[1].revents & POLLIN) return;
+		if (!(fds[0].revents & POLLIN)) continue;
+
+		bool changed = false;
+		ssize_t length;
+		while ((length = read(inotify_fd, events, sizeof(events))) > 0) {
+			for (ssize_t offset = 0; offset < length;) {
+				const auto* event = reinterpret_cast<const inotify_event*>(events + offset);
+				if (event->len > 0 && name == event->name) changed = true;
+				offset += sizeof(inotify_event) + event->len;
+			}
+		}
+		if (!changed) continue;
+
+		auto calibration = std::make_shared<Calibration>();
+		if (calibration_bundle::load(filename, *calibration)) {
+			on_change(std::move(calibration));
+		}
+	}
+}
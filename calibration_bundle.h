@@ -0,0 +1,67 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include "color_lut.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Everything detection takes from calibration, kept and swapped as one unit
+struct Calibration {
+	// Camera settings the calibration was made with; sticker points only hold for this resolution
+	struct Camera {
+		int width = 0, height = 0, fps = 0;
+		int exposure = 0, gain = 0, brightness = 0, contrast = 0, saturation = 0;
+	};
+
+	std::vector<cv::Point> points[2];
+	ColorClassifier classifier;
+	Camera camera;
+};
+
+// Compiled calibration: sticker points of both cameras, the finished color classifier masks and
+// the camera settings in one fixed-layout, versioned binary file.
+//
+// Loading maps the file and checks its size, version and checksum; there is nothing to parse and
+// no table to rebuild. Bundles are written to a temporary file and renamed into place, so a
+// process watching the bundle (CalibrationWatcher) never sees half of one.
+namespace calibration_bundle {
+	constexpr uint32_t kVersion = 1;
+	constexpr int kMaxPoints = 64; // per camera
+
+	bool write(const std::string& filename, const Calibration& calibration);
+	// False (with a message) if the file is missing, from another version or corrupt
+	bool load(const std::string& filename, Calibration& calibration);
+
+	// Builds a calibration from the text files the calibration modes write: one "x y" line per
+	// sticker point, and HSV ranges (the default ranges if the range file is missing)
+	bool compile(const std::string& position_file_1, const std::string& position_file_2,
+				 const std::string& color_range_file, const Calibration::Camera& camera, Calibration& calibration);
+
+	// True if the bundle is missing or older than any of the given source files
+	bool stale(const std::string& filename, const std::vector<std::string>& sources);
+}
+
+// Watches a bundle file with inotify and loads every new version on its own thread, handing it to
+// the callback. Detection never waits for a reload; the callback only publishes the result.
+class CalibrationWatcher {
+public:
+	using Callback = std::function<void(std::shared_ptr<const Calibration>)>;
+
+	// Throws if the bundle's directory cannot be watched
+	CalibrationWatcher(std::string filename, Callback on_change);
+	~CalibrationWatcher();
+
+	CalibrationWatcher(const CalibrationWatcher&) = delete;
+	CalibrationWatcher& operator=(const CalibrationWatcher&) = delete;
+
+private:
+	void watchLoop();
+
+	std::string filename;
+	Callback on_change;
+	int inotify_fd = -1;
+	int stop_fd = -1; // eventfd that wakes the watch thread for shutdown
+	std::thread thread;
+};
@@ -0,0 +1,255 @@
+#include "color_lut.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// Runs fn(h_begin, h_end) over contiguous hue slices on all cores
+template <typename Fn>
+static void forHueSlices(Fn fn) {
+	const int workers = static_cast<int>(std::clamp(std::thread::hardware_concurrency(), 1u, 180u));
+	std::vector<std::thread> threads;
+	for (int w = 1; w < workers; w++) {
+		threads.emplace_back(fn, 180 * w / workers, 180 * (w + 1) / workers);
+	}
+	fn(0, 180 / workers);
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+ColorClassifier::ColorClassifier() {
+	clear();
+}
+
+void ColorClassifier::clear() {
+	h_bits.fill(0);
+	s_bits.fill(0);
+	v_bits.fill(0);
+	color_by_width.fill('N');
+	rules.clear();
+}
+
+bool ColorClassifier::addRule(const Rule& rule) {
+	if (rules.size() >= kMaxRules) {
+		std::cerr << "Warning: Color classifier supports at most " << kMaxRules << " ranges, ignoring "
+				  << rule.color << " range" << std::endl;
+		return false;
+	}
+
+	const int bit = static_cast<int>(rules.size());
+	rules.push_back(rule);
+	setBits(bit, rule);
+	return true;
+}
+
+bool ColorClassifier::setRule(size_t index, const Rule& rule) {
+	if (index >= rules.size()) return false;
+	const int bit = static_cast<int>(index);
+	clearBits(bit);
+	rules[index] = rule;
+	setBits(bit, rule);
+	return true;
+}
+
+void ColorClassifier::removeLastRule() {
+	if (rules.empty()) return;
+	clearBits(static_cast<int>(rules.size()) - 1);
+	rules.pop_back();
+}
+
+void ColorClassifier::setBits(int bit, const Rule& rule) {
+	const uint32_t flag = 1u << bit;
+
+	for (int h = 0; h < 180; ++h) {
+		bool h_in_range = rule.hue_wrap ? (h >= rule.h_min || h <= rule.h_max)
+										  : (h >= rule.h_min && h <= rule.h_max);
+		if (h_in_range) h_bits[h] |= flag;
+	}
+	for (int s = std::max(rule.s_min, 0); s <= std::min(rule.s_max, 255); ++s) s_bits[s] |= flag;
+	for (int v = std::max(rule.v_min, 0); v <= std::min(rule.v_max, 255); ++v) v_bits[v] |= flag;
+
+	color_by_width[bit + 1] = rule.color;
+}
+
+void ColorClassifier::clearBits(int bit) {
+	const uint32_t keep = ~(1u << bit);
+	for (uint32_t& mask : h_bits) mask &= keep;
+	for (uint32_t& mask : s_bits) mask &= keep;
+	for (uint32_t& mask : v_bits) mask &= keep;
+	color_by_width[bit + 1] = 'N';
+}
+
+void ColorClassifier::loadDefaults() {
+	clear();
+	// The old init_lut() was a first-match if/else chain, so the ranges are added in reverse
+	// order to give the earlier ones higher priority.
+	addRule({'B', 100, 125, 80, 255, 80, 255, false});
+	addRule({'G', 45, 75, 60, 255, 60, 255, false});
+	addRule({'Y', 21, 35, 80, 255, 120, 255, false});
+	addRule({'O', 9, 20, 100, 255, 100, 255, false});
+	addRule({'R', 172, 8, 80, 255, 80, 255, true});
+	addRule({'W', 0, 179, 0, 50, 150, 255, false});
+}
+
+bool ColorClassifier::restore(const std::vector<Rule>& restored_rules, const std::array<uint32_t, 180>& hue_bits,
+							  const std::array<uint32_t, 256>& sat_bits, const std::array<uint32_t, 256>& val_bits,
+							  const std::array<char, kMaxRules + 1>& colors) {
+	if (restored_rules.size() > kMaxRules) return false;
+	// No mask may name a range that does not exist
+	const uint32_t valid = restored_rules.size() == kMaxRules ? ~0u : (1u << restored_rules.size()) - 1;
+	for (const auto* bits : {&sat_bits, &val_bits}) {
+		for (uint32_t mask : *bits) {
+			if (mask & ~valid) return false;
+		}
+	}
+	for (uint32_t mask : hue_bits) {
+		if (mask & ~valid) return false;
+	}
+
+	h_bits = hue_bits;
+	s_bits = sat_bits;
+	v_bits = val_bits;
+	color_by_width = colors;
+	rules = restored_rules;
+	return true;
+}
+
+bool ColorClassifier::parseRule(const std::string& line, Rule& rule) {
+	std::stringstream ss(line);
+	std::string color_str;
+	if (!(ss >> color_str >> rule.h_min >> rule.h_max >> rule.s_min >> rule.s_max >> rule.v_min >> rule.v_max)) {
+		return false;
+	}
+
+	// Red wraparound range (170-179) - treat as regular red
+	rule.color = color_str == "R2" ? 'R' : color_str[0];
+	// Handle red's hue wrap-around where h_min > h_max
+	rule.hue_wrap = rule.color == 'R' && rule.h_min > rule.h_max;
+	return true;
+}
+
+bool ColorClassifier::loadFromFile(const std::string& filename) {
+	std::ifstream infile(filename);
+	if (!infile.is_open()) {
+		return false;
+	}
+
+	clear();
+	std::string line;
+	Rule rule{};
+	while (std::getline(infile, line)) {
+		if (parseRule(line, rule)) {
+			addRule(rule);
+		}
+	}
+	return true;
+}
+
+void ColorClassifier::buildReferenceDefaultTable(std::vector<char>& table) {
+	table.assign(kColorTableSize, 'N');
+	forHueSlices([&table](int h_begin, int h_end) {
+		for (int h = h_begin; h < h_end; h++) {
+			for (int s = 0; s < 256; s++) {
+				for (int v = 0; v < 256; v++) {
+					char& cell = table[colorTableIndex(h, s, v)];
+					// White - very strict
+					if (s <= 50 && v >= 150) {
+						cell = 'W';
+					}
+					// Red - tighter range
+					else if (((h >= 0 && h <= 8) || (h >= 172 && h <= 179)) && s >= 80 && v >= 80) {
+						cell = 'R';
+					}
+					// Orange - non-overlapping with red
+					else if (h >= 9 && h <= 20 && s >= 100 && v >= 100) {
+						cell = 'O';
+					}
+					// Yellow - non-overlapping
+					else if (h >= 21 && h <= 35 && s >= 80 && v >= 120) {
+						cell = 'Y';
+					}
+					// Green - tighter range
+					else if (h >= 45 && h <= 75 && s >= 60 && v >= 60) {
+						cell = 'G';
+					}
+					// Blue - much tighter range to avoid overlap
+					else if (h >= 100 && h <= 125 && s >= 80 && v >= 80) {
+						cell = 'B';
+					}
+				}
+			}
+		}
+	});
+}
+
+bool ColorClassifier::buildReferenceTableFromFile(const std::string& filename, std::vector<char>& table) {
+	std::ifstream infile(filename);
+	if (!infile.is_open()) {
+		return false;
+	}
+
+	std::vector<Rule> file_rules;
+	std::string line;
+	Rule rule{};
+	while (std::getline(infile, line)) {
+		if (parseRule(line, rule)) file_rules.push_back(rule);
+	}
+
+	// Every slice applies the ranges in file order, so later ranges still overwrite earlier ones
+	table.assign(kColorTableSize, 'N');
+	forHueSlices([&table, &file_rules](int h_begin, int h_end) {
+		for (const Rule& rule : file_rules) {
+			for (int h = h_begin; h < h_end; ++h) {
+				bool h_in_range = rule.hue_wrap ? (h >= rule.h_min || h <= rule.h_max) : (h >= rule.h_min && h <= rule.h_max);
+				if (h_in_range) {
+					for (int s = std::max(rule.s_min, 0); s <= std::min(rule.s_max, 255); ++s) {
+						for (int v = std::max(rule.v_min, 0); v <= std::min(rule.v_max, 255); ++v) {
+							table[colorTableIndex(h, s, v)] = rule.color;
+						}
+					}
+				}
+			}
+		}
+	});
+	return true;
+}
+
+size_t ColorClassifier::compareAgainst(const std::vector<char>& table, int max_reported) const {
+	struct Mismatch {
+		int h, s, v;
+		char expected, actual;
+	};
+	// Per hue: the mismatch count and the first max_reported mismatches
+	std::vector<size_t> counts(180, 0);
+	std::vector<std::vector<Mismatch>> reported(180);
+	forHueSlices([&](int h_begin, int h_end) {
+		for (int h = h_begin; h < h_end; h++) {
+			for (int s = 0; s < 256; s++) {
+				for (int v = 0; v < 256; v++) {
+					char expected = table[colorTableIndex(h, s, v)];
+					char actual = classify(h, s, v);
+					if (expected != actual) {
+						if (counts[h] < static_cast<size_t>(max_reported)) reported[h].push_back({h, s, v, expected, actual});
+						counts[h]++;
+					}
+				}
+			}
+		}
+	});
+
+	size_t mismatches = 0;
+	for (int h = 0; h < 180; h++) {
+		for (const Mismatch& m : reported[h]) {
+			if (mismatches < static_cast<size_t>(max_reported)) {
+				std::cout << "  Mismatch at H=" << m.h << " S=" << m.s << " V=" << m.v << ": table=" << m.expected
+						  << " compact=" << m.actual << std::endl;
+			}
+			mismatches++;
+		}
+		mismatches += counts[h] - reported[h].size();
+	}
+	return mismatches;
+}
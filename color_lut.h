@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compact HSV color classifier.
+//
+// Every color range is an axis-aligned box in HSV space, so instead of materializing the full
+// 180x256x256 table (11.8 MB) each range gets one bit in three small per-channel masks. A pixel
+// belongs to range k when bit k is set in h_bits[h] & s_bits[s] & v_bits[v]; the highest set bit
+// wins, which reproduces the "later range overwrites earlier" behavior of the full-table fill.
+// The tables are 180 + 256 + 256 words (~2.7 KB) and stay resident in L1.
+class ColorClassifier {
+public:
+	static constexpr int kMaxRules = 32;
+
+	struct Rule {
+		char color;
+		int h_min, h_max, s_min, s_max, v_min, v_max;
+		bool hue_wrap; // h_min > h_max means [h_min, 179] + [0, h_max]
+	};
+
+	ColorClassifier();
+
+	// Removes every range; everything classifies as 'N'
+	void clear();
+
+	// Appends a range with higher priority than all ranges added before it
+	bool addRule(const Rule& rule);
+	// Changes range `index` in place, keeping its priority. Only that range's bit is rewritten in
+	// the masks (under a microsecond), so calibration can call it on every trackbar move.
+	bool setRule(size_t index, const Rule& rule);
+	// Drops the highest-priority range
+	void removeLastRule();
+
+	// Hardcoded fallback ranges (same results as the old init_lut())
+	void loadDefaults();
+
+	// range.txt format: "<color> h_min h_max s_min s_max v_min v_max", "R2" is a second red range
+	bool loadFromFile(const std::string& filename);
+
+	char classify(uint8_t h, uint8_t s, uint8_t v) const {
+		uint32_t mask = h_bits[h < 180 ? h : 179] & s_bits[s] & v_bits[v];
+		return color_by_width[std::bit_width(mask)];
+	}
+
+	const std::vector<Rule>& getRules() const { return rules; }
+
+	// Raw masks for the batched sticker kernel, which evaluates classify() many lanes at a time
+	const std::array<uint32_t, 180>& hueBits() const { return h_bits; }
+	const std::array<uint32_t, 256>& satBits() const { return s_bits; }
+	const std::array<uint32_t, 256>& valBits() const { return v_bits; }
+	char colorForWidth(int width) const { return color_by_width[width]; }
+	const std::array<char, kMaxRules + 1>& colorsByWidth() const { return color_by_width; }
+
+	// Takes over finished masks (e.g. from a calibration bundle) instead of rebuilding them from
+	// the rules. Returns false if the tables do not fit the rules.
+	bool restore(const std::vector<Rule>& rules, const std::array<uint32_t, 180>& hue_bits,
+				 const std::array<uint32_t, 256>& sat_bits, const std::array<uint32_t, 256>& val_bits,
+				 const std::array<char, kMaxRules + 1>& colors);
+
+	// Reference tables built with the original triple loops, indexed [h][s][v]. Hue slices are
+	// independent, so they are filled on all cores.
+	static void buildReferenceDefaultTable(std::vector<char>& table);
+	static bool buildReferenceTableFromFile(const std::string& filename, std::vector<char>& table);
+
+	// Compares every (h, s, v) cell against a reference table and returns the number of
+	// mismatches; hue slices are compared in parallel, the first mismatches reported in order
+	size_t compareAgainst(const std::vector<char>& table, int max_reported = 10) const;
+
+private:
+	std::array<uint32_t, 180> h_bits{};
+	std::array<uint32_t, 256> s_bits{};
+	std::array<uint32_t, 256> v_bits{};
+	// color_by_width[0] = 'N', color_by_width[k + 1] = color of rule k
+	std::array<char, kMaxRules + 1> color_by_width{};
+	std::vector<Rule> rules;
+
+	static bool parseRule(const std::string& line, Rule& rule);
+	void setBits(int bit, const Rule& rule);
+	void clearBits(int bit);
+};
+
+// Index into the reference [h][s][v] tables
+inline size_t colorTableIndex(int h, int s, int v) { return (static_cast<size_t>(h) * 256 + s) * 256 + v; }
+constexpr size_t kColorTableSize = 180 * 256 * 256;
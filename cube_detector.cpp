@@ -0,0 +1,155 @@
+#include "cube_detector.h"
+#include "trace.h"
+#include <chrono>
+#include <numeric>
+
+static double microsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+PatchDetector::PatchDetector(const std::vector<cv::Point>& points_1, const std::vector<cv::Point>& points_2,
+							 int patch_size, int patch_step, float min_confidence) :
+	points{&points_1, &points_2} {
+	for (int camera = 0; camera < 2; camera++) {
+		voters[camera].configure(patch_size, patch_step, min_confidence);
+		uncorrected[camera].configure(patch_size, patch_step, min_confidence);
+	}
+	reset();
+}
+
+void PatchDetector::reset() {
+	for (int camera = 0; camera < 2; camera++) {
+		voters[camera].reset(points[camera]->size());
+		uncorrected[camera].reset(points[camera]->size());
+	}
+}
+
+void PatchDetector::enableWhiteBalance(const ColorClassifier& reference, bool compare) {
+	white_balance = std::make_unique<WhiteBalance>(reference);
+	compare_uncorrected = compare;
+}
+
+void PatchDetector::detect(const cv::Mat& frame_1, const cv::Mat& frame_2, FaceletReading& reading) {
+	const auto start = std::chrono::steady_clock::now();
+	const cv::Mat* frames[2] = {&frame_1, &frame_2};
+
+	reading.color.fill('N');
+	reading.confidence.fill(0.0f);
+	reading.uncertain = 0;
+	reading.sample_us = 0;
+	reading.classify_us = 0;
+	reading.has_uncorrected = white_balance && compare_uncorrected;
+	reading.uncorrected.fill('N');
+	for (int camera = 0; camera < 2; camera++) {
+		PatchVoter& voter = voters[camera];
+		if (voter.size() != points[camera]->size()) {
+			voter.reset(points[camera]->size());
+		}
+		size_t lanes;
+		auto stage_start = std::chrono::steady_clock::now();
+		{
+			trace::Scope scope(trace::Stage::Sample);
+			if (white_balance) {
+				WhiteBalance::faceCenters(*points[camera], centers);
+				white_balance->update(*frames[camera], centers, gains[camera]);
+				voter.setGains(gains[camera]);
+			}
+			lanes = voter.gather(*frames[camera], *points[camera], camera + 1);
+		}
+		reading.sample_us += microsSince(stage_start);
+		stage_start = std::chrono::steady_clock::now();
+		if (lanes > 0) {
+			trace::Scope scope(trace::Stage::Classify);
+			classify(voter);
+			voter.vote();
+		}
+		reading.classify_us += microsSince(stage_start);
+
+		const size_t stickers = std::min<size_t>(voter.size(), FaceletReading::kStickersPerCamera);
+		for (size_t i = 0; i < stickers; i++) {
+			const int facelet = FaceletReading::index(camera, static_cast<int>(i));
+			reading.color[facelet] = voter.getColors()[i];
+			reading.confidence[facelet] = voter.getConfidence()[i];
+		}
+		reading.uncertain += voter.uncertainCount();
+
+		if (!reading.has_uncorrected) continue;
+		// The comparison reading is real work on this thread, so it stays inside the timing
+		PatchVoter& plain = uncorrected[camera];
+		if (plain.size() != points[camera]->size()) plain.reset(points[camera]->size());
+		stage_start = std::chrono::steady_clock::now();
+		{
+			trace::Scope scope(trace::Stage::Sample);
+			lanes = plain.gather(*frames[camera], *points[camera], camera + 1);
+		}
+		reading.sample_us += microsSince(stage_start);
+		stage_start = std::chrono::steady_clock::now();
+		if (lanes > 0) {
+			trace::Scope scope(trace::Stage::Classify);
+			classify(plain);
+			plain.vote();
+		}
+		reading.classify_us += microsSince(stage_start);
+		const size_t plain_stickers = std::min<size_t>(plain.size(), FaceletReading::kStickersPerCamera);
+		for (size_t i = 0; i < plain_stickers; i++) {
+			reading.uncorrected[FaceletReading::index(camera, static_cast<int>(i))] = plain.getColors()[i];
+		}
+	}
+
+	reading.detect_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void RgbTableDetector::classify(PatchVoter& voter) {
+	voter.classifyWith([this](int r, int g, int b) { return rgb.colorOfFace(rgb.classifyRgb(r, g, b)); });
+}
+
+EnsembleDetector::EnsembleDetector(std::vector<std::unique_ptr<CubeDetector>> members, const std::vector<int>& cpus,
+								   Accept accept) :
+	members(std::move(members)), readings(this->members.size()), accept(std::move(accept)) {
+	std::vector<DetectionWorkers::Job> jobs;
+	for (size_t i = 0; i < this->members.size(); i++) {
+		jobs.push_back([this, i] { this->members[i]->detect(*frames[0], *frames[1], readings[i]); });
+	}
+	workers = std::make_unique<DetectionWorkers>(std::move(jobs), cpus);
+}
+
+void EnsembleDetector::reset() {
+	for (auto& member : members) {
+		member->reset();
+	}
+}
+
+void EnsembleDetector::detect(const cv::Mat& frame_1, const cv::Mat& frame_2, FaceletReading& reading) {
+	const auto start = std::chrono::steady_clock::now();
+	frames[0] = &frame_1;
+	frames[1] = &frame_2;
+
+	// Every member is a few microseconds, so waiting for all of them costs nothing next to a frame
+	// interval, and their detect times differ by noise more than by algorithm. The pick is made on
+	// the readings instead: the most confident accepted one, or the most confident overall when
+	// none is accepted. On a tie the earlier member (hsv) wins.
+	workers->run();
+
+	auto total_confidence = [](const FaceletReading& r) {
+		return std::accumulate(r.confidence.begin(), r.confidence.end(), 0.0f);
+	};
+	int winner = -1;
+	bool winner_accepted = false;
+	float best = -1.0f;
+	for (size_t i = 0; i < readings.size(); i++) {
+		const bool accepted = accept && accept(readings[i]);
+		if (winner_accepted && !accepted) continue;
+		const float total = total_confidence(readings[i]);
+		if ((accepted && !winner_accepted) || total > best) {
+			best = total;
+			winner = static_cast<int>(i);
+			winner_accepted = accepted;
+		}
+	}
+
+	if (winner >= 0) {
+		reading = readings[winner];
+		last_winner = members[winner]->name();
+	}
+	reading.detect_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
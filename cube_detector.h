@@ -0,0 +1,143 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include "arduino_detection.h"
+#include "color_lut.h"
+#include "detection_workers.h"
+#include "sticker_vote.h"
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// The 54 facelets seen by the two cameras: camera 1's three faces, then camera 2's, 9 facelets
+// per face in row-major order. Colors are detected color letters (W R G O B Y, 'N' = unknown);
+// turning them into faces and picking the cube orientation is left to the pipeline. The centers
+// (index 4 of each face) are not sampled and stay 'N'.
+struct FaceletReading {
+	static constexpr int kFacelets = 54;
+	static constexpr int kStickersPerCamera = 24;
+
+	std::array<char, kFacelets> color{};
+	std::array<float, kFacelets> confidence{};
+	size_t uncertain = 0;  // stickers below the detector's confidence threshold
+	double detect_us = 0;  // time spent in detect()
+	// Parts of detect_us in patch detectors: gathering the patch pixels, and converting and
+	// classifying them, which the sticker kernel does in one fused pass
+	double sample_us = 0;
+	double classify_us = 0;
+	// With WHITE_BALANCE_STATS: what the same samples give without the correction, for comparison
+	bool has_uncorrected = false;
+	std::array<char, kFacelets> uncorrected{};
+
+	// Facelet of sticker i (cam_face * 8 + position, center skipped) of camera 0 or 1
+	static constexpr int index(int camera, int sticker) {
+		const int position = sticker % 8;
+		return camera * 27 + (sticker / 8) * 9 + (position < 4 ? position : position + 1);
+	}
+};
+
+// One detection algorithm behind a common interface, so the pipeline can run any of them (or
+// several at once) on a synchronized frame pair.
+//
+// Detectors may accumulate evidence: detect() adds one frame pair to the current reading until
+// reset() starts a new one. Both sticker point sets have 24 points per camera in the order of
+// pos_1.txt / pos_2.txt.
+class CubeDetector {
+public:
+	virtual ~CubeDetector() = default;
+
+	virtual const char* name() const = 0;
+
+	// Starts a new reading
+	virtual void reset() = 0;
+
+	// Adds one frame pair and writes the current reading into the caller's buffer
+	virtual void detect(const cv::Mat& frame_1, const cv::Mat& frame_2, FaceletReading& reading) = 0;
+};
+
+// Shared by the patch-based detectors: k x k voting around every sticker point on both cameras
+class PatchDetector : public CubeDetector {
+public:
+	PatchDetector(const std::vector<cv::Point>& points_1, const std::vector<cv::Point>& points_2, int patch_size,
+				  int patch_step, float min_confidence);
+
+	void reset() override;
+	void detect(const cv::Mat& frame_1, const cv::Mat& frame_2, FaceletReading& reading) override;
+
+	// Corrects the sampled pixels with per-frame gains from the face centers, measured against the
+	// ranges of `reference`. With `compare`, a second set of voters also reads the uncorrected
+	// samples, so every reading carries the colors detection would have seen without the
+	// correction. That doubles the sampling work and is counted in detect_us.
+	void enableWhiteBalance(const ColorClassifier& reference, bool compare);
+
+protected:
+	// Fills the voter's batch colors after gather()
+	virtual void classify(PatchVoter& voter) = 0;
+
+private:
+	const std::vector<cv::Point>* points[2];
+	PatchVoter voters[2];
+
+	std::unique_ptr<WhiteBalance> white_balance;
+	WhiteBalance::Gains gains[2]; // kept across readings, the light changes more slowly than the cube
+	bool compare_uncorrected = false;
+	PatchVoter uncorrected[2];
+	std::vector<cv::Point> centers;
+};
+
+// The HSV classifier through the batched sticker kernel
+class HsvPatchDetector : public PatchDetector {
+public:
+	HsvPatchDetector(const ColorClassifier& classifier, const std::vector<cv::Point>& points_1,
+					 const std::vector<cv::Point>& points_2, int patch_size, int patch_step, float min_confidence) :
+		PatchDetector(points_1, points_2, patch_size, patch_step, min_confidence), classifier(classifier) {}
+
+	const char* name() const override { return "hsv"; }
+
+protected:
+	void classify(PatchVoter& voter) override { voter.classify(classifier); }
+
+private:
+	const ColorClassifier& classifier;
+};
+
+// ArduinoStyleDetection's nearest-reference RGB rules through its quantized table, on the same
+// sticker points as the HSV detector
+class RgbTableDetector : public PatchDetector {
+public:
+	RgbTableDetector(const ArduinoStyleDetection& rgb, const std::vector<cv::Point>& points_1,
+					 const std::vector<cv::Point>& points_2, int patch_size, int patch_step, float min_confidence) :
+		PatchDetector(points_1, points_2, patch_size, patch_step, min_confidence), rgb(rgb) {}
+
+	const char* name() const override { return "rgb"; }
+
+protected:
+	void classify(PatchVoter& voter) override;
+
+private:
+	const ArduinoStyleDetection& rgb;
+};
+
+// Runs several detectors concurrently, each on its own persistent worker, and keeps the most
+// confident reading among those accepted; when none is accepted, the most confident one.
+class EnsembleDetector : public CubeDetector {
+public:
+	using Accept = std::function<bool(const FaceletReading&)>;
+
+	EnsembleDetector(std::vector<std::unique_ptr<CubeDetector>> members, const std::vector<int>& cpus, Accept accept);
+
+	const char* name() const override { return "ensemble"; }
+	void reset() override;
+	void detect(const cv::Mat& frame_1, const cv::Mat& frame_2, FaceletReading& reading) override;
+
+	// Member whose reading was used last
+	const char* lastWinner() const { return last_winner; }
+
+private:
+	std::vector<std::unique_ptr<CubeDetector>> members;
+	std::vector<FaceletReading> readings;
+	std::unique_ptr<DetectionWorkers> workers;
+	Accept accept;
+	const cv::Mat* frames[2] = {nullptr, nullptr};
+	const char* last_winner = "";
+};
@@ -0,0 +1,146 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Facelet geometry of the 54-character face string used by rob-twophase (faces in U R F D L B
+// order, 9 facelets each in row-major order, the same layout as Kociemba's solver).
+
+namespace cube_geometry {
+	constexpr char kFaces[6] = {'U', 'R', 'F', 'D', 'L', 'B'};
+
+	// Facelet indices of each corner (URF, UFL, ULB, UBR, DFR, DLF, DBL, DRB), U/D facelet first
+	constexpr int kCornerFacelets[8][3] = {
+		{8, 9, 20}, {6, 18, 38}, {0, 36, 47}, {2, 45, 11},
+		{29, 26, 15}, {27, 44, 24}, {33, 53, 42}, {35, 17, 51}
+	};
+	constexpr char kCornerColors[8][3] = {
+		{'U', 'R', 'F'}, {'U', 'F', 'L'}, {'U', 'L', 'B'}, {'U', 'B', 'R'},
+		{'D', 'F', 'R'}, {'D', 'L', 'F'}, {'D', 'B', 'L'}, {'D', 'R', 'B'}
+	};
+
+	// Facelet indices of each edge (UR, UF, UL, UB, DR, DF, DL, DB, FR, FL, BL, BR)
+	constexpr int kEdgeFacelets[12][2] = {
+		{5, 10}, {7, 19}, {3, 37}, {1, 46}, {32, 16}, {28, 25},
+		{30, 43}, {34, 52}, {23, 12}, {21, 41}, {50, 39}, {48, 14}
+	};
+	constexpr char kEdgeColors[12][2] = {
+		{'U', 'R'}, {'U', 'F'}, {'U', 'L'}, {'U', 'B'}, {'D', 'R'}, {'D', 'F'},
+		{'D', 'L'}, {'D', 'B'}, {'F', 'R'}, {'F', 'L'}, {'B', 'L'}, {'B', 'R'}
+	};
+
+	constexpr int faceIndex(char face) {
+		for (int i = 0; i < 6; i++) {
+			if (kFaces[i] == face) return i;
+		}
+		return -1;
+	}
+
+	// Corner id for every ordered facelet triplet (f0 * 36 + f1 * 6 + f2), accepting all three
+	// twists of a corner; -1 for triplets that are no corner (e.g. opposite faces, wrong handedness)
+	inline constexpr std::array<int8_t, 216> kCornerByTriplet = [] {
+		std::array<int8_t, 216> t{};
+		t.fill(-1);
+		for (int c = 0; c < 8; c++) {
+			for (int twist = 0; twist < 3; twist++) {
+				const int a = faceIndex(kCornerColors[c][twist]);
+				const int b = faceIndex(kCornerColors[c][(twist + 1) % 3]);
+				const int d = faceIndex(kCornerColors[c][(twist + 2) % 3]);
+				t[a * 36 + b * 6 + d] = static_cast<int8_t>(c);
+			}
+		}
+		return t;
+	}();
+
+	// Edge id for every ordered facelet pair (f0 * 6 + f1), both flips accepted
+	inline constexpr std::array<int8_t, 36> kEdgeByPair = [] {
+		std::array<int8_t, 36> t{};
+		t.fill(-1);
+		for (int e = 0; e < 12; e++) {
+			const int a = faceIndex(kEdgeColors[e][0]);
+			const int b = faceIndex(kEdgeColors[e][1]);
+			t[a * 6 + b] = static_cast<int8_t>(e);
+			t[b * 6 + a] = static_cast<int8_t>(e);
+		}
+		return t;
+	}();
+
+	enum class CubeError {
+		None,
+		UnknownFacelet,  // a facelet that is no face color
+		InvalidCorner,   // colors that no corner piece has (e.g. opposite faces)
+		DuplicateCorner,
+		InvalidEdge,
+		DuplicateEdge,
+		Twist,           // corner twists do not sum to 0 mod 3
+		Flip,            // odd number of flipped edges
+		Parity           // corner and edge permutations differ in parity
+	};
+
+	inline const char* cubeErrorName(CubeError error) {
+		switch (error) {
+			case CubeError::None: return "valid";
+			case CubeError::UnknownFacelet: return "unknown facelet";
+			case CubeError::InvalidCorner: return "impossible corner";
+			case CubeError::DuplicateCorner: return "duplicate corner";
+			case CubeError::InvalidEdge: return "impossible edge";
+			case CubeError::DuplicateEdge: return "duplicate edge";
+			case CubeError::Twist: return "corner twist";
+			case CubeError::Flip: return "edge flip";
+			case CubeError::Parity: return "permutation parity";
+		}
+		return "?";
+	}
+
+	// Everything cubie::check verifies, straight from the facelets and without building a cubie:
+	// every position holds an existing piece, no piece appears twice, the corner twists sum to
+	// 0 mod 3, the edge flips are even and both permutations have the same parity
+	inline CubeError checkFacelets(const char* facelets) {
+		int corner_ids[8];
+		int twist = 0;
+		uint32_t corners_seen = 0;
+		for (int p = 0; p < 8; p++) {
+			const int* corner = kCornerFacelets[p];
+			const int a = faceIndex(facelets[corner[0]]);
+			const int b = faceIndex(facelets[corner[1]]);
+			const int d = faceIndex(facelets[corner[2]]);
+			if (a < 0 || b < 0 || d < 0) return CubeError::UnknownFacelet;
+			const int id = kCornerByTriplet[a * 36 + b * 6 + d];
+			if (id < 0) return CubeError::InvalidCorner;
+			if (corners_seen & (1u << id)) return CubeError::DuplicateCorner;
+			corners_seen |= 1u << id;
+			corner_ids[p] = id;
+			// Twist = which of the position's facelets shows the piece's U/D color (U = 0, D = 3)
+			twist += (b == 0 || b == 3) ? 1 : (d == 0 || d == 3) ? 2 : 0;
+		}
+
+		int edge_ids[12];
+		int flip = 0;
+		uint32_t edges_seen = 0;
+		for (int p = 0; p < 12; p++) {
+			const int* edge = kEdgeFacelets[p];
+			const int a = faceIndex(facelets[edge[0]]);
+			const int b = faceIndex(facelets[edge[1]]);
+			if (a < 0 || b < 0) return CubeError::UnknownFacelet;
+			const int id = kEdgeByPair[a * 6 + b];
+			if (id < 0) return CubeError::InvalidEdge;
+			if (edges_seen & (1u << id)) return CubeError::DuplicateEdge;
+			edges_seen |= 1u << id;
+			edge_ids[p] = id;
+			flip += kFaces[a] != kEdgeColors[id][0];
+		}
+
+		if (twist % 3 != 0) return CubeError::Twist;
+		if (flip % 2 != 0) return CubeError::Flip;
+
+		int inversions = 0;
+		for (int i = 0; i < 8; i++) {
+			for (int j = i + 1; j < 8; j++) inversions += corner_ids[i] > corner_ids[j];
+		}
+		for (int i = 0; i < 12; i++) {
+			for (int j = i + 1; j < 12; j++) inversions += edge_ids[i] > edge_ids[j];
+		}
+		return inversions % 2 == 0 ? CubeError::None : CubeError::Parity;
+	}
+
+	inline bool cubeValid(const char* facelets) { return checkFacelets(facelets) == CubeError::None; }
+}
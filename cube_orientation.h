@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Structure to represent cube orientation mapping
+struct CubeOrientation {
+	// Maps camera positions to face characters
+	// cam1_faces[0] = Up face, cam1_faces[1] = Right face, cam1_faces[2] = Front face
+	// cam2_faces[0] = Down face, cam2_faces[1] = Left face, cam2_faces[2] = Back face
+	char cam1_faces[3];
+	char cam2_faces[3];
+
+	constexpr CubeOrientation(char up, char right, char front, char down, char left, char back) :
+		cam1_faces{up, right, front}, cam2_faces{down, left, back} {}
+};
+
+// The 24 standard cube orientations (6 faces × 4 rotations each)
+// Using standard cube notation: U=Up, R=Right, F=Front, D=Down, L=Left, B=Back
+inline constexpr std::array<CubeOrientation, 24> kCubeOrientations = {{
+	// White (U) up orientations
+	{'U', 'R', 'F', 'D', 'L', 'B'}, // Standard
+	{'U', 'F', 'L', 'D', 'B', 'R'}, // 90° rotation
+	{'U', 'L', 'B', 'D', 'R', 'F'}, // 180° rotation
+	{'U', 'B', 'R', 'D', 'F', 'L'}, // 270° rotation
+
+	// Yellow (D) up orientations
+	{'D', 'R', 'B', 'U', 'L', 'F'},
+	{'D', 'B', 'L', 'U', 'F', 'R'},
+	{'D', 'L', 'F', 'U', 'R', 'B'},
+	{'D', 'F', 'R', 'U', 'B', 'L'},
+
+	// Red (R) up orientations
+	{'R', 'U', 'F', 'L', 'B', 'D'},
+	{'R', 'F', 'D', 'L', 'U', 'B'},
+	{'R', 'D', 'B', 'L', 'F', 'U'},
+	{'R', 'B', 'U', 'L', 'D', 'F'},
+
+	// Orange (L) up orientations
+	{'L', 'U', 'B', 'R', 'F', 'D'},
+	{'L', 'B', 'D', 'R', 'U', 'F'},
+	{'L', 'D', 'F', 'R', 'B', 'U'},
+	{'L', 'F', 'U', 'R', 'D', 'B'},
+
+	// Green (F) up orientations
+	{'F', 'U', 'R', 'B', 'L', 'D'},
+	{'F', 'R', 'D', 'B', 'U', 'L'},
+	{'F', 'D', 'L', 'B', 'R', 'U'},
+	{'F', 'L', 'U', 'B', 'D', 'R'},
+
+	// Blue (B) up orientations
+	{'B', 'U', 'L', 'F', 'R', 'D'},
+	{'B', 'L', 'D', 'F', 'U', 'R'},
+	{'B', 'D', 'R', 'F', 'L', 'U'},
+	{'B', 'R', 'U', 'F', 'D', 'L'},
+}};
+
+// First facelet of each face in the face string: U(0-8), R(9-17), F(18-26), D(27-35), L(36-44), B(45-53)
+constexpr int faceOffset(char face) {
+	switch (face) {
+		case 'U': return 0;
+		case 'R': return 9;
+		case 'F': return 18;
+		case 'D': return 27;
+		case 'L': return 36;
+		case 'B': return 45;
+		default: return -1;
+	}
+}
+
+// Facelet (in the 54-character face string) of each of the 48 detected stickers for one
+// orientation: entries 0-23 are camera 1 ([0-7] face0, [8-15] face1, [16-23] face2), 24-47 camera 2
+constexpr std::array<uint8_t, 48> faceletMap(const CubeOrientation& orientation) {
+	constexpr int kNonCenter[8] = {0, 1, 2, 3, 5, 6, 7, 8}; // skip center at 4
+	std::array<uint8_t, 48> map{};
+	for (int cam_face = 0; cam_face < 3; cam_face++) {
+		for (int i = 0; i < 8; i++) {
+			map[cam_face * 8 + i] = static_cast<uint8_t>(faceOffset(orientation.cam1_faces[cam_face]) + kNonCenter[i]);
+			map[24 + cam_face * 8 + i] =
+					static_cast<uint8_t>(faceOffset(orientation.cam2_faces[cam_face]) + kNonCenter[i]);
+		}
+	}
+	return map;
+}
+
+inline constexpr std::array<std::array<uint8_t, 48>, 24> kFaceletMaps = [] {
+	std::array<std::array<uint8_t, 48>, 24> maps{};
+	for (size_t o = 0; o < kCubeOrientations.size(); o++) {
+		maps[o] = faceletMap(kCubeOrientations[o]);
+	}
+	return maps;
+}();
+
+// Every map must cover all 48 non-center facelets exactly once, so no output entry is left stale
+static_assert([] {
+	for (const auto& map : kFaceletMaps) {
+		uint64_t seen = 0;
+		for (uint8_t facelet : map) {
+			if (facelet % 9 == 4 || (seen >> facelet) & 1) return false;
+			seen |= uint64_t{1} << facelet;
+		}
+	}
+	return true;
+}(), "orientation facelet maps must be permutations of the non-center facelets");
@@ -0,0 +1,185 @@
+#include "cube_repair.h"
+#include "cube_geometry.h"
+#include <algorithm>
+
+using namespace cube_geometry;
+
+namespace {
+	constexpr int kCornerPositions = 8;
+	constexpr int kPositions = 8 + 12;
+	constexpr float kTieEpsilon = 1e-4f;
+
+	// One way to fill a position: a piece in one orientation and what it costs in rewritten facelets
+	struct Placement {
+		int8_t piece;
+		int8_t ori;
+		uint8_t changes;
+		float cost;
+		char colors[3];
+	};
+
+	struct Search {
+		explicit Search(const std::array<char, 54>& facelets) : facelets(facelets) {}
+
+		const std::array<char, 54>& facelets;
+		std::array<std::vector<Placement>, kPositions> options;
+		std::array<int, kPositions> order{};
+		int max_changes = 0;
+
+		std::array<const Placement*, kPositions> current{};
+		std::array<const Placement*, kPositions> best{};
+		int best_changes = 0;
+		float best_cost = 0;
+		int best_count = 0; // assignments tied with the best one
+
+		const int* faceletsOf(int position) const {
+			return position < kCornerPositions ? kCornerFacelets[position] : kEdgeFacelets[position - kCornerPositions];
+		}
+
+		// Cost of writing `colors` into `position`; false if that touches a fixed facelet
+		bool price(int position, const char* colors, int n, uint64_t changeable, const std::array<float, 54>& confidence,
+				   Placement& placement) const {
+			placement.changes = 0;
+			placement.cost = 0;
+			const int* indices = faceletsOf(position);
+			for (int k = 0; k < n; k++) {
+				placement.colors[k] = colors[k];
+				if (facelets[indices[k]] == colors[k]) continue;
+				if (!(changeable >> indices[k] & 1)) return false;
+				placement.changes++;
+				placement.cost += confidence[indices[k]];
+			}
+			return true;
+		}
+
+		void build(uint64_t changeable, const std::array<float, 54>& confidence) {
+			for (int position = 0; position < kCornerPositions; position++) {
+				for (int c = 0; c < 8; c++) {
+					for (int ori = 0; ori < 3; ori++) {
+						// The U/D color sits at index `ori` of the position's facelets
+						char colors[3];
+						for (int k = 0; k < 3; k++) colors[k] = kCornerColors[c][(k - ori + 3) % 3];
+						Placement placement{static_cast<int8_t>(c), static_cast<int8_t>(ori), 0, 0.0f, {}};
+						if (price(position, colors, 3, changeable, confidence, placement)) {
+							options[position].push_back(placement);
+						}
+					}
+				}
+			}
+			for (int position = kCornerPositions; position < kPositions; position++) {
+				for (int e = 0; e < 12; e++) {
+					for (int ori = 0; ori < 2; ori++) {
+						const char colors[2] = {kEdgeColors[e][ori], kEdgeColors[e][1 - ori]};
+						Placement placement{static_cast<int8_t>(e), static_cast<int8_t>(ori), 0, 0.0f, {}};
+						if (price(position, colors, 2, changeable, confidence, placement)) {
+							options[position].push_back(placement);
+						}
+					}
+				}
+			}
+
+			// Positions with the fewest choices first: fixed pieces claim their ids before any branching
+			for (int i = 0; i < kPositions; i++) order[i] = i;
+			std::sort(order.begin(), order.end(), [&](int a, int b) { return options[a].size() < options[b].size(); });
+		}
+
+		static bool oddPermutation(const std::array<const Placement*, kPositions>& assignment, int first, int n) {
+			int inversions = 0;
+			for (int i = 0; i < n; i++) {
+				for (int j = i + 1; j < n; j++) {
+					inversions += assignment[first + i]->piece > assignment[first + j]->piece;
+				}
+			}
+			return inversions & 1;
+		}
+
+		void leaf(int changes, float cost) {
+			if (oddPermutation(current, 0, kCornerPositions) != oddPermutation(current, kCornerPositions, 12)) return;
+
+			if (best_count == 0 || changes < best_changes || (changes == best_changes && cost < best_cost - kTieEpsilon)) {
+				best = current;
+				best_changes = changes;
+				best_cost = cost;
+				best_count = 1;
+			} else if (changes == best_changes && cost <= best_cost + kTieEpsilon) {
+				best_count++;
+			}
+		}
+
+		void run(int depth, uint32_t corners_used, uint32_t edges_used, int twist, int flip, int changes, float cost) {
+			if (depth == kPositions) {
+				if (twist % 3 == 0 && flip % 2 == 0) leaf(changes, cost);
+				return;
+			}
+
+			const int position = order[depth];
+			const bool corner = position < kCornerPositions;
+			for (const Placement& placement : options[position]) {
+				const int total = changes + placement.changes;
+				// Stop at the budget, and at anything already worse than the best repair found
+				if (total > max_changes) continue;
+				if (best_count > 0 && (total > best_changes ||
+									   (total == best_changes && cost + placement.cost > best_cost + kTieEpsilon))) {
+					continue;
+				}
+
+				const uint32_t bit = 1u << placement.piece;
+				if ((corner ? corners_used : edges_used) & bit) continue;
+
+				current[position] = &placement;
+				if (corner) {
+					run(depth + 1, corners_used | bit, edges_used, twist + placement.ori, flip, total, cost + placement.cost);
+				} else {
+					run(depth + 1, corners_used, edges_used | bit, twist, flip + placement.ori, total, cost + placement.cost);
+				}
+			}
+		}
+	};
+}
+
+namespace cube_repair {
+	Result repair(std::array<char, 54>& facelets, uint64_t changeable, const std::array<float, 54>& confidence,
+				  int max_changes) {
+		Result result;
+
+		// Unknown facelets have to be rewritten, so they alone can exceed the budget
+		int unknown = 0;
+		for (int i = 0; i < 54; i++) {
+			if (faceIndex(facelets[i]) < 0) {
+				if (!(changeable >> i & 1)) return result;
+				unknown++;
+			}
+		}
+		if (unknown > max_changes) return result;
+
+		Search search(facelets);
+		search.max_changes = max_changes;
+		search.build(changeable, confidence);
+		for (const auto& options : search.options) {
+			if (options.empty()) return result; // some position cannot hold any real piece
+		}
+
+		search.run(0, 0, 0, 0, 0, 0, 0.0f);
+		if (search.best_count == 0) return result;
+		result.changes = search.best_changes;
+		result.cost = search.best_cost;
+		if (search.best_count > 1) {
+			result.ambiguous = true;
+			return result;
+		}
+
+		result.repaired = true;
+		for (int position = 0; position < kPositions; position++) {
+			const int* indices = search.faceletsOf(position);
+			const int n = position < kCornerPositions ? 3 : 2;
+			for (int k = 0; k < n; k++) {
+				const char color = search.best[position]->colors[k];
+				if (facelets[indices[k]] != color) {
+					facelets[indices[k]] = color;
+					result.changed.push_back(static_cast<uint8_t>(indices[k]));
+				}
+			}
+		}
+		return result;
+	}
+}
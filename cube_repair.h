@@ -0,0 +1,29 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Piece-constrained repair of a few doubtful facelets in a 54-character face string.
+//
+// Every corner and edge position is filled with one of the real pieces in one of its
+// orientations, rewriting only facelets marked as changeable. A repair is accepted when every
+// piece appears exactly once, the corner twists sum to 0 mod 3, the edge flips are even and the
+// corner and edge permutations have the same parity, i.e. when cubie::check would accept it.
+// Among all such assignments the one with the fewest rewritten facelets wins, ties broken by the
+// lowest total confidence of the rewritten facelets. If two different repairs remain equally
+// good the state is left alone and reported as ambiguous; guessing would only hand the solver
+// a wrong cube.
+namespace cube_repair {
+	struct Result {
+		bool repaired = false;  // a valid cube was found within the change budget (possibly unchanged)
+		bool ambiguous = false; // more than one equally cheap repair, state left unchanged
+		int changes = 0;               // also set for ambiguous results
+		float cost = 0;                // summed confidence of the rewritten facelets
+		std::vector<uint8_t> changed;  // rewritten facelet indices
+	};
+
+	// facelets: face characters (U R F D L B), anything else counts as unknown and must be rewritten.
+	// Bit i of `changeable` allows facelet i to be rewritten; confidence[i] is the cost of doing so.
+	Result repair(std::array<char, 54>& facelets, uint64_t changeable, const std::array<float, 54>& confidence,
+				  int max_changes);
+}
@@ -0,0 +1,213 @@
+#include "deadline_solve.h"
+#include "move.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+// Weight of the newest search in the overshoot average
+constexpr double kOvershootWeight = 0.2;
+
+double msSince(DeadlineSolve::Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(DeadlineSolve::Clock::now() - start).count();
+}
+
+} // namespace
+
+DeadlineSolve::DeadlineSolve(Station& station, SolverService& solver, const Settings& settings) :
+	station(station),
+	solver(solver),
+	settings(settings) {}
+
+void DeadlineSolve::prepare() {
+	// A guess at what detection leaves; the runs bring up the engines they actually need
+	solver.prepareTimeLimit(settings.deadline_ms / 2);
+}
+
+DeadlineSolve::Report DeadlineSolve::run(Clock::time_point trigger) {
+	Report report;
+	const auto deadline = trigger + std::chrono::milliseconds(settings.deadline_ms);
+	const auto cutoff =
+			deadline - std::chrono::microseconds(static_cast<int64_t>((settings.solve_reserve_ms + overshoot_ms) * 1000));
+
+	// 1. Frames until the state is a cube or the solver's reserve is reached
+	StateAccumulator accumulator = station.makeAccumulator();
+	bool repaired = false;
+	// As in Station::accumulate(), every reading after the first waits for a new pair
+	for (bool next = false;; next = true) {
+		const DetectionWorkers::Timing timing = station.detect(false, next);
+		report.frames++;
+		report.detect_ms += timing.slowest_job_ms;
+		report.capture_ms += timing.dispatch_to_result_ms - timing.slowest_job_ms;
+
+		const auto absorb_start = Clock::now();
+		report.valid = station.absorb(accumulator, false, repaired);
+		report.accumulate_ms += msSince(absorb_start);
+		if (report.valid || Clock::now() >= cutoff) break;
+	}
+	station.stats().timeouts += !report.valid;
+
+	std::vector<OrientationCandidate> candidates;
+	if (report.valid) {
+		const auto orient_start = Clock::now();
+		station.findCandidates(candidates, false);
+		report.orient_ms = msSince(orient_start);
+	}
+	if (candidates.empty()) {
+		report.total_ms = msSince(trigger);
+		record(report);
+		return report;
+	}
+
+	// 2. The rest of the budget goes to the solver. Its one engine searches the candidates one
+	// after the other, so they split the budget; a candidate whose share would drop below the
+	// smallest limit is left out.
+	const auto solve_start = Clock::now();
+	const double remaining_ms = std::chrono::duration<double, std::milli>(deadline - solve_start).count();
+	size_t count = candidates.size();
+	while (count > 1 && remaining_ms / count - overshoot_ms < 1) count--;
+	report.candidates = static_cast<int>(count);
+	report.time_limit_ms = solver.timeLimitFor(static_cast<int>(remaining_ms / count - overshoot_ms));
+
+	auto cancel = std::make_shared<std::atomic<bool>>(false);
+	std::vector<std::future<SolverService::Result>> pending;
+	for (size_t i = 0; i < count; i++) {
+		pending.push_back(solver.submit(candidates[i].cube, cancel, report.time_limit_ms));
+	}
+
+	SolverService::Result best;
+	auto consider = [&](SolverService::Result result) {
+		if (!result.cached && !result.cancelled) {
+			const double overshoot = std::max(0.0, result.search_ms - result.time_limit_ms);
+			overshoot_ms += kOvershootWeight * (overshoot - overshoot_ms);
+		}
+		if (result.solved && (!report.solved || result.moves.size() < best.moves.size())) {
+			best = std::move(result);
+			report.solved = true;
+		}
+	};
+
+	size_t next = 0;
+	for (; next < pending.size(); next++) {
+		if (pending[next].wait_until(deadline) != std::future_status::ready) break;
+		consider(pending[next].get());
+	}
+	// Nothing by the deadline: the first solution that comes is still better than none
+	for (; next < pending.size() && !report.solved; next++) {
+		consider(pending[next].get());
+	}
+	report.solve_ms = msSince(solve_start);
+	report.total_ms = msSince(trigger);
+	report.met = report.solved && report.total_ms <= settings.deadline_ms;
+	report.cached = best.cached;
+	report.moves = std::move(best.moves);
+
+	// Searches that have not started are no longer needed; the one running is waited for, so the
+	// next run does not queue behind it
+	cancel->store(true, std::memory_order_release);
+	for (; next < pending.size(); next++) {
+		consider(pending[next].get());
+	}
+
+	record(report);
+	return report;
+}
+
+void DeadlineSolve::record(const Report& report) {
+	stats.triggers++;
+	if (report.met) {
+		stats.met++;
+	} else {
+		stats.missed++;
+		stats.no_state += !report.valid;
+		stats.unsolved += report.valid && !report.solved;
+	}
+	stats.cache_hits += report.cached;
+	stats.capture_ms += report.capture_ms;
+	stats.detect_ms += report.detect_ms;
+	stats.accumulate_ms += report.accumulate_ms;
+	stats.orient_ms += report.orient_ms;
+	stats.solve_ms += report.solve_ms;
+	stats.total_ms += report.total_ms;
+	stats.max_total_ms = std::max(stats.max_total_ms, report.total_ms);
+
+	Station::Stats& station_stats = station.stats();
+	if (report.solved) {
+		station_stats.solved++;
+		station_stats.solve_ms += report.solve_ms;
+	} else if (report.valid) {
+		station_stats.solve_failures++;
+	}
+}
+
+void DeadlineSolve::printReport(const Report& report) const {
+	std::ostringstream line;
+	line << std::fixed << std::setprecision(1);
+	if (report.met) {
+		line << "✓ " << report.moves.size() << " moves " << report.total_ms << " ms after the trigger (deadline "
+			 << settings.deadline_ms << " ms)";
+	} else if (report.solved) {
+		line << "⚠️  Deadline miss: " << report.total_ms << " ms > " << settings.deadline_ms << " ms";
+	} else if (!report.valid) {
+		line << "⚠️  Deadline miss: no valid cube state after " << report.frames << " frames, " << report.total_ms
+			 << " ms";
+	} else {
+		line << "⚠️  Deadline miss: no solution, " << report.total_ms << " ms";
+	}
+	std::cout << line.str() << std::endl;
+
+	// The per-stage breakdown, with the stage that took most of the time named on a miss
+	const std::pair<const char*, double> stages[] = {
+			{"capture", report.capture_ms}, {"detect", report.detect_ms}, {"accumulate", report.accumulate_ms},
+			{"orient", report.orient_ms},   {"solve", report.solve_ms}};
+	line.str("");
+	line << "   capture " << report.capture_ms << " + detect " << report.detect_ms << " ms (" << report.frames
+		 << (report.frames == 1 ? " frame)" : " frames)") << ", accumulate " << report.accumulate_ms << ", orient "
+		 << report.orient_ms << ", solve " << report.solve_ms << " ms";
+	if (report.cached) {
+		line << " (solution cache hit)";
+	} else if (report.candidates > 0) {
+		line << " (" << report.candidates << " x " << report.time_limit_ms << " ms limit)";
+	}
+	if (!report.met) {
+		const auto slowest = std::max_element(std::begin(stages), std::end(stages),
+											  [](const auto& a, const auto& b) { return a.second < b.second; });
+		line << "; most in " << slowest->first;
+	}
+	std::cout << line.str() << std::endl;
+
+	if (report.solved) {
+		std::cout << "📋 Solution:";
+		for (int move : report.moves) {
+			std::cout << " " << move::names[move];
+		}
+		std::cout << std::endl;
+	}
+}
+
+void DeadlineSolve::printStats() const {
+	const double triggers = stats.triggers > 0 ? static_cast<double>(stats.triggers) : 1.0;
+	std::ostringstream line;
+	line << std::fixed << std::setprecision(1);
+	line << "Deadline " << settings.deadline_ms << " ms: " << stats.triggers << " triggers, " << stats.met << " met ("
+		 << 100.0 * stats.met / triggers << "%), " << stats.missed << " missed (" << stats.no_state
+		 << " without valid state, " << stats.unsolved << " unsolved), " << stats.cache_hits << " cache hits";
+	std::cout << line.str() << std::endl;
+	if (stats.triggers == 0) return;
+
+	line.str("");
+	line << "   Mean: capture " << stats.capture_ms / triggers << ", detect " << stats.detect_ms / triggers
+		 << ", accumulate " << stats.accumulate_ms / triggers << ", orient " << stats.orient_ms / triggers
+		 << ", solve " << stats.solve_ms / triggers << ", total " << stats.total_ms / triggers << " ms (max "
+		 << stats.max_total_ms << " ms)";
+	std::cout << line.str() << std::endl;
+	line.str("");
+	line << "   Solver overshoot estimate: " << overshoot_ms << " ms";
+	std::cout << line.str() << std::endl;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "solver_service.h"
+#include "station.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// One solve against an end-to-end deadline measured from a trigger.
+//
+// Frames are read into a fresh accumulator until the state is a valid cube or only the solver's
+// reserve is left. Whatever time remains then, minus the amount searches have recently run past
+// their limit, becomes the solver time limit: the engine for that limit (see SolverService)
+// searches the candidate orientations, which share the remaining budget. The shortest solution
+// answered by the deadline wins; if none is, the first one to arrive is taken late. Every run
+// returns its per-stage times, so a miss can be traced to the stage that used up the budget.
+class DeadlineSolve {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Settings {
+		int deadline_ms = 40;
+		int solve_reserve_ms = 3; // detection stops when only this much (plus the overshoot) is left
+	};
+
+	struct Report {
+		bool valid = false;   // a valid cube state before the detection cutoff
+		bool solved = false;
+		bool met = false;     // solved within the deadline
+		bool cached = false;  // answered by the solution cache
+		std::vector<int> moves;
+		int frames = 0;        // detect() calls
+		int candidates = 0;    // orientations searched
+		int time_limit_ms = 0; // engine limit per candidate
+		// Stage times in ms; capture is detect() minus the detector itself (capture, pairing, voting)
+		double capture_ms = 0;
+		double detect_ms = 0;
+		double accumulate_ms = 0; // accumulator, validation and piece repair
+		double orient_ms = 0;
+		double solve_ms = 0;
+		double total_ms = 0;   // trigger until the solution was taken
+	};
+
+	// Counters since construction; *_ms are sums
+	struct Stats {
+		uint64_t triggers = 0;
+		uint64_t met = 0;
+		uint64_t missed = 0;
+		uint64_t no_state = 0;   // ... of the misses, no valid state by the cutoff
+		uint64_t unsolved = 0;   // ... no solution at all
+		uint64_t cache_hits = 0;
+		double capture_ms = 0;
+		double detect_ms = 0;
+		double accumulate_ms = 0;
+		double orient_ms = 0;
+		double solve_ms = 0;
+		double total_ms = 0;
+		double max_total_ms = 0;
+	};
+
+	DeadlineSolve(Station& station, SolverService& solver, const Settings& settings);
+
+	// Starts the solver engine for half the deadline, the limit a typical run ends up with
+	void prepare();
+	// Detects and solves the cube in front of the station; `trigger` starts the deadline
+	Report run(Clock::time_point trigger);
+
+	void printReport(const Report& report) const;
+	const Stats& getStats() const { return stats; }
+	void printStats() const;
+
+private:
+	void record(const Report& report);
+
+	Station& station;
+	SolverService& solver;
+	const Settings settings;
+	double overshoot_ms = 0; // moving average of search time beyond the engine limit
+	Stats stats;
+};
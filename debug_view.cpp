@@ -0,0 +1,112 @@
+#include "debug_view.h"
+#include "trace.h"
+#include "yuyv.h"
+#include <algorithm>
+#include <iostream>
+
+DebugView::DebugView(std::vector<Window> windows, double max_fps, bool use_opencl) :
+	windows(std::move(windows)),
+	period(std::chrono::nanoseconds(static_cast<int64_t>(1e9 / std::max(max_fps, 1.0)))),
+	use_opencl(use_opencl) {
+	if (this->use_opencl && !cv::ocl::useOpenCL()) {
+		std::cerr << "Warning: OpenCL is off or has no device, debug view converts frames on the CPU" << std::endl;
+		this->use_opencl = false;
+	}
+	thread = std::thread(&DebugView::renderLoop, this);
+}
+
+DebugView::~DebugView() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void DebugView::show(const cv::Mat& frame_1, const cv::Mat& frame_2, Overlay overlay) {
+	bool replaced;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		replaced = has_pending;
+		// Only the Mat headers are copied; the pixels are shared with the caller
+		pending[0] = frame_1;
+		pending[1] = frame_2;
+		pending_overlay = std::move(overlay);
+		has_pending = true;
+	}
+	if (replaced) skipped_pairs.fetch_add(1, std::memory_order_relaxed);
+	wake.notify_one();
+}
+
+void DebugView::printStats() const {
+	std::cout << "Debug view: " << rendered() << " frame pairs shown, " << skipped() << " skipped"
+			  << (use_opencl ? " (OpenCL)" : "") << std::endl;
+}
+
+void DebugView::toDisplay(const cv::Mat& frame, int camera, cv::Mat& display) {
+	if (!use_opencl) {
+		yuyv::toBgr(frame, display);
+		return;
+	}
+	frame.copyTo(device_frame[camera]);
+	if (yuyv::isYuyv(frame)) {
+		cv::cvtColor(device_frame[camera], device_bgr[camera], cv::COLOR_YUV2BGR_YUYV);
+		device_bgr[camera].copyTo(display);
+	} else {
+		device_frame[camera].copyTo(display);
+	}
+}
+
+void DebugView::renderLoop() {
+	trace::nameThread("debug view");
+	// HighGUI windows are only touched from this thread
+	for (const Window& window : windows) {
+		cv::namedWindow(window.name, cv::WINDOW_NORMAL);
+		cv::resizeWindow(window.name, 640, 480);
+		cv::moveWindow(window.name, window.x, window.y);
+	}
+
+	cv::Mat frames[2], displays[2];
+	Overlay overlay;
+	auto next_render = std::chrono::steady_clock::now();
+	while (true) {
+		bool render = false;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			// Until the next render slot only window events are handled; newer pairs replace older ones
+			wake.wait_until(lock, next_render, [this] { return stopping; });
+			if (stopping) break;
+			if (has_pending && std::chrono::steady_clock::now() >= next_render) {
+				frames[0] = std::move(pending[0]);
+				frames[1] = std::move(pending[1]);
+				overlay = std::move(pending_overlay);
+				has_pending = false;
+				render = true;
+			}
+		}
+
+		if (render) {
+			try {
+				for (size_t camera = 0; camera < 2 && camera < windows.size(); camera++) {
+					if (frames[camera].empty()) continue;
+					toDisplay(frames[camera], static_cast<int>(camera), displays[camera]);
+					if (overlay) overlay(displays[camera], static_cast<int>(camera));
+					cv::imshow(windows[camera].name, displays[camera]);
+				}
+				rendered_pairs.fetch_add(1, std::memory_order_relaxed);
+			} catch (const cv::Exception& e) {
+				std::cerr << "Exception during debug rendering: " << e.what() << std::endl;
+			}
+			next_render = std::chrono::steady_clock::now() + period;
+		} else {
+			// Nothing new: poll the windows again shortly rather than at the full frame period
+			next_render = std::max(next_render, std::chrono::steady_clock::now() + std::chrono::milliseconds(5));
+		}
+
+		const int key = cv::waitKey(1);
+		if (key >= 0) pressed_key.store(key & 0xFF, std::memory_order_release);
+	}
+
+	cv::destroyAllWindows();
+}
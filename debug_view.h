@@ -0,0 +1,71 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Live debug windows drawn off the capture thread.
+//
+// The capturing loop hands every frame pair to show(), which only swaps it into a latest-wins
+// slot and returns. A render thread owns the HighGUI windows and, at most `max_fps` times a
+// second, converts the newest pair to BGR, runs the caller's overlay on it and shows it; pairs
+// that arrive in between are skipped. Keys pressed in the windows are read back with key().
+//
+// With `use_opencl` (and OpenCL switched on at startup, see main()) frames are uploaded to
+// cv::UMat and the YUYV-to-BGR conversion runs through OpenCV's OpenCL kernels, leaving the CPU
+// to the detection loop; the overlays are drawn on the downloaded frame.
+class DebugView {
+public:
+	struct Window {
+		std::string name;
+		int x, y;
+	};
+
+	// Draws onto the BGR display copy of camera `camera`'s frame
+	using Overlay = std::function<void(cv::Mat& display, int camera)>;
+
+	DebugView(std::vector<Window> windows, double max_fps, bool use_opencl);
+	~DebugView();
+
+	DebugView(const DebugView&) = delete;
+	DebugView& operator=(const DebugView&) = delete;
+
+	// Never blocks. The frames must not be written to afterwards: capture into new Mats.
+	void show(const cv::Mat& frame_1, const cv::Mat& frame_2, Overlay overlay);
+
+	// Key pressed since the last call (as waitKey() & 0xFF), or -1
+	int key() { return pressed_key.exchange(-1, std::memory_order_acq_rel); }
+
+	uint64_t rendered() const { return rendered_pairs.load(std::memory_order_relaxed); }
+	uint64_t skipped() const { return skipped_pairs.load(std::memory_order_relaxed); }
+	void printStats() const;
+
+private:
+	void renderLoop();
+	void toDisplay(const cv::Mat& frame, int camera, cv::Mat& display);
+
+	std::vector<Window> windows;
+	const std::chrono::nanoseconds period;
+	bool use_opencl;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	cv::Mat pending[2];
+	Overlay pending_overlay;
+	bool has_pending = false;
+	bool stopping = false;
+
+	std::atomic<int> pressed_key{-1};
+	std::atomic<uint64_t> rendered_pairs{0};
+	std::atomic<uint64_t> skipped_pairs{0};
+
+	// Render thread only
+	cv::UMat device_frame[2], device_bgr[2];
+	std::thread thread;
+};
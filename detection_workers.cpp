@@ -0,0 +1,99 @@
+#include "detection_workers.h"
+#include "trace.h"
+#include <algorithm>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+
+// Iterations to busy-wait before sleeping on the futex; a detection round-trip is well below
+// a millisecond, so spinning briefly avoids the scheduler wake-up on back-to-back attempts.
+static constexpr int kSpinIterations = 20000;
+
+static void pinCurrentThread(int cpu) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (err != 0) {
+		std::cerr << "Warning: Could not pin detection worker to CPU " << cpu << " (error " << err << ")" << std::endl;
+	}
+}
+
+DetectionWorkers::DetectionWorkers(std::vector<Job> jobs, const std::vector<int>& cpus) : jobs(std::move(jobs)) {
+	job_ms.assign(this->jobs.size(), 0.0);
+	// Spinning only helps when the caller and every worker can be on a core at the same time
+	spin_iterations = std::thread::hardware_concurrency() > this->jobs.size() ? kSpinIterations : 0;
+	for (size_t i = 0; i < this->jobs.size(); i++) {
+		int cpu = i < cpus.size() ? cpus[i] : -1;
+		threads.emplace_back(&DetectionWorkers::workerLoop, this, i, cpu);
+	}
+}
+
+DetectionWorkers::~DetectionWorkers() {
+	stopping.store(true, std::memory_order_release);
+	generation.fetch_add(1, std::memory_order_acq_rel);
+	generation.notify_all();
+	for (auto& t : threads) {
+		t.join();
+	}
+}
+
+DetectionWorkers::Timing DetectionWorkers::run() {
+	const auto start = std::chrono::steady_clock::now();
+
+	pending.store(static_cast<int>(jobs.size()), std::memory_order_release);
+	generation.fetch_add(1, std::memory_order_acq_rel);
+	generation.notify_all();
+
+	// Wait until every worker has reported back
+	int remaining = pending.load(std::memory_order_acquire);
+	for (int spin = 0; remaining != 0 && spin < spin_iterations; spin++) {
+		remaining = pending.load(std::memory_order_acquire);
+	}
+	while (remaining != 0) {
+		pending.wait(remaining, std::memory_order_acquire);
+		remaining = pending.load(std::memory_order_acquire);
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+	Timing timing;
+	timing.dispatch_to_result_ms = std::chrono::duration<double, std::milli>(end - start).count();
+	for (double ms : job_ms) {
+		timing.slowest_job_ms = std::max(timing.slowest_job_ms, ms);
+	}
+	return timing;
+}
+
+void DetectionWorkers::workerLoop(size_t index, int cpu) {
+	if (cpu >= 0) {
+		pinCurrentThread(cpu);
+	}
+	trace::nameThread("worker " + std::to_string(index + 1));
+
+	// Generations start at 0 in the constructor; reading the live value here could skip a run()
+	// issued before this thread got scheduled.
+	uint32_t seen = 0;
+	while (true) {
+		uint32_t current = generation.load(std::memory_order_acquire);
+		for (int spin = 0; current == seen && spin < spin_iterations; spin++) {
+			current = generation.load(std::memory_order_acquire);
+		}
+		while (current == seen) {
+			generation.wait(seen, std::memory_order_acquire);
+			current = generation.load(std::memory_order_acquire);
+		}
+		seen = current;
+
+		if (stopping.load(std::memory_order_acquire)) {
+			return;
+		}
+
+		const auto job_start = std::chrono::steady_clock::now();
+		jobs[index]();
+		job_ms[index] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job_start).count();
+
+		if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			pending.notify_one();
+		}
+	}
+}
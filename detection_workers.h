@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Persistent worker pool for the per-camera detection jobs.
+//
+// Each job gets its own long-lived thread, optionally pinned to a CPU. run() publishes a new
+// generation number and the workers pick it up after a short spin, falling back to a futex wait
+// (std::atomic::wait) when idle, so no thread is created or joined on the detection path.
+class DetectionWorkers {
+public:
+	using Job = std::function<void()>;
+
+	struct Timing {
+		double dispatch_to_result_ms = 0; // from run() until the last job finished
+		double slowest_job_ms = 0;        // longest single job measured on its worker
+	};
+
+	// cpus[i] < 0 lets the kernel place worker i
+	DetectionWorkers(std::vector<Job> jobs, const std::vector<int>& cpus);
+	~DetectionWorkers();
+
+	DetectionWorkers(const DetectionWorkers&) = delete;
+	DetectionWorkers& operator=(const DetectionWorkers&) = delete;
+
+	// Runs every job once, concurrently, and blocks until all of them are done
+	Timing run();
+
+	size_t size() const { return jobs.size(); }
+
+private:
+	void workerLoop(size_t index, int cpu);
+
+	std::vector<Job> jobs;
+	std::vector<std::thread> threads;
+	std::vector<double> job_ms;
+	int spin_iterations = 0;
+
+	std::atomic<uint32_t> generation{0};
+	std::atomic<int> pending{0};
+	std::atomic<bool> stopping{false};
+};
@@ -0,0 +1,249 @@
+#include "frame_recording.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+static constexpr char kMagic[8] = {'R', 'C', 'F', 'R', 'A', 'M', 'E', 'S'};
+static constexpr uint32_t kVersion = 1;
+static constexpr size_t kTimestampBytes = 2 * sizeof(int64_t);
+static constexpr size_t kRecordAlign = 64;
+
+static size_t bytesPerPixel(recording::PixelFormat format) {
+	return format == recording::PixelFormat::YUYV ? 2 : 3;
+}
+
+static int64_t steadyNowUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint8_t clampByte(int value) {
+	return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+// BT.601 limited range, the inverse of cv::COLOR_YUV2BGR_YUYV; chroma is averaged per pixel pair
+static void packYuyv(const cv::Mat& bgr, uint8_t* out) {
+	for (int y = 0; y < bgr.rows; y++) {
+		const uint8_t* row = bgr.ptr<uint8_t>(y);
+		for (int x = 0; x + 1 < bgr.cols; x += 2) {
+			const uint8_t* p = row + x * 3;
+			int y0 = (66 * p[2] + 129 * p[1] + 25 * p[0] + 128) >> 8;
+			int y1 = (66 * p[5] + 129 * p[4] + 25 * p[3] + 128) >> 8;
+			int r = (p[2] + p[5]) / 2, g = (p[1] + p[4]) / 2, b = (p[0] + p[3]) / 2;
+			int u = (-38 * r - 74 * g + 112 * b + 128) >> 8;
+			int v = (112 * r - 94 * g - 18 * b + 128) >> 8;
+			*out++ = clampByte(y0 + 16);
+			*out++ = clampByte(u + 128);
+			*out++ = clampByte(y1 + 16);
+			*out++ = clampByte(v + 128);
+		}
+	}
+}
+
+bool FrameRecorder::open(const std::string& filename, int width, int height, recording::PixelFormat format,
+						 bool device_timestamps) {
+	close();
+	if (format == recording::PixelFormat::YUYV && width % 2 != 0) {
+		std::cerr << "Error: YUYV recording needs an even frame width" << std::endl;
+		return false;
+	}
+
+	out.open(filename, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+		return false;
+	}
+
+	frame_bytes = static_cast<size_t>(width) * height * bytesPerPixel(format);
+	header = {};
+	std::memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.format = static_cast<uint32_t>(format);
+	header.width = width;
+	header.height = height;
+	header.flags = device_timestamps ? recording::kFlagDeviceTimestamps : 0;
+	header.record_bytes = (kTimestampBytes + 2 * frame_bytes + kRecordAlign - 1) / kRecordAlign * kRecordAlign;
+	scratch.assign(header.record_bytes, 0);
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	return static_cast<bool>(out);
+}
+
+bool FrameRecorder::matchesFormat(const cv::Mat& frame) {
+	if (frame.rows != static_cast<int>(header.height) || frame.cols != static_cast<int>(header.width) ||
+		(frame.type() != CV_8UC3 && frame.type() != CV_8UC2)) {
+		std::cerr << "Error: Frame " << frame.cols << "x" << frame.rows << " does not match the "
+				  << header.width << "x" << header.height << " recording" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool FrameRecorder::append(const cv::Mat& frame_1, int64_t timestamp_1_us, const cv::Mat& frame_2,
+						   int64_t timestamp_2_us) {
+	if (!out.is_open() || !matchesFormat(frame_1) || !matchesFormat(frame_2)) return false;
+
+	std::memcpy(scratch.data(), &timestamp_1_us, sizeof(int64_t));
+	std::memcpy(scratch.data() + sizeof(int64_t), &timestamp_2_us, sizeof(int64_t));
+	uint8_t* pixels = scratch.data() + kTimestampBytes;
+	for (const cv::Mat* frame : {&frame_1, &frame_2}) {
+		const bool yuyv_recording = header.format == static_cast<uint32_t>(recording::PixelFormat::YUYV);
+		if (frame->type() == CV_8UC2 && !yuyv_recording) {
+			// Raw camera frame into a BGR recording
+			cv::cvtColor(*frame, converted, cv::COLOR_YUV2BGR_YUYV);
+			frame = &converted;
+		}
+		if (frame->type() == CV_8UC2) {
+			// Raw camera frame into a YUYV recording: stored as captured
+			const size_t row_bytes = static_cast<size_t>(frame->cols) * 2;
+			for (int y = 0; y < frame->rows; y++) {
+				std::memcpy(pixels + y * row_bytes, frame->ptr<uint8_t>(y), row_bytes);
+			}
+		} else if (yuyv_recording) {
+			packYuyv(*frame, pixels);
+		} else {
+			const size_t row_bytes = static_cast<size_t>(frame->cols) * 3;
+			for (int y = 0; y < frame->rows; y++) {
+				std::memcpy(pixels + y * row_bytes, frame->ptr<uint8_t>(y), row_bytes);
+			}
+		}
+		pixels += frame_bytes;
+	}
+
+	out.write(reinterpret_cast<const char*>(scratch.data()), static_cast<std::streamsize>(scratch.size()));
+	if (!out) return false;
+	header.frame_pairs++;
+	return true;
+}
+
+bool FrameRecorder::close() {
+	if (!out.is_open()) return true;
+	out.seekp(0);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.close();
+	return !out.fail();
+}
+
+FrameRecording::~FrameRecording() {
+	if (data) {
+		munmap(const_cast<uint8_t*>(data), mapped_size);
+	}
+}
+
+bool FrameRecording::open(const std::string& filename) {
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Error: Could not open recording " << filename << std::endl;
+		return false;
+	}
+	struct stat st{};
+	if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(recording::Header)) {
+		std::cerr << "Error: " << filename << " is too short to be a recording" << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED) {
+		std::cerr << "Error: Could not map recording " << filename << std::endl;
+		return false;
+	}
+	data = static_cast<const uint8_t*>(p);
+	mapped_size = static_cast<size_t>(st.st_size);
+	std::memcpy(&header, data, sizeof(header));
+
+	const recording::PixelFormat fmt = format();
+	if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+		(fmt != recording::PixelFormat::BGR24 && fmt != recording::PixelFormat::YUYV)) {
+		std::cerr << "Error: " << filename << " is not a supported recording" << std::endl;
+		return false;
+	}
+	frame_bytes = static_cast<size_t>(header.width) * header.height * bytesPerPixel(fmt);
+	if (header.record_bytes < kTimestampBytes + 2 * frame_bytes) {
+		std::cerr << "Error: " << filename << " has an inconsistent record size" << std::endl;
+		return false;
+	}
+
+	// A recording that was not closed cleanly has no count; trust only complete records
+	const size_t complete = (mapped_size - sizeof(recording::Header)) / header.record_bytes;
+	frame_pairs = header.frame_pairs ? std::min<size_t>(header.frame_pairs, complete) : complete;
+	if (header.frame_pairs && header.frame_pairs > complete) {
+		std::cerr << "Warning: " << filename << " is truncated, " << complete << " of " << header.frame_pairs
+				  << " frame pairs available" << std::endl;
+	}
+	if (frame_pairs == 0) {
+		std::cerr << "Error: " << filename << " contains no frames" << std::endl;
+		return false;
+	}
+
+	madvise(p, mapped_size, MADV_SEQUENTIAL);
+	return true;
+}
+
+int64_t FrameRecording::timestamp(size_t index, int camera) const {
+	int64_t timestamp_us;
+	std::memcpy(&timestamp_us, record(index) + camera * sizeof(int64_t), sizeof(int64_t));
+	return timestamp_us;
+}
+
+void FrameRecording::frame(size_t index, int camera, cv::Mat& bgr) const {
+	const uint8_t* pixels = record(index) + kTimestampBytes + camera * frame_bytes;
+	if (format() == recording::PixelFormat::YUYV) {
+		const cv::Mat yuyv(height(), width(), CV_8UC2, const_cast<uint8_t*>(pixels));
+		cv::cvtColor(yuyv, bgr, cv::COLOR_YUV2BGR_YUYV);
+	} else {
+		bgr.create(height(), width(), CV_8UC3);
+		std::memcpy(bgr.data, pixels, frame_bytes);
+	}
+}
+
+void FrameRecording::rawFrame(size_t index, int camera, cv::Mat& frame) const {
+	const uint8_t* pixels = record(index) + kTimestampBytes + camera * frame_bytes;
+	frame.create(height(), width(), format() == recording::PixelFormat::YUYV ? CV_8UC2 : CV_8UC3);
+	std::memcpy(frame.data, pixels, frame_bytes);
+}
+
+ReplayFrameSource::ReplayFrameSource(std::shared_ptr<const FrameRecording> recording, int camera, bool realtime,
+									 std::shared_ptr<ReplayClock> clock) :
+	recording(std::move(recording)), camera(camera), realtime(realtime), clock(std::move(clock)) {
+	const size_t n = this->recording->frames();
+	const int64_t first = this->recording->timestamp(0, camera);
+	const int64_t span = this->recording->timestamp(n - 1, camera) - first;
+	// One extra mean frame interval between the last frame and the first frame of the next loop
+	period_us = n > 1 ? span + span / static_cast<int64_t>(n - 1) : 1000;
+}
+
+bool ReplayFrameSource::grab(int64_t& timestamp_us) {
+	const size_t n = recording->frames();
+	latched = next % n;
+	const int64_t loop = static_cast<int64_t>(next / n);
+	next++;
+
+	int64_t expected = 0;
+	clock->start_us.compare_exchange_strong(expected, steadyNowUs());
+	const int64_t start_us = clock->start_us.load();
+
+	// Offsets are relative to camera 0's first frame so both cameras keep their recorded skew
+	const int64_t offset_us = recording->timestamp(latched, camera) - recording->timestamp(0, 0) + loop * period_us;
+	timestamp_us = start_us + offset_us;
+
+	if (realtime) {
+		const int64_t wait_us = timestamp_us - steadyNowUs();
+		if (wait_us > 0) {
+			std::this_thread::sleep_for(std::chrono::microseconds(wait_us));
+		}
+	}
+	return true;
+}
+
+bool ReplayFrameSource::retrieve(cv::Mat& frame) {
+	recording->rawFrame(latched, camera, frame);
+	return true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "frame_source.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Recorded dual-camera sessions.
+//
+// The container is a 64-byte header followed by fixed-size records, one per synchronized frame
+// pair: both capture timestamps, then the raw pixels of camera 1 and camera 2. Fixed-size
+// records let a reader map the file and index any pair directly. Pixels are stored as BGR24, or
+// as YUYV (4:2:2, two bytes per pixel) to record a third smaller.
+namespace recording {
+	enum class PixelFormat : uint32_t { BGR24 = 0, YUYV = 1 };
+
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t flags; // bit 0: timestamps are device (V4L2 buffer) timestamps
+		uint32_t reserved;
+		uint64_t frame_pairs; // 0 while recording; readers then count the complete records
+		uint64_t record_bytes;
+		uint8_t padding[16];
+	};
+	static_assert(sizeof(Header) == 64, "recording header must stay 64 bytes");
+
+	constexpr uint32_t kFlagDeviceTimestamps = 1;
+}
+
+class FrameRecorder {
+public:
+	~FrameRecorder() { close(); }
+
+	bool open(const std::string& filename, int width, int height, recording::PixelFormat format,
+			  bool device_timestamps);
+	bool append(const cv::Mat& frame_1, int64_t timestamp_1_us, const cv::Mat& frame_2, int64_t timestamp_2_us);
+	// Writes the final frame count into the header
+	bool close();
+
+	uint64_t frames() const { return header.frame_pairs; }
+
+private:
+	bool matchesFormat(const cv::Mat& frame);
+
+	std::ofstream out;
+	recording::Header header{};
+	size_t frame_bytes = 0;
+	std::vector<uint8_t> scratch;
+	cv::Mat converted;
+};
+
+// Read-only, memory-mapped view of a recording
+class FrameRecording {
+public:
+	~FrameRecording();
+
+	bool open(const std::string& filename);
+
+	size_t frames() const { return frame_pairs; }
+	int width() const { return static_cast<int>(header.width); }
+	int height() const { return static_cast<int>(header.height); }
+	recording::PixelFormat format() const { return static_cast<recording::PixelFormat>(header.format); }
+	bool hasDeviceTimestamps() const { return header.flags & recording::kFlagDeviceTimestamps; }
+
+	// Timestamp of camera 0 or 1 in pair `index`
+	int64_t timestamp(size_t index, int camera) const;
+	// Decodes camera 0 or 1 of pair `index` into a BGR frame
+	void frame(size_t index, int camera, cv::Mat& bgr) const;
+	// The same frame as stored: BGR, or CV_8UC2 for YUYV recordings
+	void rawFrame(size_t index, int camera, cv::Mat& frame) const;
+
+private:
+	const uint8_t* record(size_t index) const { return data + sizeof(recording::Header) + index * header.record_bytes; }
+
+	recording::Header header{};
+	const uint8_t* data = nullptr;
+	size_t mapped_size = 0;
+	size_t frame_pairs = 0;
+	size_t frame_bytes = 0;
+};
+
+// Shared by both cameras' replay sources so they are paced against the same start time
+struct ReplayClock {
+	std::atomic<int64_t> start_us{0};
+};
+
+// Plays one camera of a recording back, either at the recorded frame rate or as fast as frames
+// are requested, looping at the end. Timestamps keep their recorded spacing but are moved onto
+// the current steady_clock, so pairing across both cameras works exactly as it did live.
+class ReplayFrameSource : public FrameSource {
+public:
+	ReplayFrameSource(std::shared_ptr<const FrameRecording> recording, int camera, bool realtime,
+					  std::shared_ptr<ReplayClock> clock);
+
+	bool grab(int64_t& timestamp_us) override;
+	bool retrieve(cv::Mat& frame) override;
+	bool hasDeviceTimestamps() const override { return recording->hasDeviceTimestamps(); }
+	bool paced() const override { return realtime; }
+	// YUYV recordings replay as raw camera frames, exactly like the V4L2 capture backend
+	bool deliversYuyv() const override { return recording->format() == recording::PixelFormat::YUYV; }
+
+private:
+	std::shared_ptr<const FrameRecording> recording;
+	int camera;
+	bool realtime;
+	std::shared_ptr<ReplayClock> clock;
+
+	uint64_t next = 0;   // frames grabbed so far, across loops
+	size_t latched = 0;  // pair index of the last grabbed frame
+	int64_t period_us = 0; // recording length plus one frame interval, added per loop
+};
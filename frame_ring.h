@@ -0,0 +1,191 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Lock-free ring of preallocated frames with a single producer (the camera grab thread).
+//
+// Each slot is guarded by a sequence counter that is odd while the producer writes into it
+// (a seqlock). Readers copy a committed slot and retry if the counter moved underneath them,
+// so neither side ever blocks. With a few slots the producer only laps a reader that takes
+// longer than several frame intervals to copy one frame.
+//
+// The slot Mats are allocated once and their headers never change afterwards, so readers can
+// look at them without synchronization; only the pixels are guarded by the seqlock. The producer
+// writes through a separate header onto the same buffer (see beginWrite()).
+//
+// Instead of copying frames in, a producer whose frames live in driver buffers can lend those
+// buffers to the ring (commitLent()); a slot then points at the buffer until it is recycled.
+// A ring is filled one way or the other, not both.
+class FrameRing {
+public:
+	explicit FrameRing(size_t capacity = 4) : capacity(capacity), slots(new Slot[capacity]) {}
+
+	FrameRing(const FrameRing&) = delete;
+	FrameRing& operator=(const FrameRing&) = delete;
+
+	// Sets the frame geometry; the slots get pixels of their own unless the producer lends buffers
+	void allocate(int rows, int cols, int type, bool own_pixels = true) {
+		frame_rows = rows;
+		frame_cols = cols;
+		frame_type = type;
+		if (!own_pixels) return;
+		for (size_t i = 0; i < capacity; i++) {
+			slots[i].frame.create(rows, cols, type);
+		}
+	}
+
+	// Producer side: fill the returned Mat in place, then commit it with its capture timestamp.
+	// The Mat is the producer's own header on the slot's buffer, so a writer that reallocates it
+	// never touches the header readers copy from.
+	cv::Mat& beginWrite() {
+		Slot& slot = slots[written.load(std::memory_order_relaxed) % capacity];
+		slot.seq.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		writer = slot.frame;
+		return writer;
+	}
+
+	// Returns false (and aborts the write) when the producer reallocated the Mat to a different
+	// size or type, which the slot cannot hold
+	bool commitWrite(int64_t timestamp_us) {
+		const uint64_t id = written.load(std::memory_order_relaxed);
+		Slot& slot = slots[id % capacity];
+		if (writer.data != slot.frame.data) {
+			// Reallocated by the writer: bring the pixels back into the slot's own buffer
+			if (writer.size() != slot.frame.size() || writer.type() != slot.frame.type()) {
+				abortWrite();
+				return false;
+			}
+			writer.copyTo(slot.frame);
+		}
+		writer.release();
+		slot.timestamp_us.store(timestamp_us, std::memory_order_relaxed);
+		slot.frame_id.store(id, std::memory_order_relaxed);
+		slot.seq.fetch_add(1, std::memory_order_release);
+		written.store(id + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Gives the slot back without publishing it, e.g. when decoding into it failed. The slot may
+	// hold a half-written image, so its previous frame is dropped rather than left readable.
+	void abortWrite() {
+		Slot& slot = slots[written.load(std::memory_order_relaxed) % capacity];
+		writer.release();
+		slot.frame_id.store(UINT64_MAX, std::memory_order_relaxed);
+		slot.seq.fetch_add(1, std::memory_order_release);
+	}
+
+	// Zero-copy publish: the next slot points at `frame`, a buffer the producer lends to the ring,
+	// which must have the allocated geometry. Returns the buffer the slot was lent before (-1 if
+	// none): it is no longer published, and a reader still copying from it fails its sequence
+	// check, so the producer may hand it back to its owner right away.
+	int commitLent(const cv::Mat& frame, int buffer, int64_t timestamp_us) {
+		const uint64_t id = written.load(std::memory_order_relaxed);
+		Slot& slot = slots[id % capacity];
+		slot.seq.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		const int previous = slot.lent_buffer;
+		slot.lent_buffer = buffer;
+		slot.lent_data.store(frame.data, std::memory_order_relaxed);
+		slot.lent_step.store(frame.step, std::memory_order_relaxed);
+		slot.timestamp_us.store(timestamp_us, std::memory_order_relaxed);
+		slot.frame_id.store(id, std::memory_order_relaxed);
+		slot.seq.fetch_add(1, std::memory_order_release);
+		written.store(id + 1, std::memory_order_release);
+		return previous;
+	}
+
+	// Takes every lent buffer back out of the ring once the producer has stopped, passing each to
+	// `give_back`; their frames are no longer readable afterwards
+	template <typename GiveBack>
+	void reclaimLent(GiveBack give_back) {
+		for (size_t i = 0; i < capacity; i++) {
+			Slot& slot = slots[i];
+			if (slot.lent_buffer < 0) continue;
+			slot.seq.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			slot.lent_data.store(nullptr, std::memory_order_relaxed);
+			slot.frame_id.store(UINT64_MAX, std::memory_order_relaxed);
+			slot.seq.fetch_add(1, std::memory_order_release);
+			give_back(slot.lent_buffer);
+			slot.lent_buffer = -1;
+		}
+	}
+
+	// Number of frames committed so far; the newest frame has id frames() - 1
+	uint64_t frames() const { return written.load(std::memory_order_acquire); }
+
+	// Copies frame `id` into `out` (reusing its buffer). Fails if the frame was never written or
+	// has already been overwritten.
+	bool read(uint64_t id, cv::Mat& out, int64_t& timestamp_us) const {
+		const Slot& slot = slots[id % capacity];
+		while (true) {
+			if (id >= frames()) return false;
+
+			const uint64_t seq_before = slot.seq.load(std::memory_order_acquire);
+			if (seq_before & 1) continue; // producer is writing this slot right now
+			if (slot.frame_id.load(std::memory_order_relaxed) != id) return false;
+
+			out.create(frame_rows, frame_cols, frame_type);
+			const uint8_t* lent = slot.lent_data.load(std::memory_order_relaxed);
+			if (lent) {
+				// Driver buffers may have padded rows
+				const size_t step = slot.lent_step.load(std::memory_order_relaxed);
+				const size_t row_bytes = out.cols * out.elemSize();
+				for (int y = 0; y < out.rows; y++) {
+					std::memcpy(out.ptr<uint8_t>(y), lent + y * step, row_bytes);
+				}
+			} else {
+				std::memcpy(out.data, slot.frame.data, out.total() * out.elemSize());
+			}
+			timestamp_us = slot.timestamp_us.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.seq.load(std::memory_order_relaxed) == seq_before) return true;
+		}
+	}
+
+	// Copies the newest committed frame; returns false before the first frame arrives and once
+	// the newest frame was dropped (reclaimLent())
+	bool readLatest(cv::Mat& out, int64_t& timestamp_us, uint64_t& id) const {
+		while (true) {
+			const uint64_t count = frames();
+			if (count == 0) return false;
+			id = count - 1;
+			if (read(id, out, timestamp_us)) return true;
+			if (frames() == count) return false; // not overtaken by a newer frame, so it is gone
+		}
+	}
+
+	// Timestamp of frame `id` without copying pixels, used to pick frames before reading them
+	bool timestamp(uint64_t id, int64_t& timestamp_us) const {
+		const Slot& slot = slots[id % capacity];
+		const uint64_t seq_before = slot.seq.load(std::memory_order_acquire);
+		if ((seq_before & 1) || id >= frames() || slot.frame_id.load(std::memory_order_relaxed) != id) return false;
+		timestamp_us = slot.timestamp_us.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.seq.load(std::memory_order_relaxed) == seq_before;
+	}
+
+	size_t size() const { return capacity; }
+
+private:
+	struct Slot {
+		cv::Mat frame;
+		std::atomic<const uint8_t*> lent_data{nullptr}; // set instead of `frame` for lent buffers
+		std::atomic<size_t> lent_step{0};
+		int lent_buffer = -1; // producer only
+		std::atomic<uint64_t> seq{0};
+		std::atomic<int64_t> timestamp_us{0};
+		std::atomic<uint64_t> frame_id{UINT64_MAX};
+	};
+
+	const size_t capacity;
+	std::unique_ptr<Slot[]> slots;
+	std::atomic<uint64_t> written{0};
+	int frame_rows = 0, frame_cols = 0, frame_type = 0; // set by allocate() before the producer starts
+	cv::Mat writer; // producer only
+};
@@ -0,0 +1,79 @@
+#include "frame_source.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+static int64_t steadyNowUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+V4L2FrameSource::V4L2FrameSource(int index, int fps) : index(index) {
+	video_capture.open(index, cv::CAP_V4L2);
+
+	// Set basic parameters
+	// video_capture.set(cv::CAP_PROP_FRAME_WIDTH, width);
+	// video_capture.set(cv::CAP_PROP_FRAME_HEIGHT, height);
+	video_capture.set(cv::CAP_PROP_FPS, fps);
+	// video_capture.set(cv::CAP_PROP_BUFFERSIZE, 1); // Keep buffer small for real-time
+
+	// Camera settings for stable image using config values
+	// video_capture.set(cv::CAP_PROP_AUTO_WB, 1); // Disable Auto White Balance
+	// video_capture.set(cv::CAP_PROP_AUTO_EXPOSURE, 0); // Disable Auto Exposure
+	// video_capture.set(cv::CAP_PROP_EXPOSURE, config.exposure);
+	// video_capture.set(cv::CAP_PROP_GAIN, config.gain);
+	// video_capture.set(cv::CAP_PROP_BRIGHTNESS, config.brightness);
+	// video_capture.set(cv::CAP_PROP_CONTRAST, config.contrast);
+	// video_capture.set(cv::CAP_PROP_SATURATION, config.saturation);
+
+	if (!video_capture.isOpened()) {
+		std::cerr << "Camera " << index << " could not be opened" << std::endl;
+		throw std::exception();
+	}
+
+	// Warmup with 5 frames to stabilize
+	cv::Mat temp_frames;
+	for (int i = 0; i < 5; i++) {
+		video_capture.read(temp_frames);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+
+bool V4L2FrameSource::grab(int64_t& timestamp_us) {
+	if (!video_capture.grab()) return false;
+	timestamp_us = grabTimestampUs();
+	return true;
+}
+
+bool V4L2FrameSource::retrieve(cv::Mat& frame) {
+	return video_capture.retrieve(frame);
+}
+
+void V4L2FrameSource::minimizeLatency() {
+	// Optimize settings for dual camera operation
+	video_capture.set(cv::CAP_PROP_BUFFERSIZE, 1); // Minimal buffer for real-time
+
+	// Clear any buffered frames
+	cv::Mat dummy;
+	for (int i = 0; i < 3; i++) {
+		video_capture.read(dummy);
+	}
+}
+
+int64_t V4L2FrameSource::grabTimestampUs() {
+	const int64_t now_us = steadyNowUs();
+	// The V4L2 backend reports the driver's buffer timestamp here. It is taken at frame capture
+	// on CLOCK_MONOTONIC, the clock behind steady_clock on Linux, so it can be compared across
+	// cameras. Zero or far-off values mean it is unavailable or in another clock domain.
+	const double device_ms = video_capture.get(cv::CAP_PROP_POS_MSEC);
+	if (device_ms > 0) {
+		const int64_t device_us = static_cast<int64_t>(device_ms * 1000.0);
+		if (std::llabs(now_us - device_us) < 1000000) {
+			device_timestamps.store(true, std::memory_order_relaxed);
+			return device_us;
+		}
+	}
+	device_timestamps.store(false, std::memory_order_relaxed);
+	return now_us;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include <atomic>
+#include <cstdint>
+
+// Where a PS3EyeCamera gets its frames from: a V4L2 device or a recorded session.
+//
+// grab() latches the next frame together with its capture timestamp (CLOCK_MONOTONIC,
+// microseconds) and retrieve() decodes the latched frame, mirroring cv::VideoCapture so two
+// cameras can latch back to back before either frame is decoded. Frames are BGR, or packed YUYV
+// (CV_8UC2) for sources that report deliversYuyv().
+class FrameSource {
+public:
+	virtual ~FrameSource() = default;
+
+	virtual bool grab(int64_t& timestamp_us) = 0;
+	virtual bool retrieve(cv::Mat& frame) = 0;
+
+	bool read(cv::Mat& frame) {
+		int64_t timestamp_us;
+		return grab(timestamp_us) && retrieve(frame);
+	}
+
+	// True when timestamps are taken at capture time rather than on the host after grab()
+	virtual bool hasDeviceTimestamps() const = 0;
+	// Drops queued frames so the next grab() returns a fresh one
+	virtual void minimizeLatency() {}
+	// False for sources that deliver frames as fast as they are asked for; a grab thread on such
+	// a source would only race through it
+	virtual bool paced() const { return true; }
+	// True when retrieve() hands out the camera's YUYV frames instead of converting them to BGR
+	virtual bool deliversYuyv() const { return false; }
+
+	// Zero-copy alternative to retrieve() for sources whose frames sit in driver buffers: lend()
+	// points `frame` at the latched buffer itself and reports which one it is. The buffer stays
+	// out of the driver's queue until giveBack(), so the caller decides how long it stays valid.
+	// lendableBuffers() is how many buffers the source has in total (0 = no lending).
+	virtual size_t lendableBuffers() const { return 0; }
+	virtual bool lend(cv::Mat& frame, int& buffer) { return false; }
+	virtual void giveBack(int buffer) {}
+};
+
+// Live camera through OpenCV's V4L2 backend
+class V4L2FrameSource : public FrameSource {
+public:
+	// Throws if the device cannot be opened
+	V4L2FrameSource(int index, int fps);
+
+	bool grab(int64_t& timestamp_us) override;
+	bool retrieve(cv::Mat& frame) override;
+	bool hasDeviceTimestamps() const override { return device_timestamps.load(std::memory_order_relaxed); }
+	void minimizeLatency() override;
+
+private:
+	int64_t grabTimestampUs();
+
+	int index;
+	cv::VideoCapture video_capture;
+	std::atomic<bool> device_timestamps{false};
+};
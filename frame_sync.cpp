@@ -0,0 +1,100 @@
+#include "frame_sync.h"
+#include <algorithm>
+#include <cstdlib>
+
+FrameSync::FrameSync(PS3EyeCamera& camera_1, PS3EyeCamera& camera_2, int64_t max_skew_us, int timeout_ms) :
+	camera_1(camera_1), camera_2(camera_2), max_skew_us(max_skew_us), timeout_ms(timeout_ms) {}
+
+bool FrameSync::capturePair(cv::Mat& frame_1, cv::Mat& frame_2) {
+	int64_t t_1, t_2;
+	return capturePair(frame_1, frame_2, t_1, t_2);
+}
+
+bool FrameSync::capturePair(cv::Mat& frame_1, cv::Mat& frame_2, int64_t& timestamp_1_us, int64_t& timestamp_2_us) {
+	bool ok = camera_1.isStreaming() && camera_2.isStreaming()
+			? pairFromRings(frame_1, frame_2, timestamp_1_us, timestamp_2_us)
+			: pairDirect(frame_1, frame_2, timestamp_1_us, timestamp_2_us);
+	if (ok) {
+		const int64_t skew_us = std::llabs(timestamp_1_us - timestamp_2_us);
+		if (skew_us > max_skew_us) {
+			stats.out_of_window++;
+		}
+		record(skew_us);
+	}
+	return ok;
+}
+
+bool FrameSync::bestRingPair(uint64_t& id_1, uint64_t& id_2, int64_t& skew_us) const {
+	const uint64_t count_1 = camera_1.frameCount();
+	const uint64_t count_2 = camera_2.frameCount();
+	if (count_1 == 0 || count_2 == 0) return false;
+
+	// The newest ring_size - 1 frames; the remaining slot may be under the producer's pen
+	const uint64_t depth_1 = std::max<size_t>(camera_1.ringSize(), 2) - 1;
+	const uint64_t depth_2 = std::max<size_t>(camera_2.ringSize(), 2) - 1;
+	const uint64_t first_1 = count_1 > depth_1 ? count_1 - depth_1 : 0;
+	const uint64_t first_2 = count_2 > depth_2 ? count_2 - depth_2 : 0;
+
+	bool found = false;
+	for (uint64_t a = count_1; a-- > first_1;) {
+		int64_t t_1;
+		if (!camera_1.frameTimestamp(a, t_1)) continue;
+		for (uint64_t b = count_2; b-- > first_2;) {
+			int64_t t_2;
+			if (!camera_2.frameTimestamp(b, t_2)) continue;
+			const int64_t skew = std::llabs(t_1 - t_2);
+			// Iterating newest first, so strict < keeps the newest pair on ties
+			if (!found || skew < skew_us) {
+				found = true;
+				skew_us = skew;
+				id_1 = a;
+				id_2 = b;
+			}
+		}
+	}
+	return found;
+}
+
+bool FrameSync::pairFromRings(cv::Mat& frame_1, cv::Mat& frame_2, int64_t& t_1, int64_t& t_2) {
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+	while (true) {
+		uint64_t id_1 = 0, id_2 = 0;
+		int64_t skew = 0;
+		const bool found = bestRingPair(id_1, id_2, skew);
+		const bool timed_out = std::chrono::steady_clock::now() >= deadline;
+
+		if (found && (skew <= max_skew_us || timed_out)) {
+			// A read only fails if the producer lapped us in the meantime; pick again
+			if (camera_1.readFrame(id_1, frame_1, t_1) && camera_2.readFrame(id_2, frame_2, t_2)) {
+				return true;
+			}
+			continue;
+		}
+		if (timed_out) {
+			return false;
+		}
+
+		// Wait for either camera to deliver another frame
+		const uint64_t count_1 = camera_1.frameCount();
+		const uint64_t count_2 = camera_2.frameCount();
+		while (camera_1.frameCount() == count_1 && camera_2.frameCount() == count_2 &&
+			   std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+}
+
+bool FrameSync::pairDirect(cv::Mat& frame_1, cv::Mat& frame_2, int64_t& t_1, int64_t& t_2) {
+	// Latch both sensors first; decoding happens after both buffers are dequeued
+	if (!camera_1.grabFrame(t_1) || !camera_2.grabFrame(t_2)) return false;
+	return camera_1.retrieveFrame(frame_1) && camera_2.retrieveFrame(frame_2);
+}
+
+void FrameSync::record(int64_t skew_us) {
+	stats.last_skew_us = skew_us;
+	stats.max_skew_us = std::max(stats.max_skew_us, skew_us);
+	stats.pairs++;
+	stats.mean_skew_us += (static_cast<double>(skew_us) - stats.mean_skew_us) / static_cast<double>(stats.pairs);
+	stats.device_timestamps = camera_1.hasDeviceTimestamps() && camera_2.hasDeviceTimestamps();
+}
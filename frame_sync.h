@@ -0,0 +1,42 @@
+#pragma once
+#include "PS3EyeCamera.h"
+#include <cstdint>
+
+// Pairs frames from the two cameras by capture timestamp.
+//
+// While both cameras stream, the pairer looks at the frames still held in both rings and picks
+// the pair with the smallest timestamp difference (newest first on ties), waiting for new frames
+// until a pair falls inside the skew window or the timeout expires. Without streaming it latches
+// both cameras back to back with grab() before decoding either frame.
+class FrameSync {
+public:
+	struct Stats {
+		int64_t last_skew_us = 0;
+		int64_t max_skew_us = 0;
+		double mean_skew_us = 0;
+		uint64_t pairs = 0;
+		uint64_t out_of_window = 0; // pairs delivered after the timeout with skew above the window
+		bool device_timestamps = false;
+	};
+
+	FrameSync(PS3EyeCamera& camera_1, PS3EyeCamera& camera_2, int64_t max_skew_us, int timeout_ms);
+
+	// Fills both frames with the best-matching pair. Returns false only if no frames are available.
+	bool capturePair(cv::Mat& frame_1, cv::Mat& frame_2);
+	bool capturePair(cv::Mat& frame_1, cv::Mat& frame_2, int64_t& timestamp_1_us, int64_t& timestamp_2_us);
+
+	const Stats& getStats() const { return stats; }
+	int64_t maxSkewUs() const { return max_skew_us; }
+
+private:
+	bool pairFromRings(cv::Mat& frame_1, cv::Mat& frame_2, int64_t& t_1, int64_t& t_2);
+	bool pairDirect(cv::Mat& frame_1, cv::Mat& frame_2, int64_t& t_1, int64_t& t_2);
+	bool bestRingPair(uint64_t& id_1, uint64_t& id_2, int64_t& skew_us) const;
+	void record(int64_t skew_us);
+
+	PS3EyeCamera& camera_1;
+	PS3EyeCamera& camera_2;
+	int64_t max_skew_us;
+	int timeout_ms;
+	Stats stats;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include <array>
+
+// Per-pixel BGR -> HSV conversion, bit-exact with cv::cvtColor(..., COLOR_BGR2HSV) for 8-bit images
+// (H in 0-179, S and V in 0-255). Used to convert only the calibrated sticker points instead of the
+// whole frame, so detection cost scales with the number of stickers and not with the resolution.
+
+namespace hsv {
+	constexpr int kShift = 12;
+
+	// Same fixed-point reciprocal tables OpenCV builds for its 8-bit HSV path
+	inline constexpr std::array<int, 256> kSdivTable = [] {
+		std::array<int, 256> t{};
+		for (int i = 1; i < 256; i++) {
+			t[i] = (2 * (255 << kShift) + i) / (2 * i);
+		}
+		return t;
+	}();
+
+	inline constexpr std::array<int, 256> kHdivTable180 = [] {
+		std::array<int, 256> t{};
+		for (int i = 1; i < 256; i++) {
+			t[i] = (2 * (180 << kShift) + 6 * i) / (12 * i);
+		}
+		return t;
+	}();
+
+	inline cv::Vec3b fromBgr(int b, int g, int r) {
+		int v = std::max(b, std::max(g, r));
+		int vmin = std::min(b, std::min(g, r));
+		int diff = v - vmin;
+		int vr = v == r ? -1 : 0;
+		int vg = v == g ? -1 : 0;
+
+		int s = (diff * kSdivTable[v] + (1 << (kShift - 1))) >> kShift;
+		int h = (vr & (g - b)) + (~vr & ((vg & (b - r + 2 * diff)) + ((~vg) & (r - g + 4 * diff))));
+		h = (h * kHdivTable180[diff] + (1 << (kShift - 1))) >> kShift;
+		h += h < 0 ? 180 : 0;
+
+		return cv::Vec3b(static_cast<uchar>(std::min(h, 255)), static_cast<uchar>(s), static_cast<uchar>(v));
+	}
+
+	inline cv::Vec3b fromBgr(const cv::Vec3b& bgr) { return fromBgr(bgr[0], bgr[1], bgr[2]); }
+
+}
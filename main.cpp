@@ -1,12 +1,44 @@
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdlib>
+#include <limits>
 #include <map>
+#include <memory>
 #include <thread>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include "opencv2/opencv.hpp"
+#include "PS3EyeCamera.h"
 #include "arduino_detection.h"
+#include "bench_report.h"
+#include "color_lut.h"
+#include "cube_detector.h"
+#include "cube_orientation.h"
+#include "cube_repair.h"
+#include "cube_geometry.h"
+#include "deadline_solve.h"
+#include "debug_view.h"
+#include "detection_workers.h"
+#include "frame_recording.h"
+#include "frame_sync.h"
+#include "solution_cache.h"
+#include "solve_server.h"
+#include "solver_service.h"
+#include "state_accumulator.h"
+#include "station.h"
+#include "station_pipeline.h"
+#include "station_scheduler.h"
+#include "sticker_kernel.h"
+#include "sticker_state.h"
+#include "sticker_vote.h"
+#include "table_cache.h"
+#include "trace.h"
+#include "v4l2_capture.h"
+#include "yuyv.h"
 
 // Rob-twophase headers
 #include "cubie.h"
@@ -17,42 +49,13 @@
 #include "solve.h"
 #include "sym.h"
 
-// Configuration structure
-struct Config {
-    int camera_1_index = 4;
-    int camera_2_index = 5;
-    int camera_width = 320;
-    int camera_height = 240;
-    int camera_fps = 187;
-    int exposure = 15;
-    int gain = 10;
-    int brightness = 15;
-    int contrast = 9;
-    int saturation = 60;
-};
-
 // Global configuration
 static Config config;
 
-class PS3EyeCamera {
-private:
-	int height{}, width{}, index{}, fps{};
-	cv::VideoCapture video_capture;
-	bool camera_initialized = false;
-	std::ofstream position_out_file;
-public:
-	explicit PS3EyeCamera(int height = 320, int width = 240, int index = 4, int fps = 187);
-	bool calibratePosition(const std::string &filename);
-	void calibrateColors(const std::string &filename);
-	void friend positionMouseCallback(int event, int x, int y, int flags, void* userdata);
-	void capture(cv::Mat& frame);
-	void optimizeForDualCamera();
-};
-
 // Function declarations
 void show_dual_camera_feed(PS3EyeCamera *camera_1, PS3EyeCamera *camera_2);
 void drawPositioningGrid(cv::Mat& frame);
-void loadConfig(const std::string& filename);
+void loadConfig(const std::string& filename, Config& config);
 void initializeCameras();
 
 // Global variables for calibration
@@ -68,7 +71,6 @@ static std::vector<cv::Point> clicked_points;
 
 // Face names for display and cube solving (Camera 1: Up, Right, Front | Camera 2: Down, Left, Back)
 static const char* face_names[] = {"Up", "Right", "Front", "Down", "Left", "Back"};
-static const char face_color_chars[] = {'R', 'G', 'W', 'O', 'B', 'Y'};
 static const char* face_positions[] = {
     // Camera 1 faces (Up, Right, Front)
     "Corner-TL", "Edge-T", "Corner-TR", "Edge-L", "Edge-R", "Corner-BL", "Edge-B", "Corner-BR", // Front face (skip center at index 4)
@@ -100,6 +102,66 @@ static const ColorRange red_high_range = {170, 179, 80, 255, 80, 255};
 // Callback functions
 static void on_trackbar(int, void*) {}
 
+// Live classification preview for the color calibration modes: the ranges range.txt will hold
+// plus the one on the trackbars, which is rewritten in place (one bit of the masks) every frame
+static ColorClassifier calibration_preview;
+
+static ColorClassifier::Rule trackbarRule(char color) {
+    // Same wrap rule as range.txt parsing, so the preview is what detection will see
+    return {color, h_min, h_max, s_min, s_max, v_min, v_max, color == 'R' && h_min > h_max};
+}
+
+// False when the preview had no room for the trackbar range, so its last rule is a saved one
+static bool preview_range_active = false;
+
+// Starts previewing a new range, with priority over the saved ones
+static void beginPreviewRange(char color) {
+    preview_range_active = calibration_preview.addRule(trackbarRule(color));
+    if (!preview_range_active) {
+        std::cerr << "Warning: Preview is full (range file holds too many ranges), the trackbar range is not shown"
+                  << std::endl;
+    }
+}
+
+static void updatePreviewRange() {
+    if (!preview_range_active) return;
+    const size_t count = calibration_preview.getRules().size();
+    calibration_preview.setRule(count - 1, trackbarRule(calibration_preview.getRules().back().color));
+}
+
+// Drops the trackbar range from the preview, e.g. when its calibration is skipped
+static void endPreviewRange() {
+    if (preview_range_active) calibration_preview.removeLastRule();
+    preview_range_active = false;
+}
+
+// Paints every pixel with the color the preview classifies it as (gray = unclassified)
+static void drawClassification(const cv::Mat& frame, cv::Mat& classified) {
+    static const std::array<cv::Vec3b, 256> palette = [] {
+        std::array<cv::Vec3b, 256> colors;
+        colors.fill(cv::Vec3b(128, 128, 128));
+        colors['W'] = cv::Vec3b(255, 255, 255);
+        colors['R'] = cv::Vec3b(0, 0, 255);
+        colors['O'] = cv::Vec3b(0, 165, 255);
+        colors['Y'] = cv::Vec3b(0, 255, 255);
+        colors['G'] = cv::Vec3b(0, 255, 0);
+        colors['B'] = cv::Vec3b(255, 0, 0);
+        return colors;
+    }();
+
+    cv::Mat hsv;
+    cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+    classified.create(hsv.rows, hsv.cols, CV_8UC3);
+    for (int y = 0; y < hsv.rows; y++) {
+        const cv::Vec3b* in = hsv.ptr<cv::Vec3b>(y);
+        cv::Vec3b* out = classified.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < hsv.cols; x++) {
+            const char color = calibration_preview.classify(in[x][0], in[x][1], in[x][2]);
+            out[x] = palette[static_cast<uint8_t>(color)];
+        }
+    }
+}
+
 // Function to calibrate red wraparound range (170-179)
 static void calibrateRedWraparound(PS3EyeCamera* camera, std::ofstream& outfile) {
     std::cout << "\n=== Red Wraparound Calibration (170-179 hue range) ===" << std::endl;
@@ -122,9 +184,11 @@ static void calibrateRedWraparound(PS3EyeCamera* camera, std::ofstream& outfile)
     cv::setTrackbarPos("S_MAX", "Controls", s_max);
     cv::setTrackbarPos("V_MIN", "Controls", v_min);
     cv::setTrackbarPos("V_MAX", "Controls", v_max);
+    beginPreviewRange('R');
     
     while (true) {
         cv::Mat frame, hsv_frame, mask, preview;
+        updatePreviewRange();
         
         camera->capture(frame);
         if (frame.empty()) {
@@ -205,6 +269,7 @@ static void calibrateRedWraparound(PS3EyeCamera* camera, std::ofstream& outfile)
         }
         if (key == 'q') {
             std::cout << "Skipped red wraparound calibration" << std::endl;
+            endPreviewRange();
             break;
         }
     }
@@ -260,9 +325,13 @@ void PS3EyeCamera::calibrateColors(const std::string& output_filename) {
     cv::moveWindow("Color Calibration", 50, 50);
     cv::moveWindow("Controls", 1500, 50);
 
+    // New ranges are appended, so the preview starts from what the file already holds
+    if (!calibration_preview.loadFromFile(output_filename)) calibration_preview.clear();
+
     for (int i = 0; i < 6; ++i) {
         // Auto-suggest starting values
         reset_to_defaults(i);
+        beginPreviewRange(color_chars[i]);
 
         std::cout << "\n=== Calibrating for face: " << face_orientations[i] << " ===" << std::endl;
         std::cout << "Controls:" << std::endl;
@@ -285,11 +354,15 @@ void PS3EyeCamera::calibrateColors(const std::string& output_filename) {
             cv::bitwise_and(frame, frame, preview, mask);
 
             // Scale up the images for better visibility
-            cv::Mat frame_large, mask_large, preview_large;
+            cv::Mat frame_large, mask_large, preview_large, classified_large;
             cv::resize(frame, frame_large, cv::Size(400, 300));
             cv::resize(mask, mask_large, cv::Size(400, 300));
             cv::resize(preview, preview_large, cv::Size(400, 300));
 
+            // All ranges together, as detection will classify with them
+            updatePreviewRange();
+            drawClassification(frame_large, classified_large);
+
             // Convert mask to 3-channel for concatenation
             cv::Mat mask_colored;
             cv::cvtColor(mask_large, mask_colored, cv::COLOR_GRAY2BGR);
@@ -297,7 +370,7 @@ void PS3EyeCamera::calibrateColors(const std::string& output_filename) {
             // Create combined display
             cv::Mat top_row, bottom_row, combined_display;
             cv::hconcat(frame_large, mask_colored, top_row);
-            cv::hconcat(preview_large, cv::Mat::zeros(300, 400, CV_8UC3), bottom_row);
+            cv::hconcat(preview_large, classified_large, bottom_row);
             cv::vconcat(top_row, bottom_row, combined_display);
 
             // Add labels to each section
@@ -307,12 +380,14 @@ void PS3EyeCamera::calibrateColors(const std::string& output_filename) {
                        cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 255, 0), 2);
             cv::putText(combined_display, "Detected", cv::Point(10, 325),
                        cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 255, 0), 2);
+            cv::putText(combined_display, "Classified", cv::Point(410, 325),
+                       cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 255, 0), 2);
 
             // Add current face and instructions
-            cv::putText(combined_display, "Face: " + std::string(face_orientations[i]), cv::Point(410, 325),
+            cv::putText(combined_display, "Face: " + std::string(face_orientations[i]), cv::Point(410, 365),
                        cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 255), 2);
             cv::putText(combined_display, "Hold " + std::string(face_orientations[i]) + " face to camera",
-                       cv::Point(410, 360), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 255), 2);
+                       cv::Point(410, 400), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 255), 2);
 
             // Show current HSV ranges
             std::string range_text = "H:" + std::to_string(h_min) + "-" + std::to_string(h_max) +
@@ -358,44 +433,6 @@ void PS3EyeCamera::calibrateColors(const std::string& output_filename) {
     std::cout << "\n=== Calibration complete! Values saved to " << output_filename << " ===" << std::endl;
 }
 
-PS3EyeCamera::PS3EyeCamera(int height, int width, int index, int fps) {
-	this->height = height;
-	this->width = width;
-	this->index = index;
-	this->fps = fps;
-
-	video_capture.open(index, cv::CAP_V4L2);
-
-	// Set basic parameters
-	// video_capture.set(cv::CAP_PROP_FRAME_WIDTH, width);
-	// video_capture.set(cv::CAP_PROP_FRAME_HEIGHT, height);
-	video_capture.set(cv::CAP_PROP_FPS, fps);
-	// video_capture.set(cv::CAP_PROP_BUFFERSIZE, 1); // Keep buffer small for real-time
-
-	// Camera settings for stable image using config values
-	// video_capture.set(cv::CAP_PROP_AUTO_WB, 1); // Disable Auto White Balance
-	// video_capture.set(cv::CAP_PROP_AUTO_EXPOSURE, 0); // Disable Auto Exposure
-	// video_capture.set(cv::CAP_PROP_EXPOSURE, config.exposure);
-	// video_capture.set(cv::CAP_PROP_GAIN, config.gain);
-	// video_capture.set(cv::CAP_PROP_BRIGHTNESS, config.brightness);
-	// video_capture.set(cv::CAP_PROP_CONTRAST, config.contrast);
-	// video_capture.set(cv::CAP_PROP_SATURATION, config.saturation);
-
-	if (!video_capture.isOpened()) {
-		std::cerr << "Camera " << index << " could not be opened" << std::endl;
-		throw std::exception();
-	}
-
-	// Warmup with 5 frames to stabilize
-	cv::Mat temp_frames;
-	for (int i = 0; i < 5; i++) {
-		video_capture.read(temp_frames);
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
-	}
-
-	std::cout << "Camera " << index << " initialized successfully" << std::endl;
-}
-
 void draw3DCubeGuide(cv::Mat& display, int face_index, int piece_index) {
     // Draw a small 3D cube in top-left corner (out of the way)
     int cube_size = 80;
@@ -566,7 +603,7 @@ bool PS3EyeCamera::calibratePosition(const std::string &filename) {
     clicked_points.clear();
 
     cv::Mat frame;
-    video_capture.read(frame);
+    capture(frame);
     current_display_frame = &frame;
 
     cv::namedWindow("calibration", cv::WINDOW_NORMAL);
@@ -610,7 +647,7 @@ bool PS3EyeCamera::calibratePosition(const std::string &filename) {
         int key = cv::waitKey(30);
         if (key == ' ') {
             // Refresh camera feed
-            video_capture.read(frame);
+            capture(frame);
             current_display_frame = &frame;
             std::cout << "Camera feed refreshed" << std::endl;
         }
@@ -646,100 +683,22 @@ bool PS3EyeCamera::calibratePosition(const std::string &filename) {
     return true;
 }
 
-void PS3EyeCamera::capture(cv::Mat &frame) {
-	video_capture.read(frame);
-}
-
-void PS3EyeCamera::optimizeForDualCamera() {
-	// Optimize settings for dual camera operation
-	video_capture.set(cv::CAP_PROP_BUFFERSIZE, 1); // Minimal buffer for real-time
-
-	// Clear any buffered frames
-	cv::Mat dummy;
-	for (int i = 0; i < 3; i++) {
-		video_capture.read(dummy);
-	}
 
-	std::cout << "Camera optimized for dual operation (keeping original FPS)" << std::endl;
-}
+using namespace cv;
+// The station the interactive modes work on (cameras, calibration, classifier, sticker state);
+// the "stations" subcommand creates one per rig instead
+static std::unique_ptr<Station> station;
 
+char find_color_lut(Vec3b hsv_pixel) { return station->classifier().classify(hsv_pixel[0], hsv_pixel[1], hsv_pixel[2]); }
 
+// Convert detected color to face character: R->F, B->R, W->U, O->B, G->L, Y->D, unknown stays 'N'
+char colorToFace(char color) { return sticker_state::faceOf(color); }
 
-using namespace cv;
-static Mat global_frame_1, global_frame_2, global_hsv_1, global_hsv_2;
-static char color_lut[180][256][256];
-static std::vector<char> glob_colors_cam_1(24); // 8 pieces per face × 3 faces = 24
-static std::vector<char> glob_colors_cam_2(24); // 8 pieces per face × 3 faces = 24
-
-// Hardcoded center colors for each face (standard cube mapping)
-// Face order: Front, Right, Up, Back, Left, Down
-static const std::map<std::string, char> face_centers = {
-    {"Front", 'R'}, {"Right", 'G'}, {"Up", 'W'},
-    {"Back", 'O'}, {"Left", 'B'}, {"Down", 'Y'}
-};
-static PS3EyeCamera* camera_1 = nullptr;
-static PS3EyeCamera* camera_2 = nullptr;
-
-static std::vector<Point> points_cam_1;
-static std::vector<Point> points_cam_2;
-
-char find_color_lut(Vec3b hsv_pixel) { return color_lut[hsv_pixel[0]][hsv_pixel[1]][hsv_pixel[2]]; }
-
-char colorToFace(char color) {
-	// Convert detected color to face character
-	switch (color) {
-		case 'R': return 'F'; // Red -> Front
-		case 'B': return 'R'; // Blue -> Right
-		case 'W': return 'U'; // White -> Up
-		case 'O': return 'B'; // Orange -> Back
-		case 'G': return 'L'; // Green -> Left
-		case 'Y': return 'D'; // Yellow -> Down
-		case 'N': return 'N'; // Unknown stays unknown
-		default: return 'N';
-	}
-}
+// Inverse of colorToFace()
+char faceToColor(char face) { return sticker_state::colorOf(face); }
 
 void init_lut() {
-	for (int h = 0; h < 180; h++) {
-		for (int s = 0; s < 256; s++) {
-			for (int v = 0; v < 256; v++) {
-				// White - very strict
-				if (s <= 50 && v >= 150) {
-					color_lut[h][s][v] = 'W';
-				}
-				// Red - tighter range
-				else if (((h >= 0 && h <= 8) || (h >= 172 && h <= 179)) && s >= 80 && v >= 80) {
-					color_lut[h][s][v] = 'R';
-				}
-				// Orange - non-overlapping with red
-				else if (h >= 9 && h <= 20 && s >= 100 && v >= 100) {
-					color_lut[h][s][v] = 'O';
-				}
-				// Yellow - non-overlapping
-				else if (h >= 21 && h <= 35 && s >= 80 && v >= 120) {
-					color_lut[h][s][v] = 'Y';
-				}
-				// Green - tighter range
-				else if (h >= 45 && h <= 75 && s >= 60 && v >= 60) {
-					color_lut[h][s][v] = 'G';
-				}
-				// Blue - much tighter range to avoid overlap
-				else if (h >= 100 && h <= 125 && s >= 80 && v >= 80) {
-					color_lut[h][s][v] = 'B';
-				}
-				else {
-					color_lut[h][s][v] = 'N';
-				}
-			}
-		}
-	}
-}
-
-void init_mat() {
-	global_frame_1 = Mat::zeros(config.camera_height, config.camera_width, CV_8UC3);
-	global_frame_2 = Mat::zeros(config.camera_height, config.camera_width, CV_8UC3);
-	global_hsv_1 = Mat::zeros(config.camera_height, config.camera_width, CV_8UC3);
-	global_hsv_2 = Mat::zeros(config.camera_height, config.camera_width, CV_8UC3);
+	station->classifier().loadDefaults();
 }
 
 char findColor(Vec3b hsv_pixel) {
@@ -763,122 +722,55 @@ char findColor(Vec3b hsv_pixel) {
 }
 
 
-void load_position(const std::string &filename_1 , const std::string &filename_2) {
-	std::ifstream in(filename_1);
-	int x, y;
-	for (int i = 0; i < 24; i++) { // 8 pieces × 3 faces = 24 points per camera
-		in >> x >> y;
-		points_cam_1.emplace_back(x, y);
-	}
-	in.close();
-	std::ifstream in_2(filename_2);
-
-	for (int i = 0; i < 24; i++) {
-		in_2 >> x >> y;
-		points_cam_2.emplace_back(x, y);
-	}
-	in_2.close();
-}
-
-void detect_cam_1() {
-	if (camera_1) {
-		camera_1->capture(global_frame_1);
-		if (global_frame_1.empty()) {
-			std::cerr << "Error: Camera 1 frame is empty" << std::endl;
-			return;
-		}
-		cvtColor(global_frame_1, global_hsv_1, COLOR_BGR2HSV);
-
-		for (int i = 0; i < points_cam_1.size(); i++) {
-			int x = points_cam_1[i].x;
-			int y = points_cam_1[i].y;
-
-			// Check bounds before accessing pixel
-			if (x >= 0 && x < global_hsv_1.cols && y >= 0 && y < global_hsv_1.rows) {
-				const auto hsv_pixel = global_hsv_1.at<Vec3b>(y, x);
-				glob_colors_cam_1[i] = find_color_lut(hsv_pixel);
-			} else {
-				std::cerr << "Warning: Point " << i << " (" << x << "," << y << ") is out of bounds for camera 1 frame ("
-						  << global_hsv_1.cols << "x" << global_hsv_1.rows << ")" << std::endl;
-				glob_colors_cam_1[i] = 'N'; // Unknown color for out-of-bounds points
-			}
-		}
-	}
-}
-
-void detect_cam_2() {
-	if (camera_2) {
-		camera_2->capture(global_frame_2);
-		if (global_frame_2.empty()) {
-			std::cerr << "Error: Camera 2 frame is empty" << std::endl;
-			return;
-		}
-		cvtColor(global_frame_2, global_hsv_2, COLOR_BGR2HSV);
-
-		for (int i = 0; i < points_cam_2.size(); i++) {
-			int x = points_cam_2[i].x;
-			int y = points_cam_2[i].y;
-
-			// Check bounds before accessing pixel
-			if (x >= 0 && x < global_hsv_2.cols && y >= 0 && y < global_hsv_2.rows) {
-				const auto hsv_pixel = global_hsv_2.at<Vec3b>(y, x);
-				glob_colors_cam_2[i] = find_color_lut(hsv_pixel);
-			} else {
-				std::cerr << "Warning: Point " << i << " (" << x << "," << y << ") is out of bounds for camera 2 frame ("
-						  << global_hsv_2.cols << "x" << global_hsv_2.rows << ")" << std::endl;
-				glob_colors_cam_2[i] = 'N'; // Unknown color for out-of-bounds points
-			}
-		}
-	}
-}
-
-
 void print_colors() {
 	// Silent function - no individual point output
 }
 
 void load_lut_from_file(const std::string& filename) {
-	// Initialize LUT with 'N' (None)
-	memset(color_lut, 'N', sizeof(color_lut));
-
-	std::ifstream infile(filename);
-	if (!infile.is_open()) {
+	if (!station->classifier().loadFromFile(filename)) {
 		std::cerr << "Could not open LUT file: " << filename << ". Using default hardcoded LUT." << std::endl;
 		init_lut(); // Fallback to the old version
 		return;
 	}
+	std::cout << "Custom color LUT loaded from " << filename << std::endl;
+}
 
-	std::string line;
-	while (std::getline(infile, line)) {
-		std::stringstream ss(line);
-		std::string color_str;
-		int h_min, h_max, s_min, s_max, v_min, v_max;
-
-		ss >> color_str >> h_min >> h_max >> s_min >> s_max >> v_min >> v_max;
+// Checks the compact classifier against the full 180x256x256 table the old code used to build
+void verify_color_lut(const std::string& filename) {
+	std::vector<char> reference;
+	bool all_match = true;
+
+	std::cout << "Checking default ranges..." << std::endl;
+	ColorClassifier::buildReferenceDefaultTable(reference);
+	init_lut();
+	size_t mismatches = station->classifier().compareAgainst(reference);
+	std::cout << "Default ranges: " << mismatches << " mismatches out of " << kColorTableSize << " cells" << std::endl;
+	all_match &= mismatches == 0;
+
+	if (ColorClassifier::buildReferenceTableFromFile(filename, reference)) {
+		std::cout << "Checking ranges from " << filename << "..." << std::endl;
+		load_lut_from_file(filename);
+		mismatches = station->classifier().compareAgainst(reference);
+		std::cout << filename << ": " << mismatches << " mismatches out of " << kColorTableSize << " cells" << std::endl;
+		all_match &= mismatches == 0;
+	} else {
+		std::cout << "No " << filename << " found, skipping custom range check" << std::endl;
+	}
 
-		char color;
-		if (color_str == "R2") {
-			// Red wraparound range (170-179) - treat as regular red
-			color = 'R';
-		} else {
-			color = color_str[0];
-		}
+	std::cout << (all_match ? "✓ Compact LUT matches the full table" : "✗ Compact LUT differs from the full table")
+			  << std::endl;
 
-		// Handle red's hue wrap-around where h_min > h_max
-		bool red_wrap = (color == 'R' && h_min > h_max);
+	const sticker_kernel::Isa isa = sticker_kernel::detectIsa();
+	std::cout << "Checking the " << sticker_kernel::isaName(isa) << " sticker kernel against scalar over all BGR values..."
+			  << std::endl;
+	mismatches = sticker_kernel::selfTest(station->classifier());
+	std::cout << (mismatches == 0 ? "✓ Sticker kernel matches the scalar path" : "✗ Sticker kernel differs from the scalar path")
+			  << " (" << mismatches << " mismatches)" << std::endl;
 
-		for (int h = 0; h < 180; ++h) {
-			bool h_in_range = red_wrap ? (h >= h_min || h <= h_max) : (h >= h_min && h <= h_max);
-			if (h_in_range) {
-				for (int s = s_min; s <= s_max; ++s) {
-					for (int v = v_min; v <= v_max; ++v) {
-						color_lut[h][s][v] = color;
-					}
-				}
-			}
-		}
-	}
-	std::cout << "Custom color LUT loaded from " << filename << std::endl;
+	std::cout << "Checking YUYV sticker sampling against cvtColor over all YUV values..." << std::endl;
+	mismatches = yuyv::selfTest();
+	std::cout << (mismatches == 0 ? "✓ YUYV sampling matches cvtColor" : "✗ YUYV sampling differs from cvtColor")
+			  << " (" << mismatches << " mismatches)" << std::endl;
 }
 
 int process() {
@@ -906,11 +798,6 @@ int process() {
 	return 0;
 }
 
-void benchmark() {
-	detect_cam_1();
-	detect_cam_2();
-}
-
 
 
 void show_camera_setup_guide() {
@@ -937,17 +824,7 @@ void show_camera_setup_guide() {
 }
 
 void show_dual_camera_feed(PS3EyeCamera *camera_1, PS3EyeCamera *camera_2) {
-	Mat frame1, frame2, display1, display2;
-
-	// Create windows
-	namedWindow("Camera 1 (Up/Right/Front)", WINDOW_NORMAL);
-	namedWindow("Camera 2 (Down/Left/Back)", WINDOW_NORMAL);
-	resizeWindow("Camera 1 (Up/Right/Front)", 640, 480);
-	resizeWindow("Camera 2 (Down/Left/Back)", 640, 480);
-
-	// Position windows side by side
-	moveWindow("Camera 1 (Up/Right/Front)", 50, 50);
-	moveWindow("Camera 2 (Down/Left/Back)", 720, 50);
+	Mat frame1, frame2;
 
 	std::cout << "\n=== Dual Camera Feed ===" << std::endl;
 	std::cout << "Use this to position your cameras to see the cube properly." << std::endl;
@@ -962,23 +839,30 @@ void show_dual_camera_feed(PS3EyeCamera *camera_1, PS3EyeCamera *camera_2) {
 	bool show_fps = false;
 	auto last_time = std::chrono::high_resolution_clock::now();
 	double fps = 0.0;
+	auto flash_until = std::chrono::steady_clock::now();
 
 	// Initial warmup - clear any buffered frames
 	std::cout << "Warming up cameras..." << std::endl;
 	for (int i = 0; i < 5; i++) {
-		camera_1->capture(frame1);
-		camera_2->capture(frame2);
+		camera_1->captureRaw(frame1);
+		camera_2->captureRaw(frame2);
 		std::this_thread::sleep_for(std::chrono::milliseconds(50));
 	}
 	std::cout << "Ready!" << std::endl;
 
-	while (true) {
-		auto start_time = std::chrono::high_resolution_clock::now();
+	// Windows are drawn on the render thread; this loop only captures, waiting for each new frame
+	DebugView view({{"Camera 1 (Up/Right/Front)", 50, 50}, {"Camera 2 (Down/Left/Back)", 720, 50}},
+				   config.debug_render_fps, config.debug_render_opencl);
 
+	uint64_t seen_1 = 0, seen_2 = 0;
+	while (true) {
 		try {
+			// Fresh frames every time: the render thread may still be reading the previous ones
+			frame1 = Mat();
+			frame2 = Mat();
 			// Capture from both cameras simultaneously
-			camera_1->capture(frame1);
-			camera_2->capture(frame2);
+			camera_1->captureNewRaw(frame1, seen_1);
+			camera_2->captureNewRaw(frame2, seen_2);
 
 			if (frame1.empty() || frame2.empty()) {
 				std::cout << "Warning: Could not capture from one or both cameras" << std::endl;
@@ -986,26 +870,7 @@ void show_dual_camera_feed(PS3EyeCamera *camera_1, PS3EyeCamera *camera_2) {
 				continue;
 			}
 
-			// Create display frames with info overlays
-			display1 = frame1.clone();
-			display2 = frame2.clone();
-
-			// Add labels and info to frames
-			cv::putText(display1, "Camera 1: Up/Right/Front", cv::Point(10, 30),
-						cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
-			cv::putText(display1, "Expected: Up/Right/Front faces", cv::Point(10, 60),
-						cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
-			cv::putText(display1, "Index: 4", cv::Point(10, 90),
-						cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
-
-			cv::putText(display2, "Camera 2: Down/Left/Back", cv::Point(10, 30),
-						cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
-			cv::putText(display2, "Expected: Down/Left/Back faces", cv::Point(10, 60),
-						cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
-			cv::putText(display2, "Index: 5", cv::Point(10, 90),
-						cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
-
-			// Calculate FPS
+			// Calculate FPS (of the capture loop, not of the display)
 			auto current_time = std::chrono::high_resolution_clock::now();
 			auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - last_time);
 			if (duration.count() > 1000) { // Update FPS every second
@@ -1015,25 +880,39 @@ void show_dual_camera_feed(PS3EyeCamera *camera_1, PS3EyeCamera *camera_2) {
 			}
 
 			// Add frame counter and FPS
-			std::string info1 = "Frame: " + std::to_string(frame_count);
-			std::string info2 = "Frame: " + std::to_string(frame_count);
+			std::string info = "Frame: " + std::to_string(frame_count);
 			if (show_fps) {
-				info1 += " | FPS: " + std::to_string((int)fps);
-				info2 += " | FPS: " + std::to_string((int)fps);
+				info += " | FPS: " + std::to_string((int)fps);
 			}
+			const bool flash = std::chrono::steady_clock::now() < flash_until;
 
-			cv::putText(display1, info1, cv::Point(10, display1.rows - 10),
-						cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255), 1);
-			cv::putText(display2, info2, cv::Point(10, display2.rows - 10),
-						cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255), 1);
-
-			// Draw grid overlay to help with positioning
-			drawPositioningGrid(display1);
-			drawPositioningGrid(display2);
+			view.show(frame1, frame2, [info, flash](Mat& display, int camera) {
+				if (flash) { // Snapshot flash effect
+					display.setTo(Scalar(255, 255, 255));
+					return;
+				}
+				// Add labels and info to frames
+				if (camera == 0) {
+					cv::putText(display, "Camera 1: Up/Right/Front", cv::Point(10, 30),
+								cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
+					cv::putText(display, "Expected: Up/Right/Front faces", cv::Point(10, 60),
+								cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+					cv::putText(display, "Index: 4", cv::Point(10, 90),
+								cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+				} else {
+					cv::putText(display, "Camera 2: Down/Left/Back", cv::Point(10, 30),
+								cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
+					cv::putText(display, "Expected: Down/Left/Back faces", cv::Point(10, 60),
+								cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+					cv::putText(display, "Index: 5", cv::Point(10, 90),
+								cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+				}
+				cv::putText(display, info, cv::Point(10, display.rows - 10),
+							cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255), 1);
 
-			// Display frames
-			imshow("Camera 1 (Up/Right/Front)", display1);
-			imshow("Camera 2 (Down/Left/Back)", display2);
+				// Draw grid overlay to help with positioning
+				drawPositioningGrid(display);
+			});
 
 			frame_count++;
 
@@ -1041,8 +920,8 @@ void show_dual_camera_feed(PS3EyeCamera *camera_1, PS3EyeCamera *camera_2) {
 			std::cerr << "Exception during capture: " << e.what() << std::endl;
 		}
 
-		// Handle keyboard input with shorter delay for smoother display
-		int key = waitKey(1) & 0xFF; // ~60 FPS max display rate
+		// Keys pressed in either window
+		int key = view.key();
 		if (key == 27 || key == 'q' || key == 'Q') { // ESC or Q
 			break;
 		}
@@ -1050,28 +929,27 @@ void show_dual_camera_feed(PS3EyeCamera *camera_1, PS3EyeCamera *camera_2) {
 			show_fps = !show_fps;
 			std::cout << "FPS display: " << (show_fps ? "ON" : "OFF") << std::endl;
 		}
-		else if (key == ' ') { // SPACE - take snapshot
+		else if (key == ' ' && !frame1.empty() && !frame2.empty()) { // SPACE - take snapshot
 			std::string timestamp = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
 				std::chrono::system_clock::now().time_since_epoch()).count());
 
 			std::string filename1 = "camera1_snapshot_" + timestamp + ".jpg";
 			std::string filename2 = "camera2_snapshot_" + timestamp + ".jpg";
 
-			imwrite(filename1, frame1);
-			imwrite(filename2, frame2);
+			Mat bgr1, bgr2;
+			yuyv::toBgr(frame1, bgr1);
+			yuyv::toBgr(frame2, bgr2);
+			imwrite(filename1, bgr1);
+			imwrite(filename2, bgr2);
 
 			std::cout << "📸 Snapshots saved: " << filename1 << ", " << filename2 << std::endl;
 
 			// Flash effect
-			Mat white1 = Mat::ones(frame1.size(), frame1.type()) * 255;
-			Mat white2 = Mat::ones(frame2.size(), frame2.type()) * 255;
-			imshow("Camera 1 (Up/Right/Front)", white1);
-			imshow("Camera 2 (Down/Left/Back)", white2);
-			waitKey(100);
+			flash_until = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
 		}
 	}
 
-	cv::destroyAllWindows();
+	view.printStats();
 	std::cout << "Camera feed closed." << std::endl;
 }
 
@@ -1104,7 +982,8 @@ void drawPositioningGrid(Mat& frame) {
 		 Scalar(0, 255, 0), 2);
 }
 
-void loadConfig(const std::string& filename) {
+// Reads one rig's settings into `config` (the global one for everything but multi-station runs)
+void loadConfig(const std::string& filename, Config& config) {
 	std::ifstream configFile(filename);
 	if (!configFile.is_open()) {
 		std::cout << "Warning: Could not open config file " << filename << ". Using default values." << std::endl;
@@ -1128,7 +1007,9 @@ void loadConfig(const std::string& filename) {
 		std::string value = line.substr(pos + 1);
 
 		// Parse configuration values
-		if (key == "CAMERA_1_INDEX") {
+		if (key == "STATION_NAME") {
+			config.station_name = value;
+		} else if (key == "CAMERA_1_INDEX") {
 			config.camera_1_index = std::stoi(value);
 		} else if (key == "CAMERA_2_INDEX") {
 			config.camera_2_index = std::stoi(value);
@@ -1148,6 +1029,114 @@ void loadConfig(const std::string& filename) {
 			config.contrast = std::stoi(value);
 		} else if (key == "SATURATION") {
 			config.saturation = std::stoi(value);
+		} else if (key == "POSITION_FILE_1") {
+			config.position_file_1 = value;
+		} else if (key == "POSITION_FILE_2") {
+			config.position_file_2 = value;
+		} else if (key == "COLOR_RANGE_FILE") {
+			config.color_range_file = value;
+		} else if (key == "CALIBRATION_BUNDLE") {
+			config.calibration_bundle = value;
+		} else if (key == "CALIBRATION_HOT_RELOAD") {
+			config.calibration_hot_reload = std::stoi(value) != 0;
+		} else if (key == "DETECT_CPU_1") {
+			config.detect_cpu_1 = std::stoi(value);
+		} else if (key == "DETECT_CPU_2") {
+			config.detect_cpu_2 = std::stoi(value);
+		} else if (key == "ENSEMBLE_CPU_1") {
+			config.ensemble_cpu_1 = std::stoi(value);
+		} else if (key == "ENSEMBLE_CPU_2") {
+			config.ensemble_cpu_2 = std::stoi(value);
+		} else if (key == "STREAMING_CAPTURE") {
+			config.streaming_capture = std::stoi(value) != 0;
+		} else if (key == "CAPTURE_RING_SIZE") {
+			config.capture_ring_size = std::max(2, std::stoi(value));
+		} else if (key == "SYNC_FRAMES") {
+			config.sync_frames = std::stoi(value) != 0;
+		} else if (key == "SYNC_MAX_SKEW_US") {
+			config.sync_max_skew_us = std::max(0, std::stoi(value));
+		} else if (key == "SYNC_TIMEOUT_MS") {
+			config.sync_timeout_ms = std::max(0, std::stoi(value));
+		} else if (key == "SOLVER_THREADS") {
+			config.solver_threads = std::max(1, std::stoi(value));
+		} else if (key == "SOLVER_TIME_LIMIT_MS") {
+			config.solver_time_limit_ms = std::max(1, std::stoi(value));
+		} else if (key == "SOLVER_MAX_LENGTH") {
+			config.solver_max_length = std::stoi(value);
+		} else if (key == "SOLVER_SPLITS") {
+			config.solver_splits = std::max(1, std::stoi(value));
+		} else if (key == "SOLVER_LIMIT_ENGINES") {
+			config.solver_limit_engines = std::clamp(std::stoi(value), 1, 8);
+		} else if (key == "SOLVER_TABLE_FULL_CHECK") {
+			config.solver_table_full_check = std::stoi(value) != 0;
+		} else if (key == "SOLVER_MAX_CANDIDATES") {
+			config.solver_max_candidates = std::max(1, std::stoi(value));
+		} else if (key == "SOLUTION_CACHE_SIZE") {
+			config.solution_cache_size = std::max(0, std::stoi(value));
+		} else if (key == "SOLUTION_CACHE_FILE") {
+			config.solution_cache_file = value;
+		} else if (key == "REPLAY_FILE") {
+			config.replay_file = value;
+		} else if (key == "REPLAY_REALTIME") {
+			config.replay_realtime = std::stoi(value) != 0;
+		} else if (key == "SAMPLE_PATCH_SIZE") {
+			config.sample_patch_size = std::max(1, std::stoi(value));
+		} else if (key == "SAMPLE_PATCH_STEP") {
+			config.sample_patch_step = std::max(1, std::stoi(value));
+		} else if (key == "VOTE_MIN_CONFIDENCE") {
+			config.vote_min_confidence = std::stof(value);
+		} else if (key == "VOTE_MAX_FRAMES") {
+			config.vote_max_frames = std::max(1, std::stoi(value));
+		} else if (key == "ACCUMULATE_STABLE_FRAMES") {
+			config.accumulate_stable_frames = std::max(1, std::stoi(value));
+		} else if (key == "ACCUMULATE_TIMEOUT_MS") {
+			config.accumulate_timeout_ms = std::max(0, std::stoi(value));
+		} else if (key == "REPAIR_MAX_STICKERS") {
+			config.repair_max_stickers = std::clamp(std::stoi(value), 0, 8);
+		} else if (key == "DETECTOR") {
+			config.detector = value;
+		} else if (key == "CAPTURE_BACKEND") {
+			config.capture_backend = value;
+		} else if (key == "CAPTURE_BUFFERS") {
+			config.capture_buffers = std::clamp(std::stoi(value), 2, 32);
+		} else if (key == "PIPELINE_QUEUE_DEPTH") {
+			config.pipeline_queue_depth = std::max(1, std::stoi(value));
+		} else if (key == "TRACE") {
+			config.trace = (value == "1" || value == "true");
+		} else if (key == "TRACE_METRICS_FILE") {
+			config.trace_metrics_file = value;
+		} else if (key == "TRACE_CHROME_FILE") {
+			config.trace_chrome_file = value;
+		} else if (key == "TRACE_EXPORT_INTERVAL_MS") {
+			config.trace_export_interval_ms = std::max(100, std::stoi(value));
+		} else if (key == "DEBUG_RENDER_FPS") {
+			config.debug_render_fps = std::clamp(std::stoi(value), 1, 120);
+		} else if (key == "DEBUG_RENDER_OPENCL") {
+			config.debug_render_opencl = std::stoi(value) != 0;
+		} else if (key == "WHITE_BALANCE") {
+			config.white_balance = std::stoi(value) != 0;
+		} else if (key == "WHITE_BALANCE_STATS") {
+			config.white_balance_stats = std::stoi(value) != 0;
+		} else if (key == "ROI_TRACKING") {
+			config.roi_tracking = std::stoi(value) != 0;
+		} else if (key == "ROI_TRACK_INTERVAL") {
+			config.roi_track_interval = std::max(1, std::stoi(value));
+		} else if (key == "ROI_TRACK_SEARCH_PX") {
+			config.roi_track_search_px = std::clamp(std::stoi(value), 1, 64);
+		} else if (key == "ROI_TRACK_BUDGET_US") {
+			config.roi_track_budget_us = std::max(100, std::stoi(value));
+		} else if (key == "ROI_TRACK_MIN_SCORE") {
+			config.roi_track_min_score = std::clamp(std::stof(value), 0.0f, 1.0f);
+		} else if (key == "SOLVE_PARALLELISM") {
+			config.solve_parallelism = std::max(1, std::stoi(value));
+		} else if (key == "SOLVE_SERVER_ADDRESS") {
+			config.solve_server_address = value;
+		} else if (key == "SOLVE_SERVER_PORT") {
+			config.solve_server_port = std::clamp(std::stoi(value), 0, 65535);
+		} else if (key == "DEADLINE_MS") {
+			config.deadline_ms = std::max(1, std::stoi(value));
+		} else if (key == "DEADLINE_SOLVE_RESERVE_MS") {
+			config.deadline_solve_reserve_ms = std::max(1, std::stoi(value));
 		}
 	}
 
@@ -1158,185 +1147,26 @@ void loadConfig(const std::string& filename) {
 	std::cout << "  Resolution: " << config.camera_width << "x" << config.camera_height << std::endl;
 }
 
-void initializeCameras() {
-	if (camera_1) {
-		delete camera_1;
-		camera_1 = nullptr;
-	}
-	if (camera_2) {
-		delete camera_2;
-		camera_2 = nullptr;
-	}
-
-	try {
-		camera_1 = new PS3EyeCamera(config.camera_height, config.camera_width, config.camera_1_index, 187);
-		camera_2 = new PS3EyeCamera(config.camera_height, config.camera_width, config.camera_2_index, 187);
-	} catch (const std::exception& e) {
-		std::cerr << "Error initializing cameras: " << e.what() << std::endl;
-		if (camera_1) {
-			delete camera_1;
-			camera_1 = nullptr;
-		}
-		if (camera_2) {
-			delete camera_2;
-			camera_2 = nullptr;
-		}
-		throw;
-	}
+// Creates the interactive station for the loaded config
+static void create_station() {
+	station = std::make_unique<Station>(config, std::make_shared<ColorClassifier>());
 }
 
-
-void parallel_benchmark() {
-	const auto start = std::chrono::high_resolution_clock::now();
-
-	std::thread t1(detect_cam_1);
-	std::thread t2(detect_cam_2);
-
-	// #pragma omp parallel sections
-	// 	{
-	// #pragma omp section
-	// 		detect_cam_1();
-	//
-	// #pragma omp section
-	// 		detect_cam_2();
-	// 	}
-	t1.join();
-	t2.join();
-
-	// Future: add cube state assembly and validation here
-	const auto end = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> duration = end - start;
-	std::cout << "Dual camera time: " << duration.count() << " seconds" << std::endl;
-}
-
-
-bool validateCube() {
-	std::map<char, int> face_counts;
-
-	// Count faces from both cameras (edge/corner pieces only) - convert colors to faces
-	for (const auto& color : glob_colors_cam_1) {
-		face_counts[colorToFace(color)]++;
-	}
-	for (const auto& color : glob_colors_cam_2) {
-		face_counts[colorToFace(color)]++;
-	}
-
-	// Add hardcoded center pieces (1 of each face)
-	face_counts['U']++; // Up center
-	face_counts['R']++; // Right center
-	face_counts['F']++; // Front center
-	face_counts['D']++; // Down center
-	face_counts['L']++; // Left center
-	face_counts['B']++; // Back center
-
-	// Check that we have exactly 9 of each expected face (8 detected + 1 center)
-	const char expected_faces[] = {'U', 'R', 'F', 'D', 'L', 'B'};
-	bool is_valid = true;
-
-	std::cout << "\n=== Cube Validation ===" << std::endl;
-	std::cout << "Detected pieces: 54 total (48 detected + 6 hardcoded centers)" << std::endl;
-
-	for (char face : expected_faces) {
-		int detected_count = face_counts[face] - 1; // Subtract the hardcoded center
-		int total_count = face_counts[face];
-
-		std::cout << "Face " << face << ": " << detected_count << " detected + 1 center = "
-				  << total_count << " total";
-		if (total_count == 9) {
-			std::cout << " ✓" << std::endl;
-		} else {
-			std::cout << " ✗ (expected 9)" << std::endl;
-			is_valid = false;
-		}
-	}
-
-	// Check for unknown faces
-	int unknown_count = face_counts['N'];
-	if (unknown_count > 0) {
-		std::cout << "Unknown/Undetected: " << unknown_count << " stickers ✗" << std::endl;
-		is_valid = false;
-	}
-
-	if (is_valid) {
-		std::cout << "✓ Cube validation PASSED - All faces detected correctly!" << std::endl;
-	} else {
-		std::cout << "✗ Cube validation FAILED - Face count mismatch!" << std::endl;
-	}
-
-	return is_valid;
+void initializeCameras() {
+	if (!station) create_station();
+	station->openCameras();
 }
 
-// Structure to represent cube orientation mapping
-struct CubeOrientation {
-	// Maps camera positions to face characters
-	// cam1_faces[0] = Up face, cam1_faces[1] = Right face, cam1_faces[2] = Front face
-	// cam2_faces[0] = Down face, cam2_faces[1] = Left face, cam2_faces[2] = Back face
-	char cam1_faces[3];
-	char cam2_faces[3];
-
-	CubeOrientation(char up, char right, char front, char down, char left, char back) {
-		cam1_faces[0] = up;
-		cam1_faces[1] = right;
-		cam1_faces[2] = front;
-		cam2_faces[0] = down;
-		cam2_faces[1] = left;
-		cam2_faces[2] = back;
-	}
-};
 
 // Generate all 24 possible cube orientations
 std::vector<CubeOrientation> generateAllOrientations() {
-	std::vector<CubeOrientation> orientations;
-
-	// Define the 24 standard cube orientations (6 faces × 4 rotations each)
-	// Using standard cube notation: U=Up, R=Right, F=Front, D=Down, L=Left, B=Back
-
-	// White (U) up orientations
-	orientations.emplace_back('U', 'R', 'F', 'D', 'L', 'B'); // Standard
-	orientations.emplace_back('U', 'F', 'L', 'D', 'B', 'R'); // 90° rotation
-	orientations.emplace_back('U', 'L', 'B', 'D', 'R', 'F'); // 180° rotation
-	orientations.emplace_back('U', 'B', 'R', 'D', 'F', 'L'); // 270° rotation
-
-	// Yellow (D) up orientations
-	orientations.emplace_back('D', 'R', 'B', 'U', 'L', 'F');
-	orientations.emplace_back('D', 'B', 'L', 'U', 'F', 'R');
-	orientations.emplace_back('D', 'L', 'F', 'U', 'R', 'B');
-	orientations.emplace_back('D', 'F', 'R', 'U', 'B', 'L');
-
-	// Red (R) up orientations
-	orientations.emplace_back('R', 'U', 'F', 'L', 'B', 'D');
-	orientations.emplace_back('R', 'F', 'D', 'L', 'U', 'B');
-	orientations.emplace_back('R', 'D', 'B', 'L', 'F', 'U');
-	orientations.emplace_back('R', 'B', 'U', 'L', 'D', 'F');
-
-	// Orange (L) up orientations
-	orientations.emplace_back('L', 'U', 'B', 'R', 'F', 'D');
-	orientations.emplace_back('L', 'B', 'D', 'R', 'U', 'F');
-	orientations.emplace_back('L', 'D', 'F', 'R', 'B', 'U');
-	orientations.emplace_back('L', 'F', 'U', 'R', 'D', 'B');
-
-	// Green (F) up orientations
-	orientations.emplace_back('F', 'U', 'R', 'B', 'L', 'D');
-	orientations.emplace_back('F', 'R', 'D', 'B', 'U', 'L');
-	orientations.emplace_back('F', 'D', 'L', 'B', 'R', 'U');
-	orientations.emplace_back('F', 'L', 'U', 'B', 'D', 'R');
-
-	// Blue (B) up orientations
-	orientations.emplace_back('B', 'U', 'L', 'F', 'R', 'D');
-	orientations.emplace_back('B', 'L', 'D', 'F', 'U', 'R');
-	orientations.emplace_back('B', 'D', 'R', 'F', 'L', 'U');
-	orientations.emplace_back('B', 'R', 'U', 'F', 'D', 'L');
-
-	return orientations;
+	return {kCubeOrientations.begin(), kCubeOrientations.end()};
 }
 
-std::string generateFaceString(const CubeOrientation& orientation) {
-	// Generate cube state string in face order: UP, RIGHT, FRONT, DOWN, LEFT, BACK
-	// Each face: 9 positions in row-major order (54 characters total)
-
+// Previous map-based implementation, kept as the baseline for the face string microbenchmark
+static std::string generateFaceStringReference(const CubeOrientation& orientation) {
 	std::string cube_state(54, 'N'); // Initialize with 'N' (unknown)
 
-	// Output order: U(0-8), R(9-17), F(18-26), D(27-35), L(36-44), B(45-53)
 	// Face indices for our detected pieces (skip centers)
 	std::map<char, std::vector<int>> face_indices = {
 		{'U', {0, 1, 2, 3, 5, 6, 7, 8}},          // skip center at 4
@@ -1347,57 +1177,83 @@ std::string generateFaceString(const CubeOrientation& orientation) {
 		{'B', {45, 46, 47, 48, 50, 51, 52, 53}}   // skip center at 49
 	};
 
-	// Map detected pieces to faces based on orientation
-	// Camera 1 data (24 pieces): [0-7] face0, [8-15] face1, [16-23] face2
 	for (int cam_face = 0; cam_face < 3; cam_face++) {
-		char target_face = orientation.cam1_faces[cam_face];
-		const std::vector<int>& indices = face_indices[target_face];
-
+		const std::vector<int>& indices_1 = face_indices[orientation.cam1_faces[cam_face]];
+		const std::vector<int>& indices_2 = face_indices[orientation.cam2_faces[cam_face]];
 		for (int i = 0; i < 8; i++) {
-			int global_index = cam_face * 8 + i;
-			if (global_index < glob_colors_cam_1.size()) {
-				// Convert detected color using the standard colorToFace mapping
-				char detected_color = glob_colors_cam_1[global_index];
-				char face_color = colorToFace(detected_color);
-				cube_state[indices[i]] = face_color;
-			}
-		}
-	}
-
-	// Camera 2 data (24 pieces): [0-7] face0, [8-15] face1, [16-23] face2
-	for (int cam_face = 0; cam_face < 3; cam_face++) {
-		char target_face = orientation.cam2_faces[cam_face];
-		const std::vector<int>& indices = face_indices[target_face];
-
-		for (int i = 0; i < 8; i++) {
-			int global_index = cam_face * 8 + i;
-			if (global_index < glob_colors_cam_2.size()) {
-				// Convert detected color using the standard colorToFace mapping
-				char detected_color = glob_colors_cam_2[global_index];
-				char face_color = colorToFace(detected_color);
-				cube_state[indices[i]] = face_color;
-			}
+			cube_state[indices_1[i]] = colorToFace(station->colors(0)[cam_face * 8 + i]);
+			cube_state[indices_2[i]] = colorToFace(station->colors(1)[cam_face * 8 + i]);
 		}
 	}
 
-	// Fill in center pieces based on orientation (use face letters not colors)
-	cube_state[4] = orientation.cam1_faces[0];   // Up center
-	cube_state[13] = orientation.cam1_faces[1];  // Right center
-	cube_state[22] = orientation.cam1_faces[2];  // Front center
-	cube_state[31] = orientation.cam2_faces[0];  // Down center
-	cube_state[40] = orientation.cam2_faces[1];  // Left center
-	cube_state[49] = orientation.cam2_faces[2];  // Back center
+	cube_state[4] = orientation.cam1_faces[0];
+	cube_state[13] = orientation.cam1_faces[1];
+	cube_state[22] = orientation.cam1_faces[2];
+	cube_state[31] = orientation.cam2_faces[0];
+	cube_state[40] = orientation.cam2_faces[1];
+	cube_state[49] = orientation.cam2_faces[2];
 
 	return cube_state;
 }
 
 // Backwards compatible version using default orientation
 std::string generateFaceString() {
-	CubeOrientation default_orientation('U', 'R', 'F', 'D', 'L', 'B');
-	return generateFaceString(default_orientation);
+	std::array<char, 54> cube_state;
+	station->faceString(0, cube_state); // kCubeOrientations[0] is the standard orientation
+	return {cube_state.begin(), cube_state.end()};
 }
 
 
+// Microbenchmark: face strings per second for the map-based and the table-driven builder
+void benchmark_face_string() {
+	const std::vector<char> saved_1 = station->colors(0), saved_2 = station->colors(1);
+	const char colors[] = {'W', 'R', 'G', 'Y', 'O', 'B'};
+	uint32_t seed = 12345;
+	for (int i = 0; i < 24; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		station->colors(0)[i] = colors[(seed >> 16) % 6];
+		seed = seed * 1664525u + 1013904223u;
+		station->colors(1)[i] = colors[(seed >> 16) % 6];
+	}
+
+	// Both builders must agree on every orientation before they are compared for speed
+	std::array<char, 54> cube_state;
+	for (size_t o = 0; o < kCubeOrientations.size(); o++) {
+		station->faceString(o, cube_state);
+		if (std::string(cube_state.begin(), cube_state.end()) != generateFaceStringReference(kCubeOrientations[o])) {
+			std::cerr << "✗ Face string mismatch for orientation " << o << std::endl;
+		}
+	}
+
+	constexpr int kRounds = 20000;
+	size_t checksum = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < kRounds; r++) {
+		for (const auto& orientation : kCubeOrientations) {
+			checksum += generateFaceStringReference(orientation)[r % 54];
+		}
+	}
+	const double before_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < kRounds; r++) {
+		for (size_t o = 0; o < kCubeOrientations.size(); o++) {
+			station->faceString(o, cube_state);
+			checksum += cube_state[r % 54];
+		}
+	}
+	const double after_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const double calls = static_cast<double>(kRounds) * kCubeOrientations.size();
+	std::cout << "std::map + std::string: " << calls / before_s / 1e6 << " M calls/s" << std::endl;
+	std::cout << "constexpr facelet maps: " << calls / after_s / 1e6 << " M calls/s" << std::endl;
+	std::cout << "Speedup: " << before_s / after_s << "x (checksum " << checksum << ")" << std::endl;
+
+	station->colors(0) = saved_1;
+	station->colors(1) = saved_2;
+}
+
 void printCubeState() {
 	std::string cube_faces = generateFaceString();
 
@@ -1405,24 +1261,17 @@ void printCubeState() {
 }
 
 void visual_debug_detection() {
-	if (!camera_1 || !camera_2) {
+	if (!station->camera(0) || !station->camera(1)) {
 		std::cerr << "Cameras not initialized!" << std::endl;
 		return;
 	}
 
 	// Check if position files exist
-	if (points_cam_1.empty() || points_cam_2.empty()) {
+	if (station->points(0).empty() || station->points(1).empty()) {
 		std::cerr << "No calibration points loaded. Please run position calibration first." << std::endl;
 		return;
 	}
 
-	cv::namedWindow("Debug Camera 1", cv::WINDOW_NORMAL);
-	cv::namedWindow("Debug Camera 2", cv::WINDOW_NORMAL);
-	cv::resizeWindow("Debug Camera 1", 640, 480);
-	cv::resizeWindow("Debug Camera 2", 640, 480);
-	cv::moveWindow("Debug Camera 1", 50, 50);
-	cv::moveWindow("Debug Camera 2", 720, 50);
-
 	std::cout << "\n=== Visual Debug Detection Mode ===" << std::endl;
 	std::cout << "Controls:" << std::endl;
 	std::cout << "  SPACE = Detect colors and show on points" << std::endl;
@@ -1432,7 +1281,7 @@ void visual_debug_detection() {
 	bool show_colors = false;
 
 	// Face color mapping for visualization
-	std::map<char, cv::Scalar> face_color_map = {
+	const std::map<char, cv::Scalar> face_color_map = {
 		{'W', cv::Scalar(255, 255, 255)}, // Up face (White)
 		{'R', cv::Scalar(0, 0, 255)},     // Front face (Red)
 		{'O', cv::Scalar(0, 165, 255)},   // Back face (Orange)
@@ -1441,103 +1290,78 @@ void visual_debug_detection() {
 		{'B', cv::Scalar(255, 0, 0)},     // Left face (Blue)
 		{'N', cv::Scalar(128, 128, 128)}  // Unknown/Gray
 	};
+	const float min_confidence = config.vote_min_confidence;
 
+	// Windows are drawn on the render thread at DEBUG_RENDER_FPS; this loop captures and detects
+	DebugView view({{"Debug Camera 1", 50, 50}, {"Debug Camera 2", 720, 50}}, config.debug_render_fps,
+				   config.debug_render_opencl);
+
+	uint64_t seen[2] = {0, 0};
 	while (true) {
-		cv::Mat frame1, frame2, display1, display2;
+		cv::Mat frame1, frame2;
 
-		// Capture frames
-		camera_1->capture(frame1);
-		camera_2->capture(frame2);
+		// Capture frames; waiting for new ones keeps the loop at the camera's rate
+		station->camera(0)->captureNewRaw(frame1, seen[0]);
+		station->camera(1)->captureNewRaw(frame2, seen[1]);
 
 		if (frame1.empty() || frame2.empty()) {
 			std::this_thread::sleep_for(std::chrono::milliseconds(50));
 			continue;
 		}
 
-		display1 = frame1.clone();
-		display2 = frame2.clone();
-
-		// Draw calibration points
-		for (int i = 0; i < points_cam_1.size(); i++) {
-			cv::Point pt = points_cam_1[i];
-
-			if (show_colors && i < glob_colors_cam_1.size()) {
-				// Show detected color converted to face
-				char detected_face = colorToFace(glob_colors_cam_1[i]);
-				cv::Scalar color = face_color_map[detected_face];
-
-				// Draw filled circle with detected color
-				cv::circle(display1, pt, 8, color, -1);
-				// Draw black border for visibility
-				cv::circle(display1, pt, 8, cv::Scalar(0, 0, 0), 2);
-
-				// Add face text
-				cv::putText(display1, std::string(1, detected_face),
-						   cv::Point(pt.x + 12, pt.y + 5),
-						   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 2);
-			} else {
-				// Just show calibration points
-				cv::circle(display1, pt, 5, cv::Scalar(0, 255, 0), 2);
-				cv::putText(display1, std::to_string(i + 1),
-						   cv::Point(pt.x + 8, pt.y - 8),
-						   cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(0, 255, 0), 1);
-			}
-		}
-
-		for (int i = 0; i < points_cam_2.size(); i++) {
-			cv::Point pt = points_cam_2[i];
-
-			if (show_colors && i < glob_colors_cam_2.size()) {
-				// Show detected color converted to face
-				char detected_face = colorToFace(glob_colors_cam_2[i]);
-				cv::Scalar color = face_color_map[detected_face];
-
-				// Draw filled circle with detected color
-				cv::circle(display2, pt, 8, color, -1);
-				// Draw black border for visibility
-				cv::circle(display2, pt, 8, cv::Scalar(0, 0, 0), 2);
-
-				// Add face text
-				cv::putText(display2, std::string(1, detected_face),
-						   cv::Point(pt.x + 12, pt.y + 5),
-						   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 2);
-			} else {
-				// Just show calibration points
-				cv::circle(display2, pt, 5, cv::Scalar(0, 255, 0), 2);
-				cv::putText(display2, std::to_string(i + 1),
-						   cv::Point(pt.x + 8, pt.y - 8),
-						   cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(0, 255, 0), 1);
+		// The overlay runs on the render thread, so it gets its own copy of the detection results
+		const std::vector<cv::Point> points[2] = {station->points(0), station->points(1)};
+		const std::vector<char> colors[2] = {station->colors(0), station->colors(1)};
+		const std::vector<float> confidence[2] = {station->confidence(0), station->confidence(1)};
+		view.show(frame1, frame2, [&face_color_map, min_confidence, show_colors, points, colors,
+								   confidence](cv::Mat& display, int camera) {
+			// Draw calibration points
+			for (int i = 0; i < points[camera].size(); i++) {
+				cv::Point pt = points[camera][i];
+
+				if (show_colors && i < colors[camera].size()) {
+					// Show detected color converted to face
+					char detected_face = colorToFace(colors[camera][i]);
+					auto found = face_color_map.find(detected_face);
+					cv::Scalar color = found != face_color_map.end() ? found->second : cv::Scalar();
+
+					// Draw filled circle with detected color
+					cv::circle(display, pt, 8, color, -1);
+					// Black border for visibility, yellow when the patch vote was uncertain
+					const bool uncertain = i < confidence[camera].size() && confidence[camera][i] < min_confidence;
+					cv::circle(display, pt, 8, uncertain ? cv::Scalar(0, 255, 255) : cv::Scalar(0, 0, 0), 2);
+
+					// Add face text
+					cv::putText(display, std::string(1, detected_face),
+							   cv::Point(pt.x + 12, pt.y + 5),
+							   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 2);
+				} else {
+					// Just show calibration points
+					cv::circle(display, pt, 5, cv::Scalar(0, 255, 0), 2);
+					cv::putText(display, std::to_string(i + 1),
+							   cv::Point(pt.x + 8, pt.y - 8),
+							   cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(0, 255, 0), 1);
+				}
 			}
-		}
-
-		// Add titles and instructions
-		cv::putText(display1, "Camera 1 (Up/Right/Front)", cv::Point(10, 30),
-				   cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
-		cv::putText(display2, "Camera 2 (Down/Left/Back)", cv::Point(10, 30),
-				   cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
 
-		std::string status = show_colors ? "Showing detected faces" : "Showing calibration points";
-		cv::putText(display1, status, cv::Point(10, display1.rows - 40),
-				   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
-		cv::putText(display2, status, cv::Point(10, display2.rows - 40),
-				   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+			// Add titles and instructions
+			cv::putText(display, camera == 0 ? "Camera 1 (Up/Right/Front)" : "Camera 2 (Down/Left/Back)",
+					   cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
 
-		cv::putText(display1, "SPACE=Detect, R=Reset, Q=Quit", cv::Point(10, display1.rows - 10),
-				   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
-		cv::putText(display2, "SPACE=Detect, R=Reset, Q=Quit", cv::Point(10, display2.rows - 10),
-				   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+			std::string status = show_colors ? "Showing detected faces" : "Showing calibration points";
+			cv::putText(display, status, cv::Point(10, display.rows - 40),
+					   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+			cv::putText(display, "SPACE=Detect, R=Reset, Q=Quit", cv::Point(10, display.rows - 10),
+					   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+		});
 
-		cv::imshow("Debug Camera 1", display1);
-		cv::imshow("Debug Camera 2", display2);
-
-		int key = cv::waitKey(30) & 0xFF;
+		int key = view.key();
 		if (key == 27 || key == 'q' || key == 'Q') { // ESC or Q
 			break;
 		}
 		else if (key == ' ') { // SPACE - detect colors
 			std::cout << "Running face detection..." << std::endl;
-			detect_cam_1();
-			detect_cam_2();
+			station->detectPair(frame1, frame2);
 			show_colors = true;
 			std::cout << "Faces detected! Check the visual display." << std::endl;
 		}
@@ -1547,29 +1371,22 @@ void visual_debug_detection() {
 		}
 	}
 
-	cv::destroyAllWindows();
+	view.printStats();
 	std::cout << "Visual debug mode closed." << std::endl;
 }
 
 void test_calibrated_positions() {
-	if (!camera_1 || !camera_2) {
+	if (!station->camera(0) || !station->camera(1)) {
 		std::cerr << "Cameras not initialized!" << std::endl;
 		return;
 	}
 
 	// Check if position files exist
-	if (points_cam_1.empty() || points_cam_2.empty()) {
+	if (station->points(0).empty() || station->points(1).empty()) {
 		std::cerr << "No calibration points loaded. Please run position calibration first." << std::endl;
 		return;
 	}
 
-	cv::namedWindow("Test Camera 1", cv::WINDOW_NORMAL);
-	cv::namedWindow("Test Camera 2", cv::WINDOW_NORMAL);
-	cv::resizeWindow("Test Camera 1", 640, 480);
-	cv::resizeWindow("Test Camera 2", 640, 480);
-	cv::moveWindow("Test Camera 1", 50, 50);
-	cv::moveWindow("Test Camera 2", 720, 50);
-
 	std::cout << "\n=== Test Calibrated Positions ===" << std::endl;
 	std::cout << "This shows numbered circles on your calibrated points." << std::endl;
 	std::cout << "Verify the numbers match the clicking order you used:" << std::endl;
@@ -1577,123 +1394,104 @@ void test_calibrated_positions() {
 	std::cout << "Camera 2: Down(1-8), Left(9-16), Back(17-24)" << std::endl;
 	std::cout << "Controls: ESC/Q = Quit" << std::endl;
 
-	while (true) {
-		cv::Mat frame1, frame2, display1, display2;
-
-		// Capture frames
-		camera_1->capture(frame1);
-		camera_2->capture(frame2);
-
-		if (frame1.empty() || frame2.empty()) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(50));
-			continue;
-		}
-
-		display1 = frame1.clone();
-		display2 = frame2.clone();
-
-		// Draw numbered circles for Camera 1 points
-		for (int i = 0; i < points_cam_1.size(); i++) {
-			cv::Point pt = points_cam_1[i];
-
-			// Different colors for different faces
-			cv::Scalar color;
-			std::string face_name;
-			if (i < 8) {
-				color = cv::Scalar(255, 255, 255); // White for Up
-				face_name = "U";
-			} else if (i < 16) {
-				color = cv::Scalar(0, 255, 0); // Green for Right
-				face_name = "R";
-			} else {
-				color = cv::Scalar(0, 0, 255); // Red for Front
-				face_name = "F";
-			}
+	// Different colors for different faces, 8 points each
+	const cv::Scalar face_colors[2][3] = {
+		{cv::Scalar(255, 255, 255), cv::Scalar(0, 255, 0), cv::Scalar(0, 0, 255)}, // White Up, Green Right, Red Front
+		{cv::Scalar(0, 255, 255), cv::Scalar(255, 0, 0), cv::Scalar(0, 165, 255)}  // Yellow Down, Blue Left, Orange Back
+	};
+	const char* const face_labels[2][3] = {{"U", "R", "F"}, {"D", "L", "B"}};
+	// The points do not change in this mode, so the overlay may read them from the render thread
+	const std::vector<cv::Point>* points[2] = {&station->points(0), &station->points(1)};
+
+	DebugView view({{"Test Camera 1", 50, 50}, {"Test Camera 2", 720, 50}}, config.debug_render_fps,
+				   config.debug_render_opencl);
+	auto overlay = [&](cv::Mat& display, int camera) {
+		// Draw numbered circles for this camera's points
+		for (int i = 0; i < points[camera]->size(); i++) {
+			cv::Point pt = (*points[camera])[i];
+			const int face = std::min(i / 8, 2);
+			const cv::Scalar& color = face_colors[camera][face];
 
 			// Draw circle and number
-			cv::circle(display1, pt, 15, color, 2);
-			cv::putText(display1, std::to_string(i + 1),
+			cv::circle(display, pt, 15, color, 2);
+			cv::putText(display, std::to_string(i + 1),
 					   cv::Point(pt.x - 10, pt.y + 5),
 					   cv::FONT_HERSHEY_SIMPLEX, 0.6, color, 2);
 
 			// Add face label near first point of each face
 			if (i == 0 || i == 8 || i == 16) {
-				cv::putText(display1, face_name + " face",
+				cv::putText(display, std::string(face_labels[camera][face]) + " face",
 						   cv::Point(pt.x + 20, pt.y),
 						   cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 2);
 			}
 		}
 
-		// Draw numbered circles for Camera 2 points
-		for (int i = 0; i < points_cam_2.size(); i++) {
-			cv::Point pt = points_cam_2[i];
-
-			// Different colors for different faces
-			cv::Scalar color;
-			std::string face_name;
-			if (i < 8) {
-				color = cv::Scalar(0, 255, 255); // Yellow for Down
-				face_name = "D";
-			} else if (i < 16) {
-				color = cv::Scalar(255, 0, 0); // Blue for Left
-				face_name = "L";
-			} else {
-				color = cv::Scalar(0, 165, 255); // Orange for Back
-				face_name = "B";
-			}
+		// Add titles
+		cv::putText(display, camera == 0 ? "Camera 1: Up, Right, Front" : "Camera 2: Down, Left, Back",
+				   cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 2);
+	};
 
-			// Draw circle and number
-			cv::circle(display2, pt, 15, color, 2);
-			cv::putText(display2, std::to_string(i + 1),
-					   cv::Point(pt.x - 10, pt.y + 5),
-					   cv::FONT_HERSHEY_SIMPLEX, 0.6, color, 2);
+	uint64_t seen[2] = {0, 0};
+	while (true) {
+		cv::Mat frame1, frame2;
 
-			// Add face label near first point of each face
-			if (i == 0 || i == 8 || i == 16) {
-				cv::putText(display2, face_name + " face",
-						   cv::Point(pt.x + 20, pt.y),
-						   cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 2);
-			}
-		}
+		// Capture frames; waiting for new ones keeps the loop at the camera's rate
+		station->camera(0)->captureNewRaw(frame1, seen[0]);
+		station->camera(1)->captureNewRaw(frame2, seen[1]);
 
-		// Add titles
-		cv::putText(display1, "Camera 1: Up, Right, Front",
-				   cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 2);
-		cv::putText(display2, "Camera 2: Down, Left, Back",
-				   cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 2);
+		if (frame1.empty() || frame2.empty()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			continue;
+		}
 
-		cv::imshow("Test Camera 1", display1);
-		cv::imshow("Test Camera 2", display2);
+		view.show(frame1, frame2, overlay);
 
-		int key = cv::waitKey(30) & 0xFF;
+		int key = view.key();
 		if (key == 27 || key == 'q' || key == 'Q') { // ESC or Q
 			break;
 		}
 	}
 
-	cv::destroyAllWindows();
+	view.printStats();
 	std::cout << "Position test mode closed." << std::endl;
 }
 
 void debug_detected_faces() {
-	for (int i = 0; i < glob_colors_cam_1.size(); i++) {
-		std::cout << "Point " << i << " color: " << glob_colors_cam_1[i] << " -> face: " << colorToFace(glob_colors_cam_1[i]) << std::endl;
+	for (int i = 0; i < station->colors(0).size(); i++) {
+		std::cout << "Point " << i << " color: " << station->colors(0)[i] << " -> face: " << colorToFace(station->colors(0)[i]) << std::endl;
 	}
-	for (int i = 0; i < glob_colors_cam_2.size(); i++) {
-		std::cout << "Point " << i << " color: " << glob_colors_cam_2[i] << " -> face: " << colorToFace(glob_colors_cam_2[i]) << std::endl;
+	for (int i = 0; i < station->colors(1).size(); i++) {
+		std::cout << "Point " << i << " color: " << station->colors(1)[i] << " -> face: " << colorToFace(station->colors(1)[i]) << std::endl;
 	}
 }
 
-// Global solver instance (initialized once)
-static solve::Engine* global_solver = nullptr;
+// Global solver service (initialized once, keeps the engine's search threads running)
+static std::unique_ptr<SolverService> solver_service;
 static bool solver_initialized = false;
 
+// rob-twophase reads and writes its precomputed tables here (relative to the working directory)
+static const char* const kTwophaseTableFile = "twophase.tbl";
+// Checks the table file against its manifest before prun::init reads it
+static std::unique_ptr<TableCache> table_cache;
+// Answers repeated cube states (up to symmetry) in front of the engine
+static std::unique_ptr<SolutionCache> solution_cache;
+
 void initializeRobTwophase() {
 	if (solver_initialized) return;
 
 	auto tick = std::chrono::high_resolution_clock::now();
 	std::cout << "Initializing rob-twophase solver..." << std::endl;
 
+	// Verify the table file before rob-twophase trusts it; a stale or truncated one is rebuilt
+	table_cache = std::make_unique<TableCache>(kTwophaseTableFile);
+	const TableCache::State table_state = table_cache->check(config.solver_table_full_check);
+	if (table_state == TableCache::State::Stale) {
+		std::cout << "⚠️  Discarding " << kTwophaseTableFile << ", it will be rebuilt (this takes a while)" << std::endl;
+		table_cache->discard();
+	} else if (table_state == TableCache::State::Missing) {
+		std::cout << "Building " << kTwophaseTableFile << " (first start only, this takes a while)" << std::endl;
+	}
+
 	// Initialize rob-twophase components
 	face::init();
 	move::init();
@@ -1701,25 +1499,63 @@ void initializeRobTwophase() {
 	sym::init();
 	if (prun::init(true)) {
 		std::cerr << "Error: Failed to initialize rob-twophase pruning tables" << std::endl;
+		table_cache.reset();
 		return;
 	}
 
-	// Create solver engine with optimal settings
-	// Using 12 threads (typical for modern CPUs with hyperthreading)
-	// 10ms time limit for speed (can be adjusted)
-	// Single solution (n_sols = 1)
-	// No max length limit (-1)
-	// 2 splits for parallelization
-	global_solver = new solve::Engine(12, 10, 1, -1, 2);
+	if (table_state != TableCache::State::Valid) {
+		if (table_cache->writeManifest()) {
+			std::cout << "✓ Wrote " << table_cache->manifestPath() << std::endl;
+		}
+	}
+
+	// Engine settings come from config.txt (SOLVER_THREADS, SOLVER_TIME_LIMIT_MS, SOLVER_MAX_LENGTH,
+	// SOLVER_SPLITS); a single solution is requested
+	SolverService::Settings settings;
+	settings.threads = config.solver_threads;
+	settings.time_limit_ms = config.solver_time_limit_ms;
+	settings.max_length = config.solver_max_length;
+	settings.splits = config.solver_splits;
+	settings.limit_engines = config.solver_limit_engines;
+	if (config.solution_cache_size > 0) {
+		solution_cache = std::make_unique<SolutionCache>(config.solution_cache_size);
+		if (!solution_cache->usable()) {
+			solution_cache.reset();
+		} else if (!config.solution_cache_file.empty() && solution_cache->load(config.solution_cache_file)) {
+			std::cout << "  Solution cache: " << solution_cache->stats().entries << " states from "
+					  << config.solution_cache_file << std::endl;
+		}
+	}
+	solver_service = std::make_unique<SolverService>(settings, solution_cache.get());
 
 	auto tock = std::chrono::high_resolution_clock::now();
 	std::cout << "Rob-twophase initialized in " <<
 		std::chrono::duration_cast<std::chrono::milliseconds>(tock - tick).count()
-		<< "ms" << std::endl;
+		<< "ms (" << settings.threads << " threads, " << settings.time_limit_ms << " ms limit, "
+		<< settings.splits << " splits)" << std::endl;
 
 	solver_initialized = true;
 }
 
+static std::string formatSolution(const std::vector<int>& moves) {
+	// Convert solution to string notation
+	std::string solution_str;
+	for (int move : moves) {
+		if (!solution_str.empty()) solution_str += " ";
+		solution_str += move::names[move];
+	}
+
+	return solution_str + " (" + std::to_string(moves.size()) + " moves)";
+}
+
+// Formats the first solution of a solve
+static std::string formatResult(const SolverService::Result& result) {
+	if (!result.solved) {
+		return "ERROR: No solution found";
+	}
+	return formatSolution(result.moves);
+}
+
 std::string solveDetectedCube(const std::string& face_string, double& solve_time_ms) {
 	if (!solver_initialized) {
 		initializeRobTwophase();
@@ -1728,55 +1564,63 @@ std::string solveDetectedCube(const std::string& face_string, double& solve_time
 		}
 	}
 
-	// Convert face string to cubie representation
+	// Convert face string to cubie representation and validate the cube state
 	cubie::cube c;
-	int face_error = face::to_cubie(face_string, c);
-	if (face_error != 0) {
-		return "ERROR: Invalid face string (error " + std::to_string(face_error) + ")";
-	}
-
-	// Validate cube state
-	int cubie_error = cubie::check(c);
-	if (cubie_error != 0) {
-		return "ERROR: Invalid cube state (error " + std::to_string(cubie_error) + ")";
+	std::string error;
+	if (!solve_server::toCube(face_string, c, error)) {
+		return "ERROR: " + error;
 	}
 
-	// Solve the cube
-	auto solve_start = std::chrono::high_resolution_clock::now();
+	// Solve the cube; nothing is printed until the clock has stopped
+	auto solve_start = std::chrono::steady_clock::now();
+	const SolverService::Result result = solver_service->solve(c);
+	solve_time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - solve_start).count();
 
-	std::vector<std::vector<int>> solutions;
-	global_solver->prepare();
-	global_solver->solve(c, solutions);
-	global_solver->finish();
-
-	auto solve_end = std::chrono::high_resolution_clock::now();
-	solve_time_ms = std::chrono::duration<double, std::milli>(solve_end - solve_start).count();
-
-	if (solutions.empty()) {
-		return "ERROR: No solution found";
-	}
-
-	// Convert solution to string notation
-	std::string solution_str;
-	const std::vector<int>& solution = solutions[0]; // Take the first (best) solution
-
-	for (int move : solution) {
-		if (!solution_str.empty()) solution_str += " ";
-		solution_str += move::names[move];
+	if (result.cached) {
+		std::cout << "  Solver: solution cache hit" << std::endl;
+	} else {
+		std::cout << "  Solver: queue wait " << result.queue_wait_ms << " ms, search " << result.search_ms << " ms"
+				  << std::endl;
 	}
-
-	return solution_str + " (" + std::to_string(solution.size()) + " moves)";
+	return formatResult(result);
 }
 
 void cleanupRobTwophase() {
-	if (global_solver) {
-		delete global_solver;
-		global_solver = nullptr;
+	// Joins the engine's search threads
+	solver_service.reset();
+	if (solution_cache) {
+		if (solution_cache->stats().lookups > 0) solution_cache->printStats();
+		if (!config.solution_cache_file.empty()) solution_cache->save(config.solution_cache_file);
+		solution_cache.reset();
 	}
+	table_cache.reset();
 	solver_initialized = false;
 }
 
-// Multi-orientation solving wrapper
+// Queues every candidate at once on the warm solver service and keeps the shortest solution.
+// Returns false if no candidate could be solved. The per-candidate results are kept in `results`
+// when given, so the caller can report them after its timed region.
+static bool solveCandidates(const std::vector<OrientationCandidate>& candidates, SolverService::Result& best,
+							std::vector<SolverService::Result>* results = nullptr) {
+	std::vector<std::future<SolverService::Result>> pending;
+	for (const auto& candidate : candidates) {
+		pending.push_back(solver_service->submit(candidate.cube));
+	}
+
+	bool solved = false;
+	for (auto& future : pending) {
+		SolverService::Result result = future.get();
+		if (results) results->push_back(result);
+		if (result.solved && (!solved || result.moves.size() < best.moves.size())) {
+			best = std::move(result);
+			solved = true;
+		}
+	}
+	return solved;
+}
+
+// Multi-orientation solving wrapper: solves up to SOLVER_MAX_CANDIDATES valid orientations and
+// returns the shortest solution
 std::string solveWithMultipleOrientations(double& solve_time_ms) {
 	if (!solver_initialized) {
 		initializeRobTwophase();
@@ -1785,65 +1629,193 @@ std::string solveWithMultipleOrientations(double& solve_time_ms) {
 		}
 	}
 
-	std::vector<CubeOrientation> orientations = generateAllOrientations();
-	auto solve_start = std::chrono::high_resolution_clock::now();
-
 	std::cout << "🔄 Trying multiple orientations to find valid cube state..." << std::endl;
 
-	for (size_t i = 0; i < orientations.size(); i++) {
-		try {
-			// Generate face string for this orientation
-			std::string face_string = generateFaceString(orientations[i]);
-
-			// Convert face string to cubie representation
-			cubie::cube c;
-			int face_error = face::to_cubie(face_string, c);
-			if (face_error != 0) {
-				continue; // Try next orientation
-			}
+	// Orientation search and solving are timed together; the report follows afterwards
+	auto solve_start = std::chrono::steady_clock::now();
+	std::vector<OrientationCandidate> candidates;
+	station->findCandidates(candidates, false);
+	SolverService::Result best;
+	std::vector<SolverService::Result> results;
+	const bool solved = !candidates.empty() && solveCandidates(candidates, best, &results);
+	solve_time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - solve_start).count();
+
+	if (candidates.empty()) {
+		return "ERROR: No valid orientation found - all 24 orientations failed validation";
+	}
+	for (const auto& candidate : candidates) {
+		std::cout << "✓ Valid orientation found (attempt " << (candidate.orientation + 1) << "/24)" << std::endl;
+	}
+	for (const auto& result : results) {
+		if (result.cached) {
+			std::cout << "  Solver: solution cache hit" << std::endl;
+			continue;
+		}
+		std::cout << "  Solver: queue wait " << result.queue_wait_ms << " ms, search " << result.search_ms << " ms"
+				  << std::endl;
+	}
 
-			// Validate cube state
-			int cubie_error = cubie::check(c);
-			if (cubie_error != 0) {
-				continue; // Try next orientation
-			}
+	if (!solved) {
+		return "ERROR: No solution found";
+	}
+	if (candidates.size() > 1) {
+		std::cout << "  Kept the shortest of " << candidates.size() << " candidate solutions" << std::endl;
+	}
+	return formatSolution(best.moves);
+}
 
-			// This orientation works! Solve it
-			std::cout << "✓ Valid orientation found (attempt " << (i + 1) << "/24)" << std::endl;
+// Options of the latency benchmark ('bench' subcommand and menu option 'b')
+struct BenchOptions {
+	int iterations = 200;
+	int warmup = 10;
+	std::string images_dir; // cam1_*.png / cam2_*.png pairs; empty = live cameras
+	std::string csv_file;
+	std::string json_file;
+	bool solve = true;
+};
+
+// Loads the recorded frame pairs of a directory (cam1_<name>.png with a matching cam2_<name>.png)
+static bool load_bench_frames(const std::string& dir, std::vector<std::pair<Mat, Mat>>& frames) {
+	std::vector<std::string> files;
+	cv::glob(dir + "/cam1_*.png", files, false);
+	std::sort(files.begin(), files.end());
+	for (const auto& file_1 : files) {
+		std::string file_2 = file_1;
+		file_2.replace(file_2.rfind("cam1_"), 5, "cam2_");
+		Mat frame_1 = imread(file_1, IMREAD_COLOR);
+		Mat frame_2 = imread(file_2, IMREAD_COLOR);
+		if (frame_1.empty() || frame_2.empty()) {
+			std::cerr << "Warning: Skipping " << file_1 << " (missing or unreadable pair)" << std::endl;
+			continue;
+		}
+		frames.emplace_back(frame_1, frame_2);
+	}
+	if (frames.empty()) {
+		std::cerr << "Error: No cam1_*.png/cam2_*.png frame pairs found in " << dir << std::endl;
+		return false;
+	}
+	std::cout << "Loaded " << frames.size() << " recorded frame pairs from " << dir << std::endl;
+	return true;
+}
 
-			std::vector<std::vector<int>> solutions;
-			global_solver->prepare();
-			global_solver->solve(c, solutions);
-			global_solver->finish();
+// Runs the detection and solve pipeline stage by stage and reports per-stage latency percentiles
+int run_benchmark(const BenchOptions& options) {
+	using clock = std::chrono::steady_clock;
+	auto elapsed_ms = [](clock::time_point since) {
+		return std::chrono::duration<double, std::milli>(clock::now() - since).count();
+	};
 
-			auto solve_end = std::chrono::high_resolution_clock::now();
-			solve_time_ms = std::chrono::duration<double, std::milli>(solve_end - solve_start).count();
+	station->loadCalibration();
 
-			if (solutions.empty()) {
-				return "ERROR: No solution found";
-			}
+	std::vector<std::pair<Mat, Mat>> recorded;
+	if (!options.images_dir.empty()) {
+		if (!load_bench_frames(options.images_dir, recorded)) return 1;
+	} else if (!station->hasCameras()) {
+		std::cerr << "Cameras not initialized!" << std::endl;
+		return 1;
+	}
 
-			// Convert solution to string notation
-			std::string solution_str;
-			const std::vector<int>& solution = solutions[0];
+	if (options.solve) {
+		initializeRobTwophase();
+		if (!solver_initialized) return 1;
+	}
 
-			for (int move : solution) {
-				if (!solution_str.empty()) solution_str += " ";
-				solution_str += move::names[move];
+	BenchReport report;
+	report.setInfo("source", options.images_dir.empty() ? "live" : options.images_dir);
+	report.setInfo("iterations", std::to_string(options.iterations));
+	report.setInfo("warmup", std::to_string(options.warmup));
+	report.setInfo("sync_frames", config.sync_frames ? "1" : "0");
+	report.setInfo("solver_threads", std::to_string(config.solver_threads));
+	report.setInfo("solver_time_limit_ms", std::to_string(config.solver_time_limit_ms));
+
+	report.setInfo("sticker_kernel", sticker_kernel::isaName(sticker_kernel::detectIsa()));
+	report.setInfo("sample_patch_size", std::to_string(config.sample_patch_size));
+	report.setInfo("detector", station->detector().name());
+	std::vector<OrientationCandidate> candidates;
+	int valid_count = 0;
+
+	std::cout << "Running " << options.warmup << " warmup + " << options.iterations << " measured iterations..."
+			  << std::endl;
+	for (int it = 0; it < options.warmup + options.iterations; it++) {
+		const bool measured = it >= options.warmup;
+		auto record = [&](const char* stage, double ms) {
+			if (measured) report.record(stage, ms);
+		};
+		const auto total_start = clock::now();
+
+		auto start = clock::now();
+		if (!recorded.empty()) {
+			const auto& pair = recorded[it % recorded.size()];
+			pair.first.copyTo(station->frame(0));
+			pair.second.copyTo(station->frame(1));
+		} else {
+			double capture_ms = 0;
+			station->capturePair(false, capture_ms);
+		}
+		record("capture", elapsed_ms(start));
+
+		// One frame per iteration: every sticker's full patch is gathered, classified and voted.
+		// HSV conversion and classification are one fused kernel pass (sticker_kernel.h) that
+		// classifies from the HSV values still in registers, so they are timed together.
+		start = clock::now();
+		station->detectPair(station->frame(0), station->frame(1));
+		record("detect", elapsed_ms(start));
+		record("sample", station->lastReading().sample_us / 1000.0);
+		record("hsv_classify", station->lastReading().classify_us / 1000.0);
+
+		start = clock::now();
+		bool valid = station->validate();
+		record("validation", elapsed_ms(start));
+
+		if (!valid) {
+			start = clock::now();
+			std::vector<bool> changeable(station->confidence(0).size() + station->confidence(1).size());
+			for (size_t i = 0; i < changeable.size(); i++) {
+				const bool first = i < station->confidence(0).size();
+				changeable[i] = (first ? station->confidence(0)[i] : station->confidence(1)[i - station->confidence(0).size()]) <
+								config.vote_min_confidence;
 			}
+			valid = station->repair(changeable, false);
+			record("repair", elapsed_ms(start));
+		}
 
-			return solution_str + " (" + std::to_string(solution.size()) + " moves)";
+		if (valid) {
+			if (measured) valid_count++;
 
-		} catch (const std::exception& e) {
-			// Continue to next orientation on any error
-			continue;
+			start = clock::now();
+			station->findCandidates(candidates, false);
+			record("orientation_search", elapsed_ms(start));
+
+			if (options.solve && !candidates.empty()) {
+				SolverService::Result best;
+				start = clock::now();
+				solveCandidates(candidates, best);
+				record("solve", elapsed_ms(start));
+			}
 		}
+		record("total", elapsed_ms(total_start));
 	}
 
-	auto solve_end = std::chrono::high_resolution_clock::now();
-	solve_time_ms = std::chrono::duration<double, std::milli>(solve_end - solve_start).count();
+	report.setInfo("valid_iterations", std::to_string(valid_count));
+	std::cout << "\n=== Benchmark Results (" << valid_count << "/" << options.iterations << " valid) ===" << std::endl;
+	report.print();
+	if (trace::enabled()) {
+		std::cout << "\n=== Stage Trace ===" << std::endl;
+		trace::printSummary();
+	}
 
-	return "ERROR: No valid orientation found - all 24 orientations failed validation";
+	bool ok = true;
+	if (!options.csv_file.empty()) {
+		const bool written = report.writeCsv(options.csv_file);
+		if (written) std::cout << "✓ Results written to " << options.csv_file << std::endl;
+		ok &= written;
+	}
+	if (!options.json_file.empty()) {
+		const bool written = report.writeJson(options.json_file);
+		if (written) std::cout << "✓ Results written to " << options.json_file << std::endl;
+		ok &= written;
+	}
+	return ok ? 0 : 1;
 }
 
 // Function to calibrate red wraparound range for dual cameras
@@ -1868,9 +1840,11 @@ static void calibrateDualRedWraparound(PS3EyeCamera* camera1, PS3EyeCamera* came
     cv::setTrackbarPos("S_MAX", "Controls", s_max);
     cv::setTrackbarPos("V_MIN", "Controls", v_min);
     cv::setTrackbarPos("V_MAX", "Controls", v_max);
+    beginPreviewRange('R');
     
     while (true) {
         cv::Mat frame1, frame2, hsv1, hsv2, mask1, mask2, preview1, preview2;
+        updatePreviewRange();
         
         // Capture from both cameras
         if (camera1) camera1->capture(frame1);
@@ -1913,11 +1887,17 @@ static void calibrateDualRedWraparound(PS3EyeCamera* camera1, PS3EyeCamera* came
         cv::cvtColor(mask1_small, mask1_colored, cv::COLOR_GRAY2BGR);
         cv::cvtColor(mask2_small, mask2_colored, cv::COLOR_GRAY2BGR);
         
-        // Create 2x2 grid layout
-        cv::Mat top_row, bottom_row, grid_display;
+        // All ranges together, as detection will classify with them
+        cv::Mat classified1, classified2;
+        drawClassification(frame1_small, classified1);
+        drawClassification(frame2_small, classified2);
+        
+        // Create 2x3 grid layout
+        cv::Mat top_row, middle_row, bottom_row, grid_display;
         cv::hconcat(frame1_small, frame2_small, top_row);
-        cv::hconcat(mask1_colored, mask2_colored, bottom_row);
-        cv::vconcat(top_row, bottom_row, grid_display);
+        cv::hconcat(mask1_colored, mask2_colored, middle_row);
+        cv::hconcat(classified1, classified2, bottom_row);
+        cv::vconcat(std::vector<cv::Mat>{top_row, middle_row, bottom_row}, grid_display);
         
         // Add some spacing for controls at bottom
         cv::Mat final_display;
@@ -1933,18 +1913,22 @@ static void calibrateDualRedWraparound(PS3EyeCamera* camera1, PS3EyeCamera* came
                    cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
         cv::putText(final_display, "Camera 2 - Mask", cv::Point(290, 220),
                    cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+        cv::putText(final_display, "Camera 1 - Classified", cv::Point(10, 420),
+                   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+        cv::putText(final_display, "Camera 2 - Classified", cv::Point(290, 420),
+                   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
         
         // Add current face info
         cv::putText(final_display, "Red Wraparound (170-179)",
-                   cv::Point(10, 450), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 255), 2);
+                   cv::Point(10, 650), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 255), 2);
         cv::putText(final_display, "Hold red face to both cameras",
-                   cv::Point(10, 480), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
+                   cv::Point(10, 680), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
         
         // Show current HSV ranges
         std::string range_text = "H:" + std::to_string(h_min) + "-" + std::to_string(h_max) +
                                " S:" + std::to_string(s_min) + "-" + std::to_string(s_max) +
                                " V:" + std::to_string(v_min) + "-" + std::to_string(v_max);
-        cv::putText(final_display, range_text, cv::Point(10, 520),
+        cv::putText(final_display, range_text, cv::Point(10, 720),
                    cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 2);
         
         // Add control instructions
@@ -1981,6 +1965,7 @@ static void calibrateDualRedWraparound(PS3EyeCamera* camera1, PS3EyeCamera* came
         }
         if (key == 'q' || key == 'Q') {
             std::cout << "Skipped dual camera red wraparound calibration" << std::endl;
+            endPreviewRange();
             break;
         }
     }
@@ -2014,9 +1999,13 @@ void dualCameraColorCalibration(PS3EyeCamera* camera1, PS3EyeCamera* camera2, co
 	cv::createTrackbar("V_MIN", "Controls", &v_min, 255, on_trackbar);
 	cv::createTrackbar("V_MAX", "Controls", &v_max, 255, on_trackbar);
 
+	// The file is rewritten, so the preview starts empty and gains each range as it is saved
+	calibration_preview.clear();
+
 	for (int i = 0; i < 6; ++i) {
 		// Auto-suggest starting values
 		reset_to_defaults(i);
+		beginPreviewRange(color_chars[i]);
 
 		std::cout << "\n=== Calibrating for face: " << face_orientations[i] << " ===" << std::endl;
 		std::cout << "Controls:" << std::endl;
@@ -2069,11 +2058,18 @@ void dualCameraColorCalibration(PS3EyeCamera* camera1, PS3EyeCamera* camera2, co
 			cv::cvtColor(mask1_small, mask1_colored, cv::COLOR_GRAY2BGR);
 			cv::cvtColor(mask2_small, mask2_colored, cv::COLOR_GRAY2BGR);
 
-			// Create 2x2 grid layout
-			cv::Mat top_row, bottom_row, grid_display;
+			// All ranges together, as detection will classify with them
+			updatePreviewRange();
+			cv::Mat classified1, classified2;
+			drawClassification(frame1_small, classified1);
+			drawClassification(frame2_small, classified2);
+
+			// Create 2x3 grid layout
+			cv::Mat top_row, middle_row, bottom_row, grid_display;
 			cv::hconcat(frame1_small, frame2_small, top_row);
-			cv::hconcat(mask1_colored, mask2_colored, bottom_row);
-			cv::vconcat(top_row, bottom_row, grid_display);
+			cv::hconcat(mask1_colored, mask2_colored, middle_row);
+			cv::hconcat(classified1, classified2, bottom_row);
+			cv::vconcat(std::vector<cv::Mat>{top_row, middle_row, bottom_row}, grid_display);
 
 			// Add some spacing for controls at bottom
 			cv::Mat final_display;
@@ -2089,18 +2085,22 @@ void dualCameraColorCalibration(PS3EyeCamera* camera1, PS3EyeCamera* camera2, co
 					   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
 			cv::putText(final_display, "Camera 2 - Mask", cv::Point(290, 220),
 					   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+			cv::putText(final_display, "Camera 1 - Classified", cv::Point(10, 420),
+					   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+			cv::putText(final_display, "Camera 2 - Classified", cv::Point(290, 420),
+					   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
 
 			// Add current face info
 			cv::putText(final_display, "Current Face: " + std::string(face_orientations[i]),
-					   cv::Point(10, 450), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 255), 2);
+					   cv::Point(10, 650), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 255), 2);
 			cv::putText(final_display, "Hold " + std::string(face_orientations[i]) + " face to both cameras",
-					   cv::Point(10, 480), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
+					   cv::Point(10, 680), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
 
 			// Show current HSV ranges
 			std::string range_text = "H:" + std::to_string(h_min) + "-" + std::to_string(h_max) +
 								   " S:" + std::to_string(s_min) + "-" + std::to_string(s_max) +
 								   " V:" + std::to_string(v_min) + "-" + std::to_string(v_max);
-			cv::putText(final_display, range_text, cv::Point(10, 520),
+			cv::putText(final_display, range_text, cv::Point(10, 720),
 					   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 2);
 
 			// Add control instructions
@@ -2143,11 +2143,423 @@ void dualCameraColorCalibration(PS3EyeCamera* camera1, PS3EyeCamera* camera2, co
 	std::cout << "\n=== Dual camera calibration complete! Values saved to " << output_filename << " ===" << std::endl;
 }
 
-int main() {
+// Writes the configured trace exports (TRACE_METRICS_FILE, TRACE_CHROME_FILE)
+static void exportTrace() {
+	if (!config.trace) return;
+	if (!config.trace_metrics_file.empty() && trace::writePrometheus(config.trace_metrics_file)) {
+		std::cout << "✓ Metrics written to " << config.trace_metrics_file << std::endl;
+	}
+	if (!config.trace_chrome_file.empty() && trace::writeChromeTrace(config.trace_chrome_file)) {
+		std::cout << "✓ Trace written to " << config.trace_chrome_file << std::endl;
+	}
+}
+
+// Keeps TRACE_METRICS_FILE current while a pipelined mode runs; null when not configured
+static std::unique_ptr<trace::PeriodicExport> startMetricsExport() {
+	if (!config.trace || config.trace_metrics_file.empty()) return nullptr;
+	return std::make_unique<trace::PeriodicExport>(config.trace_metrics_file,
+												   std::chrono::milliseconds(config.trace_export_interval_ms));
+}
+
+static void cleanup() {
+	exportTrace();
+	cleanupRobTwophase();
+	station.reset();
+}
+
+static void show_bench_usage(const char* program) {
+	std::cout << "Usage: " << program << " bench [options]" << std::endl;
+	std::cout << "  --iterations N   Measured iterations (default 200)" << std::endl;
+	std::cout << "  --warmup N       Unmeasured warmup iterations (default 10)" << std::endl;
+	std::cout << "  --images DIR     Use recorded cam1_*.png/cam2_*.png pairs instead of the cameras" << std::endl;
+	std::cout << "  --replay FILE    Replay a recorded session (see 'record') as fast as possible" << std::endl;
+	std::cout << "  --csv FILE       Write the per-stage percentiles as CSV" << std::endl;
+	std::cout << "  --json FILE      Write the per-stage percentiles as JSON" << std::endl;
+	std::cout << "  --no-solve       Skip the solver stage" << std::endl;
+}
+
+// "bench" subcommand: non-interactive latency benchmark for comparing builds
+static int bench_command(int argc, char** argv) {
+	BenchOptions options;
+	std::string replay_file;
+	for (int i = 2; i < argc; i++) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if (arg == "--iterations" && has_value) {
+			options.iterations = std::max(1, std::atoi(argv[++i]));
+		} else if (arg == "--warmup" && has_value) {
+			options.warmup = std::max(0, std::atoi(argv[++i]));
+		} else if (arg == "--images" && has_value) {
+			options.images_dir = argv[++i];
+		} else if (arg == "--replay" && has_value) {
+			replay_file = argv[++i];
+		} else if (arg == "--csv" && has_value) {
+			options.csv_file = argv[++i];
+		} else if (arg == "--json" && has_value) {
+			options.json_file = argv[++i];
+		} else if (arg == "--no-solve") {
+			options.solve = false;
+		} else {
+			show_bench_usage(argv[0]);
+			return arg == "--help" || arg == "-h" ? 0 : 1;
+		}
+	}
+
+	loadConfig("config.txt", config);
+	trace::setEnabled(config.trace);
+	if (!replay_file.empty()) {
+		config.replay_file = replay_file;
+		config.replay_realtime = false;
+	}
+	if (options.images_dir.empty()) {
+		try {
+			initializeCameras();
+		} catch (const std::exception& e) {
+			std::cerr << "Failed to initialize cameras. Use --images to benchmark recorded frames." << std::endl;
+			return 1;
+		}
+	} else {
+		create_station();
+	}
+
+	int result = 1;
+	try {
+		result = run_benchmark(options);
+	} catch (const std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+	}
+	cleanup();
+	return result;
+}
+
+// "record" subcommand: writes timestamp-paired frames of both cameras to a replayable recording
+static int record_command(int argc, char** argv) {
+	if (argc < 3 || argv[2][0] == '-') {
+		std::cout << "Usage: " << argv[0] << " record FILE [--frames N] [--yuyv]" << std::endl;
+		return 1;
+	}
+	const std::string filename = argv[2];
+	int frame_count = 500;
+	recording::PixelFormat format = recording::PixelFormat::BGR24;
+	for (int i = 3; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--frames" && i + 1 < argc) {
+			frame_count = std::max(1, std::atoi(argv[++i]));
+		} else if (arg == "--yuyv") {
+			format = recording::PixelFormat::YUYV;
+		} else {
+			std::cout << "Usage: " << argv[0] << " record FILE [--frames N] [--yuyv]" << std::endl;
+			return 1;
+		}
+	}
+
+	loadConfig("config.txt", config);
+	trace::setEnabled(config.trace);
+	config.replay_file.clear();
+	try {
+		initializeCameras();
+	} catch (const std::exception& e) {
+		std::cerr << "Failed to initialize cameras. Please check your config.txt file." << std::endl;
+		return 1;
+	}
+
+	FrameSync& sync = station->frameSync();
+	FrameRecorder recorder;
+	Mat frame_1, frame_2;
+	int64_t t_1 = 0, t_2 = 0;
+	int64_t last_t_1 = std::numeric_limits<int64_t>::min(), last_t_2 = last_t_1;
+	int result = 0;
+	auto new_pair_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.sync_timeout_ms);
+	for (int i = 0; i < frame_count;) {
+		if (!sync.capturePair(frame_1, frame_2, t_1, t_2)) {
+			std::cerr << "Error: Could not capture a frame pair" << std::endl;
+			result = 1;
+			break;
+		}
+		// The streaming rings hand out the same pair until both cameras delivered a newer frame
+		if (t_1 <= last_t_1 || t_2 <= last_t_2) {
+			if (std::chrono::steady_clock::now() >= new_pair_deadline) {
+				std::cerr << "Error: No new frame pair within " << config.sync_timeout_ms << " ms" << std::endl;
+				result = 1;
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(500));
+			continue;
+		}
+		last_t_1 = t_1;
+		last_t_2 = t_2;
+		new_pair_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.sync_timeout_ms);
+		if (i == 0 && !recorder.open(filename, frame_1.cols, frame_1.rows, format,
+									 station->camera(0)->hasDeviceTimestamps() && station->camera(1)->hasDeviceTimestamps())) {
+			result = 1;
+			break;
+		}
+		if (!recorder.append(frame_1, t_1, frame_2, t_2)) {
+			std::cerr << "Error: Could not write frame pair " << i << std::endl;
+			result = 1;
+			break;
+		}
+		i++;
+	}
+	recorder.close();
+
+	const FrameSync::Stats& stats = sync.getStats();
+	std::cout << "✓ Recorded " << recorder.frames() << " frame pairs to " << filename << " (mean skew "
+			  << stats.mean_skew_us / 1000.0 << " ms, max " << stats.max_skew_us / 1000.0 << " ms)" << std::endl;
+	cleanup();
+	return result;
+}
+
+// "stations" subcommand: one station per rig config, all sharing one solver service and its tables
+static int stations_command(int argc, char** argv) {
+	std::vector<std::string> files;
+	int seconds = 0;
+	for (int i = 2; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--seconds" && i + 1 < argc) {
+			seconds = std::max(0, std::atoi(argv[++i]));
+		} else if (arg[0] == '-') {
+			files.clear();
+			break;
+		} else {
+			files.push_back(arg);
+		}
+	}
+	if (files.empty()) {
+		std::cout << "Usage: " << argv[0] << " stations CONFIG... [--seconds N]" << std::endl;
+		std::cout << "  Every CONFIG is a config.txt for one rig; solver settings come from the first" << std::endl;
+		return 1;
+	}
+
+	std::vector<Config> configs(files.size());
+	for (size_t i = 0; i < files.size(); i++) {
+		loadConfig(files[i], configs[i]);
+		if (configs[i].station_name == Config{}.station_name) configs[i].station_name = files[i];
+	}
+	config = configs.front();
+	trace::setEnabled(config.trace);
+	initializeRobTwophase();
+	if (!solver_initialized) return 1;
+
+	// Each station owns its classifier: a calibration reload swaps it in on that station's detection thread
+	std::vector<std::unique_ptr<Station>> stations;
+	for (const Config& rig : configs) {
+		auto rig_station = std::make_unique<Station>(rig, nullptr);
+		if (!rig_station->loadCalibration()) {
+			std::cerr << "Station " << rig.station_name << " has no position calibration" << std::endl;
+			cleanup();
+			return 1;
+		}
+		try {
+			rig_station->openCameras();
+		} catch (const std::exception& e) {
+			std::cerr << "Failed to initialize the cameras of station " << rig.station_name << std::endl;
+			cleanup();
+			return 1;
+		}
+		stations.push_back(std::move(rig_station));
+	}
+
+	StationScheduler scheduler(*solver_service);
+	for (auto& rig_station : stations) {
+		scheduler.add(*rig_station);
+	}
+	std::cout << "✓ Running " << stations.size() << " stations (one solver)"
+			  << std::endl;
+	auto metrics_export = startMetricsExport();
+	scheduler.start();
+	if (seconds > 0) {
+		std::this_thread::sleep_for(std::chrono::seconds(seconds));
+	} else {
+		std::cout << "Press Enter to stop" << std::endl;
+		std::cin.get();
+	}
+	scheduler.stop();
+	metrics_export.reset();
+
+	std::cout << "\n=== Station Statistics ===" << std::endl;
+	scheduler.printStats();
+	if (trace::enabled()) {
+		std::cout << "\n=== Stage Trace ===" << std::endl;
+		trace::printSummary();
+	}
+	stations.clear();
+	cleanup();
+	return 0;
+}
+
+static void show_solve_usage(const char* program) {
+	std::cout << "Usage: " << program << " solve [FILE] [options]" << std::endl;
+	std::cout << "  FILE             Face strings, one per line (default or '-': stdin)" << std::endl;
+	std::cout << "  --output FILE    Write the replies to FILE instead of stdout" << std::endl;
+	std::cout << "  --parallel N     Cubes queued on the solver at once (default SOLVE_PARALLELISM)" << std::endl;
+}
+
+// "solve" subcommand: solves face strings from a file or stdin without cameras, streaming one
+// reply line per cube (see solve_server.h for the format)
+static int solve_command(int argc, char** argv) {
+	std::string input_file, output_file;
+	int parallelism = 0;
+	for (int i = 2; i < argc; i++) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if (arg == "--output" && has_value) {
+			output_file = argv[++i];
+		} else if (arg == "--parallel" && has_value) {
+			parallelism = std::max(1, std::atoi(argv[++i]));
+		} else if (input_file.empty() && (arg == "-" || arg[0] != '-')) {
+			input_file = arg;
+		} else {
+			show_solve_usage(argv[0]);
+			return arg == "--help" || arg == "-h" ? 0 : 1;
+		}
+	}
+	if (input_file == "-") input_file.clear();
+
+	std::ofstream output;
+	if (!output_file.empty()) {
+		output.open(output_file);
+		if (!output) {
+			std::cerr << "Error: Could not write " << output_file << std::endl;
+			return 1;
+		}
+	}
+	std::ifstream input;
+	if (!input_file.empty()) {
+		input.open(input_file);
+		if (!input) {
+			std::cerr << "Error: Could not read " << input_file << std::endl;
+			return 1;
+		}
+	}
+
+	// Without --output the replies own stdout; startup messages and statistics go to stderr
+	std::streambuf* stdout_buffer = std::cout.rdbuf();
+	if (output_file.empty()) std::cout.rdbuf(std::cerr.rdbuf());
+	std::ostream replies(output_file.empty() ? stdout_buffer : output.rdbuf());
+	std::istream& face_strings = input_file.empty() ? std::cin : input;
+
+	loadConfig("config.txt", config);
+	if (parallelism > 0) config.solve_parallelism = parallelism;
+	trace::setEnabled(config.trace);
+	initializeRobTwophase();
+	if (!solver_initialized) {
+		std::cout.rdbuf(stdout_buffer);
+		return 1;
+	}
+
+	std::cout << "Solving face strings from " << (input_file.empty() ? "stdin" : input_file) << " ("
+			  << config.solve_parallelism << " queued at once)" << std::endl;
+	SolveStream stream(*solver_service, config.solve_parallelism);
+	const SolveStream::Stats stats = stream.run(
+			[&](std::string& line) { return static_cast<bool>(std::getline(face_strings, line)); },
+			[&](const std::string& line) {
+				replies << line << '\n';
+				replies.flush();
+				return static_cast<bool>(replies);
+			});
+	stats.print("Batch");
+	if (trace::enabled()) {
+		std::cout << "\n=== Stage Trace ===" << std::endl;
+		trace::printSummary();
+	}
+	cleanup();
+	std::cout.rdbuf(stdout_buffer);
+	return replies ? 0 : 1;
+}
+
+static void show_serve_usage(const char* program) {
+	std::cout << "Usage: " << program << " serve [options]" << std::endl;
+	std::cout << "  --address ADDR   IPv4 address to listen on (default SOLVE_SERVER_ADDRESS)" << std::endl;
+	std::cout << "  --port N         TCP port, 0 = any free one (default SOLVE_SERVER_PORT)" << std::endl;
+	std::cout << "  --parallel N     Cubes each client may have queued (default SOLVE_PARALLELISM)" << std::endl;
+	std::cout << "  --seconds N      Stop after N seconds instead of on Enter" << std::endl;
+}
+
+// "serve" subcommand: answers face strings from TCP clients (remote rigs, scramble generators)
+// with the same line protocol as "solve", all on one warm solver service
+static int serve_command(int argc, char** argv) {
+	std::string address;
+	int port = -1;
+	int parallelism = 0;
+	int seconds = 0;
+	for (int i = 2; i < argc; i++) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if (arg == "--address" && has_value) {
+			address = argv[++i];
+		} else if (arg == "--port" && has_value) {
+			port = std::clamp(std::atoi(argv[++i]), 0, 65535);
+		} else if (arg == "--parallel" && has_value) {
+			parallelism = std::max(1, std::atoi(argv[++i]));
+		} else if (arg == "--seconds" && has_value) {
+			seconds = std::max(0, std::atoi(argv[++i]));
+		} else {
+			show_serve_usage(argv[0]);
+			return arg == "--help" || arg == "-h" ? 0 : 1;
+		}
+	}
+
+	loadConfig("config.txt", config);
+	if (!address.empty()) config.solve_server_address = address;
+	if (port >= 0) config.solve_server_port = port;
+	if (parallelism > 0) config.solve_parallelism = parallelism;
+	trace::setEnabled(config.trace);
+	initializeRobTwophase();
+	if (!solver_initialized) return 1;
+
+	{
+		SolveServer server(*solver_service, config.solve_parallelism);
+		if (!server.start(config.solve_server_address, config.solve_server_port)) {
+			cleanup();
+			return 1;
+		}
+		std::cout << "✓ Solve server listening on " << config.solve_server_address << ":" << server.port() << " ("
+				  << config.solve_parallelism << " cubes queued per client)" << std::endl;
+		auto metrics_export = startMetricsExport();
+		if (seconds > 0) {
+			std::this_thread::sleep_for(std::chrono::seconds(seconds));
+		} else {
+			std::cout << "Press Enter to stop" << std::endl;
+			std::cin.get();
+		}
+		server.stop();
+		metrics_export.reset();
+		server.printStats();
+	}
+
+	if (trace::enabled()) {
+		std::cout << "\n=== Stage Trace ===" << std::endl;
+		trace::printSummary();
+	}
+	cleanup();
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1 && std::string(argv[1]) == "bench") {
+		return bench_command(argc, argv);
+	}
+	if (argc > 1 && std::string(argv[1]) == "record") {
+		return record_command(argc, argv);
+	}
+	if (argc > 1 && std::string(argv[1]) == "stations") {
+		return stations_command(argc, argv);
+	}
+	if (argc > 1 && std::string(argv[1]) == "solve") {
+		return solve_command(argc, argv);
+	}
+	if (argc > 1 && std::string(argv[1]) == "serve") {
+		return serve_command(argc, argv);
+	}
+
 	std::cout << "\n=== Rubik's Cube Detection System ===" << std::endl;
 
 	// Load configuration
-	loadConfig("config.txt");
+	loadConfig("config.txt", config);
+	trace::setEnabled(config.trace);
+	// OpenCV's OpenCL switch is process-wide; only the display modes' views use it
+	cv::ocl::setUseOpenCL(config.debug_render_opencl && cv::ocl::haveOpenCL());
 
 	// Initialize cameras once after config loading
 	try {
@@ -2160,13 +2572,17 @@ int main() {
 	std::cout << "\nSelect mode:" << std::endl;
 	std::cout << "  c = Position calibration" << std::endl;
 	std::cout << "  k = Dual camera color calibration (2x2 grid with sliders)" << std::endl;
-	std::cout << "  b = Simple benchmark" << std::endl;
+	std::cout << "  b = Latency benchmark (per-stage percentiles)" << std::endl;
 	std::cout << "  j = Full detection (with custom LUT)" << std::endl;
 	std::cout << "  s = SOLVE CUBE (detection + rob-twophase solver)" << std::endl;
+	std::cout << "  p = Pipelined throughput (capture, detection and solving overlapped)" << std::endl;
+	std::cout << "  e = Deadline solve (solution within DEADLINE_MS of the trigger)" << std::endl;
 	std::cout << "  d = Show dual camera feed (positioning)" << std::endl;
 	std::cout << "  v = Visual debug detection (see detection points)" << std::endl;
 	std::cout << "  t = Test calibrated positions (verify click order)" << std::endl;
 	std::cout << "  a = Arduino-style detection test" << std::endl;
+	std::cout << "  l = Verify compact color LUT against full table" << std::endl;
+	std::cout << "  g = Face string microbenchmark" << std::endl;
 	std::cout << "  q = Quit" << std::endl;
 	std::cout << "Enter choice: ";
 
@@ -2178,73 +2594,49 @@ int main() {
 			show_camera_setup_guide();
 
 			std::cout << "Starting calibration for camera 1..." << std::endl;
-			camera_1->calibratePosition("pos_1.txt");
+			station->camera(0)->calibratePosition(config.position_file_1);
 
 			std::cout << "\nStarting calibration for camera 2..." << std::endl;
-			camera_2->calibratePosition("pos_2.txt");
+			station->camera(1)->calibratePosition(config.position_file_2);
 
 			std::cout << "\n✓ Position calibration completed!" << std::endl;
+			station->compileCalibration();
 		}
 		else if (k == 'k') {
 			std::cout << "\n=== Dual Camera Color Calibration Mode ===" << std::endl;
 			std::cout << "Calibrating colors for both cameras simultaneously" << std::endl;
-			dualCameraColorCalibration(camera_1, camera_2, "range.txt");
+			dualCameraColorCalibration(station->camera(0), station->camera(1), config.color_range_file);
+			station->compileCalibration();
 		}
 		else if (k == 'b') {
-			std::cout << "\n=== Simple Benchmark Mode ===" << std::endl;
-			init_lut();
-			init_mat();
-			load_position("pos_1.txt", "pos_2.txt");
-
-			for (int attempt = 1; attempt <= 3; attempt++) {
-				const auto dstart = std::chrono::high_resolution_clock::now();
-				benchmark();
-				const auto dend = std::chrono::high_resolution_clock::now();
-				std::chrono::duration<double> duration = dend - dstart;
-
-				bool is_valid = validateCube();
-
-				if (is_valid) {
-					std::cout << "✓ Valid cube state achieved on attempt " << attempt << "!" << std::endl;
-					std::cout << "Detection time: " << duration.count() << " seconds" << std::endl;
-					printCubeState();
-					break;
-				} else if (attempt == 3) {
-					std::cout << "Failed to get valid cube state after 3 attempts." << std::endl;
-					std::cout << "Detection time: " << duration.count() << " seconds" << std::endl;
-					printCubeState();
-				}
-			}
+			std::cout << "\n=== Latency Benchmark Mode ===" << std::endl;
+			std::cout << "(run '" << argv[0] << " bench --help' for iterations, recorded frames and CSV/JSON output)"
+					  << std::endl;
+			run_benchmark(BenchOptions{});
 		}
 		else if (k == 'j') {
 			std::cout << "\n=== Full Detection Mode ===" << std::endl;
-			init_lut();
-			init_mat();
-			load_position("pos_1.txt", "pos_2.txt");
-			load_lut_from_file("range.txt");
-
-			for (int attempt = 1; attempt <= 3; attempt++) {
-				parallel_benchmark();
-				bool is_valid = validateCube();
-
-				if (is_valid) {
-					std::cout << "✓ Valid cube state achieved on attempt " << attempt << "!" << std::endl;
-					printCubeState();
-					break;
-				} else if (attempt == 3) {
-					std::cout << "Failed to get valid cube state after 3 attempts." << std::endl;
-					printCubeState();
-				}
+			station->loadCalibration();
+
+			StateAccumulator accumulator = station->makeAccumulator();
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.accumulate_timeout_ms);
+			station->accumulate(accumulator, deadline, true);
+			station->printValidationReport();
+			if (station->validate()) {
+				std::cout << "✓ Valid cube state achieved after " << accumulator.frames() << " frames!" << std::endl;
+			} else {
+				std::cout << "Failed to get valid cube state within " << config.accumulate_timeout_ms << " ms."
+						  << std::endl;
 			}
+			station->printWhiteBalanceStats();
+			station->printTrackerStats();
+			printCubeState();
 		}
 		else if (k == 's') {
 			std::cout << "\n=== SOLVE CUBE MODE ===" << std::endl;
 			std::cout << "Complete pipeline: Visual Detection → Rob-twophase Solver" << std::endl;
 
-			init_lut();
-			init_mat();
-			load_position("pos_1.txt", "pos_2.txt");
-			load_lut_from_file("range.txt");
+			station->loadCalibration();
 
 			// Initialize solver (this may take a few seconds)
 			initializeRobTwophase();
@@ -2258,14 +2650,16 @@ int main() {
 			bool success = false;
 			std::string cube_face_string;
 
-			for (int attempt = 1; attempt <= 3; attempt++) {
-				std::cout << "\n--- Attempt " << attempt << " ---" << std::endl;
+			// Stickers lock in as frames come in; a solver rejection starts the reading over
+			StateAccumulator accumulator = station->makeAccumulator();
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.accumulate_timeout_ms);
 
+			while (true) {
 				// 1. Visual Detection Phase
 				std::cout << "🎥 Running visual detection..." << std::endl;
 				detection_start = std::chrono::high_resolution_clock::now();
 
-				parallel_benchmark();
+				const bool converged = station->accumulate(accumulator, deadline, true);
 
 				detection_end = std::chrono::high_resolution_clock::now();
 				double detection_time = std::chrono::duration<double, std::milli>(detection_end - detection_start).count();
@@ -2273,7 +2667,8 @@ int main() {
 				std::cout << "✓ Visual detection completed in " << detection_time << " ms" << std::endl;
 
 				// 2. Cube Validation Phase
-				bool is_valid = validateCube();
+				// The accumulator only reports convergence for states that pass station->validate()
+				bool is_valid = converged;
 
 				if (is_valid) {
 					std::cout << "✓ Cube validation PASSED" << std::endl;
@@ -2306,40 +2701,106 @@ int main() {
 						std::cout << "❌ Solver error: " << solution << std::endl;
 					}
 				} else {
+					station->printValidationReport();
 					std::cout << "❌ Cube validation FAILED" << std::endl;
+					break; // the accumulator already used up the time budget
 				}
 
-				if (attempt < 3) {
-					std::cout << "Retrying..." << std::endl;
-				}
+				if (std::chrono::steady_clock::now() >= deadline) break;
+				std::cout << "Re-reading all stickers..." << std::endl;
+				accumulator.reset();
 			}
 			if (!success) {
-				std::cout << "\n❌ Failed to solve cube after 3 attempts" << std::endl;
+				std::cout << "\n❌ Failed to solve cube within " << config.accumulate_timeout_ms << " ms" << std::endl;
 				std::cout << "Try re-calibrating your colors or positions" << std::endl;
 			}
 		}
+		else if (k == 'p') {
+			std::cout << "\n=== Pipelined Throughput Mode ===" << std::endl;
+			station->loadCalibration();
+			initializeRobTwophase();
+			if (!solver_initialized) throw std::runtime_error("solver not initialized");
+
+			StationPipeline pipeline(*station, *solver_service, config.pipeline_queue_depth);
+			pipeline.onSolution([](const StationPipeline::Solution& solution) {
+				if (!solution.solved) {
+					std::cout << "❌ No solution found" << std::endl;
+					return;
+				}
+				std::cout << "📋 Solution:";
+				for (int move : solution.moves) {
+					std::cout << " " << move::names[move];
+				}
+				std::cout << " (" << solution.moves.size() << " moves, " << solution.latency_ms << " ms after capture)"
+						  << std::endl;
+			});
+			std::cout << "Press Enter to stop" << std::endl;
+			auto metrics_export = startMetricsExport();
+			pipeline.start();
+			std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+			std::cin.get();
+			pipeline.stop();
+			metrics_export.reset();
+
+			std::cout << "\n=== Pipeline Throughput ===" << std::endl;
+			pipeline.printStats();
+			station->printWhiteBalanceStats();
+			station->printTrackerStats();
+			if (trace::enabled()) {
+				std::cout << "\n=== Stage Trace ===" << std::endl;
+				trace::printSummary();
+			}
+		}
+		else if (k == 'e') {
+			std::cout << "\n=== Deadline Solve Mode ===" << std::endl;
+			station->loadCalibration();
+			initializeRobTwophase();
+			if (!solver_initialized) throw std::runtime_error("solver not initialized");
+
+			DeadlineSolve::Settings settings;
+			settings.deadline_ms = config.deadline_ms;
+			settings.solve_reserve_ms = config.deadline_solve_reserve_ms;
+			DeadlineSolve deadline_solve(*station, *solver_service, settings);
+			std::cout << "Preparing the solver engine for " << config.deadline_ms / 2 << " ms..." << std::endl;
+			deadline_solve.prepare();
+
+			// Every Enter is a trigger; the deadline runs from the moment it is read
+			std::cout << "Press Enter to solve within " << config.deadline_ms << " ms, q + Enter to stop" << std::endl;
+			std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+			std::string line;
+			while (std::getline(std::cin, line) && line != "q") {
+				const DeadlineSolve::Report report = deadline_solve.run(DeadlineSolve::Clock::now());
+				deadline_solve.printReport(report);
+			}
+
+			std::cout << "\n=== Deadline Solve Summary ===" << std::endl;
+			deadline_solve.printStats();
+			station->printWhiteBalanceStats();
+			station->printTrackerStats();
+			if (trace::enabled()) {
+				std::cout << "\n=== Stage Trace ===" << std::endl;
+				trace::printSummary();
+			}
+		}
 		else if (k == 'd') {
 			std::cout << "\n=== Dual Camera Display Mode ===" << std::endl;
 			show_camera_setup_guide();
 
 			// Optimize both cameras for dual operation
-			camera_1->optimizeForDualCamera();
-			camera_2->optimizeForDualCamera();
+			station->camera(0)->optimizeForDualCamera();
+			station->camera(1)->optimizeForDualCamera();
 
-			show_dual_camera_feed(camera_1, camera_2);
+			show_dual_camera_feed(station->camera(0), station->camera(1));
 		}
 		else if (k == 'v') {
 			std::cout << "\n=== Visual Debug Detection Mode ===" << std::endl;
-			init_lut();
-			init_mat();
-			load_position("pos_1.txt", "pos_2.txt");
-			load_lut_from_file("range.txt");
+			station->loadCalibration();
 
 			visual_debug_detection();
 		}
 		else if (k == 't') {
 			std::cout << "\n=== Test Calibrated Positions Mode ===" << std::endl;
-			load_position("pos_1.txt", "pos_2.txt");
+			station->loadPositions();
 
 			test_calibrated_positions();
 		}
@@ -2353,49 +2814,84 @@ int main() {
 			} else {
 				// Load color calibration if available
 				arduino_detector.loadColorCalibration("arduino_colors.txt");
+				std::cout << "RGB table agrees with the exact classification on "
+						  << arduino_detector.colorTableAgreement() * 100 << "% of all RGB values" << std::endl;
+
+				// The DETECTOR pipeline runs on the same frames for a side-by-side comparison
+				station->loadCalibration();
 
 				std::cout << "Controls:" << std::endl;
-				std::cout << "  SPACE = Detect cube" << std::endl;
+				std::cout << "  SPACE = Print detection details" << std::endl;
 				std::cout << "  C = Calibrate colors" << std::endl;
 				std::cout << "  Q = Quit" << std::endl;
 
 				cv::namedWindow("Arduino Detection", cv::WINDOW_NORMAL);
 				cv::resizeWindow("Arduino Detection", 1200, 400);
 
+				// Both detectors run on every frame; valid counts and mean cost are shown live
+				struct DetectorStats {
+					uint64_t frames = 0, valid = 0;
+					double total_us = 0;
+					void add(bool ok, double us) {
+						frames++;
+						valid += ok;
+						total_us += us;
+					}
+					std::string summary(const char* name) const {
+						std::ostringstream out;
+						out << name << ": " << valid << "/" << frames << " valid, "
+							<< (frames ? total_us / frames : 0.0) << " us/frame";
+						return out.str();
+					}
+				} arduino_stats, detector_stats;
+				auto elapsed_us = [](std::chrono::steady_clock::time_point since) {
+					return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - since).count();
+				};
+
 				while (true) {
 					cv::Mat frame1, frame2, combined;
-					camera_1->capture(frame1);
-					camera_2->capture(frame2);
+					station->camera(0)->capture(frame1);
+					station->camera(1)->capture(frame2);
 
+					std::array<char, 54> cube_state;
+					bool arduino_valid = false, detector_valid = false;
 					if (!frame1.empty() && !frame2.empty()) {
+						auto start = std::chrono::steady_clock::now();
+						arduino_valid = arduino_detector.detectCube(frame1, frame2, cube_state, false) != 0;
+						arduino_stats.add(arduino_valid, elapsed_us(start));
+
+						start = std::chrono::steady_clock::now();
+						station->detectPair(frame1, frame2);
+						detector_valid = station->validate();
+						detector_stats.add(detector_valid, elapsed_us(start));
+
 						cv::hconcat(frame1, frame2, combined);
-						cv::putText(combined, "SPACE=Detect, C=Calibrate, Q=Quit",
+						cv::putText(combined, "SPACE=Details, C=Calibrate, Q=Quit",
 								   cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
+						cv::putText(combined, arduino_stats.summary("RGB table"), cv::Point(10, 60),
+								   cv::FONT_HERSHEY_SIMPLEX, 0.5, arduino_valid ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255), 1);
+						cv::putText(combined, detector_stats.summary(station->detector().name()), cv::Point(10, 85),
+								   cv::FONT_HERSHEY_SIMPLEX, 0.5, detector_valid ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255), 1);
 						cv::imshow("Arduino Detection", combined);
 					}
 
-					int key = cv::waitKey(30) & 0xFF;
+					int key = cv::waitKey(1) & 0xFF;
 					if (key == 'q' || key == 'Q') break;
 
-					if (key == ' ') {
-						// Run detection
-						std::array<char, 54> cube_state;
-						auto start = std::chrono::high_resolution_clock::now();
-						int result = arduino_detector.detectCube(frame1, frame2, cube_state);
-						auto end = std::chrono::high_resolution_clock::now();
-						auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-
+					if (key == ' ' && !frame1.empty() && !frame2.empty()) {
 						std::cout << "\n--- Detection Results ---" << std::endl;
-						std::cout << "Detection time: " << duration.count() << " ms" << std::endl;
-						std::cout << "Result: " << (result ? "SUCCESS" : "FAILED") << std::endl;
+						std::cout << arduino_stats.summary("RGB table") << std::endl;
+						std::cout << detector_stats.summary(station->detector().name()) << std::endl;
+						std::cout << "Result: " << (arduino_valid ? "SUCCESS" : "FAILED") << std::endl;
 						arduino_detector.printCubeState(cube_state);
+						station->printValidationReport();
 					}
 
 					if (key == 'c' || key == 'C') {
 						// Run color calibration with capture callback
 						auto captureCallback = [&](cv::Mat& frame1, cv::Mat& frame2) -> bool {
-							if (camera_1) camera_1->capture(frame1);
-							if (camera_2) camera_2->capture(frame2);
+							if (station->camera(0)) station->camera(0)->capture(frame1);
+							if (station->camera(1)) station->camera(1)->capture(frame2);
 							return !frame1.empty() || !frame2.empty();
 						};
 						arduino_detector.calibrateColors(captureCallback);
@@ -2405,6 +2901,14 @@ int main() {
 				cv::destroyAllWindows();
 			}
 		}
+		else if (k == 'l') {
+			std::cout << "\n=== Color LUT Check ===" << std::endl;
+			verify_color_lut("range.txt");
+		}
+		else if (k == 'g') {
+			std::cout << "\n=== Face String Microbenchmark ===" << std::endl;
+			benchmark_face_string();
+		}
 		else if (k == 'q') {
 			std::cout << "Goodbye!" << std::endl;
 		}
@@ -2416,15 +2920,7 @@ int main() {
 	}
 
 	// Cleanup
-	cleanupRobTwophase();
-	if (camera_1) {
-		delete camera_1;
-		camera_1 = nullptr;
-	}
-	if (camera_2) {
-		delete camera_2;
-		camera_2 = nullptr;
-	}
+	cleanup();
 
 	return 0;
 }
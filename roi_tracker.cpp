@@ -0,0 +1,346 @@
+#include "roi_tracker.h"
+#include "trace.h"
+#include "yuyv.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// Brightest channel of a copied BGR or YUYV window: stickers are bright in at least one channel,
+// the plastic between them in none. Returns the contrast (largest minus smallest value).
+static int brightestChannel(const cv::Mat& window, cv::Mat& out) {
+	out.create(window.rows, window.cols, CV_8UC1);
+	const bool yuyv_window = yuyv::isYuyv(window);
+	uint8_t lowest = 255, highest = 0;
+	for (int y = 0; y < window.rows; y++) {
+		uint8_t* row = out.ptr<uint8_t>(y);
+		for (int x = 0; x < window.cols; x++) {
+			uint8_t b, g, r;
+			if (yuyv_window) {
+				yuyv::pixelBgr(window, x, y, b, g, r);
+			} else {
+				const cv::Vec3b& bgr = window.at<cv::Vec3b>(y, x);
+				b = bgr[0];
+				g = bgr[1];
+				r = bgr[2];
+			}
+			row[x] = std::max({b, g, r});
+			lowest = std::min(lowest, row[x]);
+			highest = std::max(highest, row[x]);
+		}
+	}
+	return highest > lowest ? highest - lowest : 0;
+}
+
+// A template flatter than this shows no sticker grid (no cube in view) and is taken again
+static constexpr int kMinTemplateContrast = 40;
+
+static double microsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+RoiTracker::RoiTracker(const Settings& settings) : settings(settings) {
+	this->settings.interval_frames = std::max(1, settings.interval_frames);
+	counters.interval = this->settings.interval_frames;
+	thread = std::thread(&RoiTracker::trackLoop, this);
+}
+
+RoiTracker::~RoiTracker() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void RoiTracker::reset(const std::vector<cv::Point>& points_1, const std::vector<cv::Point>& points_2) {
+	const std::vector<cv::Point>* points[2] = {&points_1, &points_2};
+	std::lock_guard<std::mutex> lock(mutex);
+	generation++;
+	has_tracked = false;
+	for (int cam = 0; cam < 2; cam++) {
+		Camera& camera = cameras[cam];
+		camera = Camera{};
+		camera.homography = cv::Mat::eye(3, 3, CV_64F);
+		if (points[cam]->size() != static_cast<size_t>(kFaces * kPointsPerFace)) continue;
+
+		for (const cv::Point& point : *points[cam]) {
+			camera.calibrated.emplace_back(static_cast<float>(point.x), static_cast<float>(point.y));
+		}
+		for (int face = 0; face < kFaces; face++) {
+			// Per face: TL, T, TR, L, R, BL, B, BR; the template reaches half a sticker past them
+			const cv::Point* p = points[cam]->data() + face * kPointsPerFace;
+			const int spacing = std::max(4, static_cast<int>(std::hypot(p[1].x - p[0].x, p[1].y - p[0].y)));
+			int x_min = p[0].x, x_max = p[0].x, y_min = p[0].y, y_max = p[0].y;
+			for (int i = 1; i < kPointsPerFace; i++) {
+				x_min = std::min(x_min, p[i].x);
+				x_max = std::max(x_max, p[i].x);
+				y_min = std::min(y_min, p[i].y);
+				y_max = std::max(y_max, p[i].y);
+			}
+			const int margin = spacing * 3 / 5;
+			camera.face_rect[face] = cv::Rect(x_min - margin, y_min - margin, x_max - x_min + 2 * margin,
+											  y_max - y_min + 2 * margin);
+		}
+	}
+	// Captured from the pair offered at the next interval
+	capture_templates = !cameras[0].calibrated.empty() || !cameras[1].calibrated.empty();
+}
+
+cv::Rect RoiTracker::searchWindow(const Camera& camera, int face, const cv::Size& frame_size, bool yuyv) const {
+	const cv::Rect& base = camera.face_rect[face];
+	const int search = capture_templates ? 0 : settings.search_px;
+	int x0 = base.x + static_cast<int>(std::lround(camera.offset[face].x)) - search;
+	int y0 = base.y + static_cast<int>(std::lround(camera.offset[face].y)) - search;
+	int x1 = x0 + base.width + 2 * search;
+	int y1 = y0 + base.height + 2 * search;
+	x0 = std::clamp(x0, 0, frame_size.width);
+	y0 = std::clamp(y0, 0, frame_size.height);
+	x1 = std::clamp(x1, 0, frame_size.width);
+	y1 = std::clamp(y1, 0, frame_size.height);
+	if (yuyv) {
+		// Keep whole Y0 U Y1 V macropixels
+		x0 &= ~1;
+		x1 &= ~1;
+	}
+	return cv::Rect(x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0));
+}
+
+void RoiTracker::offer(const cv::Mat& frame_1, const cv::Mat& frame_2) {
+	if (--frames_until_offer > 0) return;
+	const auto start = std::chrono::steady_clock::now();
+	std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+	if (!lock.owns_lock()) {
+		frames_until_offer = 1;
+		return;
+	}
+	frames_until_offer = counters.interval;
+	if (has_work) {
+		counters.skipped++;
+		return;
+	}
+
+	const cv::Mat* frames[2] = {&frame_1, &frame_2};
+	bool any = false;
+	for (int cam = 0; cam < 2; cam++) {
+		const Camera& camera = cameras[cam];
+		if (camera.calibrated.empty() || frames[cam]->empty()) {
+			for (cv::Rect& rect : window_rects[cam]) rect = cv::Rect();
+			continue;
+		}
+		const bool yuyv_frame = yuyv::isYuyv(*frames[cam]);
+		for (int face = 0; face < kFaces; face++) {
+			const cv::Rect rect = searchWindow(camera, face, frames[cam]->size(), yuyv_frame);
+			window_rects[cam][face] = rect;
+			if (rect.width < 2 || rect.height < 2) continue;
+			(*frames[cam])(rect).copyTo(windows[cam][face]);
+			any = true;
+		}
+	}
+	if (!any) return;
+
+	window_generation = generation;
+	window_templates = capture_templates;
+	capture_templates = false;
+	has_work = true;
+	counters.offered++;
+	const double handoff_us = microsSince(start);
+	counters.handoff_us += handoff_us;
+	counters.handoff_max_us = std::max(counters.handoff_max_us, handoff_us);
+	lock.unlock();
+	wake.notify_one();
+}
+
+bool RoiTracker::take(std::vector<cv::Point>& points_1, std::vector<cv::Point>& points_2) {
+	std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+	if (!lock.owns_lock() || !has_tracked) return false;
+	has_tracked = false;
+	// Assigned in place: the detectors keep referring to the caller's vectors
+	if (!tracked[0].empty()) points_1 = tracked[0];
+	if (!tracked[1].empty()) points_2 = tracked[1];
+	return true;
+}
+
+void RoiTracker::trackLoop() {
+	trace::nameThread("roi tracker");
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stopping || has_work; });
+			if (stopping) return;
+		}
+		pass();
+	}
+}
+
+void RoiTracker::pass() {
+	trace::Scope scope(trace::Stage::Track);
+	const auto start = std::chrono::steady_clock::now();
+
+	// The slot is not written while has_work is set, so its Mats are only referenced here
+	Camera state[2];
+	cv::Mat raw[2][kFaces];
+	cv::Rect rects[2][kFaces];
+	bool templates;
+	uint64_t pass_generation;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int cam = 0; cam < 2; cam++) {
+			state[cam] = cameras[cam];
+			for (int face = 0; face < kFaces; face++) {
+				raw[cam][face] = windows[cam][face];
+				rects[cam][face] = window_rects[cam][face];
+			}
+		}
+		templates = window_templates;
+		pass_generation = window_generation;
+	}
+
+	std::vector<cv::Point> moved[2];
+	int rejected = 0;
+	bool retake_templates = false;
+	cv::Mat window, scores;
+	for (int cam = 0; cam < 2; cam++) {
+		Camera& camera = state[cam];
+		if (camera.calibrated.empty()) continue;
+
+		if (templates) {
+			for (int face = 0; face < kFaces; face++) {
+				if (rects[cam][face].width < 2 || rects[cam][face].height < 2) continue;
+				camera.face_rect[face] = rects[cam][face];
+				if (brightestChannel(raw[cam][face], camera.face_template[face]) < kMinTemplateContrast) {
+					retake_templates = true;
+				}
+			}
+			continue;
+		}
+
+		// Every matched face moves its eight points by the same offset; the homography blends them
+		std::vector<cv::Point2f> from, to;
+		bool found[kFaces] = {false, false, false};
+		cv::Point2f offsets[kFaces];
+		for (int face = 0; face < kFaces; face++) {
+			const cv::Mat& face_template = camera.face_template[face];
+			const cv::Rect& rect = rects[cam][face];
+			if (face_template.empty() || rect.width < face_template.cols || rect.height < face_template.rows) continue;
+			brightestChannel(raw[cam][face], window);
+			cv::matchTemplate(window, face_template, scores, cv::TM_CCOEFF_NORMED);
+			double best = 0;
+			cv::Point location;
+			cv::minMaxLoc(scores, nullptr, &best, nullptr, &location);
+			if (!(best >= settings.min_score)) continue; // also a NaN score of a flat window
+
+			const cv::Point2f offset(static_cast<float>(rect.x + location.x - camera.face_rect[face].x),
+									 static_cast<float>(rect.y + location.y - camera.face_rect[face].y));
+			offsets[face] = offset;
+			found[face] = true;
+			for (int i = 0; i < kPointsPerFace; i++) {
+				from.push_back(camera.calibrated[face * kPointsPerFace + i]);
+				to.push_back(camera.calibrated[face * kPointsPerFace + i] + offset);
+			}
+		}
+		if (from.empty()) {
+			rejected++;
+			continue;
+		}
+
+		cv::Mat homography;
+		if (from.size() == static_cast<size_t>(kPointsPerFace)) {
+			homography = cv::Mat::eye(3, 3, CV_64F);
+			homography.at<double>(0, 2) = to[0].x - from[0].x;
+			homography.at<double>(1, 2) = to[0].y - from[0].y;
+		} else {
+			homography = cv::findHomography(from, to, 0);
+		}
+		if (homography.empty()) {
+			rejected++;
+			continue;
+		}
+
+		std::vector<cv::Point2f> mapped;
+		cv::perspectiveTransform(camera.calibrated, mapped, homography);
+		bool plausible = mapped.size() == camera.calibrated.size();
+		for (size_t i = 0; plausible && i < mapped.size(); i++) {
+			const cv::Point2f shift = mapped[i] - camera.calibrated[i];
+			plausible = std::isfinite(shift.x) && std::isfinite(shift.y) &&
+						std::hypot(shift.x, shift.y) <= settings.max_shift_px;
+		}
+		if (!plausible) {
+			rejected++;
+			continue;
+		}
+
+		camera.homography = homography;
+		for (int face = 0; face < kFaces; face++) {
+			if (found[face]) {
+				camera.offset[face] = offsets[face];
+				continue;
+			}
+			// A face that was not found is searched for where the other faces say it is
+			cv::Point2f center(0, 0);
+			for (int i = 0; i < kPointsPerFace; i++) {
+				center += mapped[face * kPointsPerFace + i] - camera.calibrated[face * kPointsPerFace + i];
+			}
+			camera.offset[face] = center * (1.0f / kPointsPerFace);
+		}
+		for (const cv::Point2f& point : mapped) {
+			moved[cam].emplace_back(static_cast<int>(std::lround(point.x)), static_cast<int>(std::lround(point.y)));
+		}
+	}
+
+	const double pass_us = microsSince(start);
+	std::lock_guard<std::mutex> lock(mutex);
+	has_work = false;
+	counters.passes++;
+	counters.pass_us += pass_us;
+	counters.pass_max_us = std::max(counters.pass_max_us, pass_us);
+	if (pass_us > settings.budget_us) {
+		counters.overruns++;
+		counters.interval = std::min(counters.interval * 2, settings.interval_frames * 8);
+	} else if (pass_us < settings.budget_us / 2 && counters.interval > settings.interval_frames) {
+		counters.interval = std::max(settings.interval_frames, counters.interval / 2);
+	}
+	// A reset() during the pass made its templates and fits obsolete
+	if (pass_generation != generation) return;
+
+	counters.rejected += rejected;
+	if (retake_templates) {
+		capture_templates = true;
+		return;
+	}
+	bool changed = false;
+	for (int cam = 0; cam < 2; cam++) {
+		cameras[cam] = state[cam];
+		if (moved[cam].empty()) continue;
+		if (moved[cam] != tracked[cam]) changed = true;
+		float shift = 0;
+		for (size_t i = 0; i < moved[cam].size(); i++) {
+			const cv::Point2f delta = cv::Point2f(static_cast<float>(moved[cam][i].x), static_cast<float>(moved[cam][i].y)) -
+									  cameras[cam].calibrated[i];
+			shift += std::hypot(delta.x, delta.y);
+		}
+		counters.shift_px[cam] = shift / moved[cam].size();
+		tracked[cam] = std::move(moved[cam]);
+	}
+	if (changed) {
+		counters.updates++;
+		has_tracked = true;
+	}
+}
+
+RoiTracker::Stats RoiTracker::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void RoiTracker::printStats(const char* prefix) const {
+	const Stats s = stats();
+	std::cout << prefix << "ROI tracker: " << s.passes << " passes (" << s.updates << " moved the points, "
+			  << s.rejected << " fits rejected, " << s.skipped << " pairs skipped while busy), pass "
+			  << (s.passes ? s.pass_us / s.passes : 0.0) << " us mean / " << s.pass_max_us << " us max ("
+			  << s.overruns << " over " << settings.budget_us << " us), handoff "
+			  << (s.offered ? s.handoff_us / s.offered : 0.0) << " us mean / " << s.handoff_max_us
+			  << " us max, shift " << s.shift_px[0] << " / " << s.shift_px[1] << " px, every " << s.interval
+			  << " pairs" << std::endl;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Follows small cube or camera shifts so the sticker points stay on the stickers without a
+// recalibration.
+//
+// When calibrated, every face of a camera is cut out around its eight sticker points as a
+// template of the frame's brightest channel: the dark plastic between the stickers is dark
+// whatever the sticker colors, so the grid matches across scrambles. Every `interval_frames`
+// pairs the detecting thread copies only a small search window around each face's expected
+// position into the tracker's slot and returns; a tracker thread matches the templates there
+// (normalized cross-correlation), fits a homography per camera from the faces that matched, and
+// maps the calibrated points through it. The detecting thread picks the new points up with
+// take() before its next detection. None of this waits on the tracker: a pair offered while the
+// last one is still being matched is skipped.
+//
+// A pass that runs over `budget_us` stretches the interval (up to 8x) until passes fit again.
+class RoiTracker {
+public:
+	struct Settings {
+		int interval_frames = 10;
+		int search_px = 12;        // how far a face may have moved between two passes
+		int budget_us = 2000;      // tracker time per pass before the interval is stretched
+		float min_score = 0.6f;    // correlation a face needs to count as found
+		int max_shift_px = 60;     // total displacement from the calibration beyond which a fit is rejected
+	};
+
+	// Counters since construction; *_us are sums
+	struct Stats {
+		uint64_t offered = 0;  // frame pairs handed over
+		uint64_t skipped = 0;  // ... dropped because the tracker was still busy
+		uint64_t passes = 0;
+		uint64_t updates = 0;  // passes that moved the points
+		uint64_t rejected = 0; // camera fits refused (no face found, implausible shift)
+		uint64_t overruns = 0; // passes over the budget
+		double handoff_us = 0; // copying the search windows on the detecting thread
+		double handoff_max_us = 0;
+		double pass_us = 0;
+		double pass_max_us = 0;
+		float shift_px[2] = {0, 0}; // mean point displacement from the calibration per camera
+		int interval = 0;           // current interval in frame pairs
+	};
+
+	explicit RoiTracker(const Settings& settings);
+	~RoiTracker();
+
+	RoiTracker(const RoiTracker&) = delete;
+	RoiTracker& operator=(const RoiTracker&) = delete;
+
+	// Calibrated points (24 per camera, three faces of eight); templates are cut from the pair
+	// offered at the next interval, which should show the cube where it was calibrated
+	void reset(const std::vector<cv::Point>& points_1, const std::vector<cv::Point>& points_2);
+	// Detecting thread, every frame pair (BGR or YUYV). Never blocks.
+	void offer(const cv::Mat& frame_1, const cv::Mat& frame_2);
+	// Detecting thread: true, with the tracked points of both cameras, after a pass moved them
+	bool take(std::vector<cv::Point>& points_1, std::vector<cv::Point>& points_2);
+
+	Stats stats() const;
+	void printStats(const char* prefix = "") const;
+
+	static constexpr int kFaces = 3;
+	static constexpr int kPointsPerFace = 8;
+
+private:
+	struct Camera {
+		std::vector<cv::Point2f> calibrated;
+		cv::Rect face_rect[kFaces]; // template rectangles at the calibrated position
+		cv::Mat face_template[kFaces];
+		cv::Mat homography;         // calibrated → current, 3x3 CV_64F
+		cv::Point2f offset[kFaces]; // current face displacement the search windows are centered on
+	};
+
+	void trackLoop();
+	void pass();
+	// Search window of one face around its current position, clipped to the frame
+	cv::Rect searchWindow(const Camera& camera, int face, const cv::Size& frame_size, bool yuyv) const;
+
+	Settings settings;
+	Camera cameras[2];
+
+	mutable std::mutex mutex;
+	std::condition_variable wake;
+	bool has_work = false;
+	bool capture_templates = false;
+	bool stopping = false;
+	uint64_t generation = 0; // bumped by reset(), so a pass over old points is discarded
+	int frames_until_offer = 0; // detecting thread only
+	// Slot: copies of the search windows and where they were cut from
+	cv::Mat windows[2][kFaces];
+	cv::Rect window_rects[2][kFaces];
+	uint64_t window_generation = 0;
+	bool window_templates = false;
+
+	std::vector<cv::Point> tracked[2];
+	bool has_tracked = false;
+	Stats counters;
+
+	std::thread thread;
+};
@@ -0,0 +1,258 @@
+#include "solution_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+constexpr char kMagic[8] = {'R', 'C', 'S', 'O', 'L', 'V', 'E', '\0'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t count;
+};
+
+struct FileEntry {
+	uint64_t corners;
+	uint64_t edges;
+	float search_ms;
+	uint8_t length;
+	uint8_t moves[SolutionCache::kMaxMoves];
+};
+
+cubie::cube conjugated(const cubie::cube& cube, int symmetry) {
+	cubie::cube left, result;
+	cubie::mul(sym::cubes[symmetry], cube, left);
+	cubie::mul(left, sym::cubes[sym::inv[symmetry]], result);
+	return result;
+}
+
+bool solves(const cubie::cube& cube, const std::vector<int>& moves) {
+	cubie::cube current = cube, next;
+	for (int move : moves) {
+		cubie::mul(current, move::cubes[move], next);
+		current = next;
+	}
+	for (int i = 0; i < cubie::corner::COUNT; i++) {
+		if (current.cperm[i] != i || current.cori[i] != 0) return false;
+	}
+	for (int i = 0; i < cubie::edge::COUNT; i++) {
+		if (current.eperm[i] != i || current.eori[i] != 0) return false;
+	}
+	return true;
+}
+
+} // namespace
+
+SolutionCache::SolutionCache(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {
+	for (int s = 0; s < sym::COUNT; s++) {
+		for (int m = 0; m < move::COUNT; m++) {
+			// S⁻¹·M·S, i.e. the conjugate by the inverse symmetry
+			const cubie::cube target = conjugated(move::cubes[m], sym::inv[s]);
+			int found = -1;
+			for (int candidate = 0; candidate < move::COUNT && found < 0; candidate++) {
+				if (move::cubes[candidate] == target) found = candidate;
+			}
+			if (found < 0) conjugates_complete = false;
+			conjugate[s][m] = static_cast<uint8_t>(found < 0 ? 0 : found);
+		}
+	}
+	if (!conjugates_complete) {
+		std::cerr << "Warning: Symmetry tables do not map moves onto moves, solution cache disabled" << std::endl;
+	}
+}
+
+SolutionCache::Key SolutionCache::encode(const cubie::cube& cube) {
+	Key key{0, 0};
+	for (int i = 0; i < cubie::corner::COUNT; i++) {
+		key.corners = key.corners << 5 | static_cast<uint64_t>(cube.cperm[i]) << 2 | static_cast<uint64_t>(cube.cori[i]);
+	}
+	for (int i = 0; i < cubie::edge::COUNT; i++) {
+		key.edges = key.edges << 5 | static_cast<uint64_t>(cube.eperm[i]) << 1 | static_cast<uint64_t>(cube.eori[i]);
+	}
+	return key;
+}
+
+SolutionCache::Key SolutionCache::canonical(const cubie::cube& cube, int& symmetry) const {
+	Key best = encode(conjugated(cube, 0));
+	symmetry = 0;
+	for (int s = 1; s < sym::COUNT; s++) {
+		const Key key = encode(conjugated(cube, s));
+		if (key.corners < best.corners || (key.corners == best.corners && key.edges < best.edges)) {
+			best = key;
+			symmetry = s;
+		}
+	}
+	return best;
+}
+
+bool SolutionCache::lookup(const cubie::cube& cube, std::vector<int>& moves) {
+	if (!conjugates_complete) return false;
+	const auto start = std::chrono::steady_clock::now();
+	int symmetry;
+	const Key key = canonical(cube, symmetry);
+
+	float search_ms;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		counters.lookups++;
+		auto it = index.find(key);
+		if (it == index.end()) return false;
+		entries.splice(entries.begin(), entries, it->second);
+		moves.clear();
+		for (uint8_t move : it->second->moves) {
+			moves.push_back(conjugate[symmetry][move]);
+		}
+		search_ms = it->second->search_ms;
+	}
+
+	if (!solves(cube, moves)) {
+		std::lock_guard<std::mutex> lock(mutex);
+		counters.rejected++;
+		auto it = index.find(key);
+		if (it != index.end()) {
+			entries.erase(it->second);
+			index.erase(it);
+		}
+		moves.clear();
+		return false;
+	}
+
+	const double lookup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::lock_guard<std::mutex> lock(mutex);
+	counters.hits++;
+	counters.saved_ms += search_ms - lookup_ms;
+	return true;
+}
+
+void SolutionCache::insert(const cubie::cube& cube, const std::vector<int>& moves, double search_ms) {
+	if (!conjugates_complete || moves.size() > kMaxMoves) return;
+	int symmetry;
+	const Key key = canonical(cube, symmetry);
+	// The canonical state is S·cube·S⁻¹, so its solution is S·M·S⁻¹ for every move M
+	std::vector<uint8_t> canonical_moves;
+	canonical_moves.reserve(moves.size());
+	for (int move : moves) {
+		canonical_moves.push_back(conjugate[sym::inv[symmetry]][move]);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	store(key, std::move(canonical_moves), static_cast<float>(search_ms));
+}
+
+void SolutionCache::store(const Key& key, std::vector<uint8_t> moves, float search_ms) {
+	auto it = index.find(key);
+	if (it != index.end()) {
+		// Keep the shorter solution of two searches of the same state
+		Entry& entry = *it->second;
+		if (moves.size() < entry.moves.size()) entry.moves = std::move(moves);
+		entry.search_ms = std::max(entry.search_ms, search_ms);
+		entries.splice(entries.begin(), entries, it->second);
+		return;
+	}
+	entries.push_front({key, std::move(moves), search_ms});
+	index.emplace(key, entries.begin());
+	if (entries.size() > capacity) {
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
+
+bool SolutionCache::load(const std::string& filename) {
+	std::ifstream in(filename, std::ios::binary);
+	if (!in.is_open()) return false;
+	FileHeader header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+		std::cerr << "Warning: " << filename << " is not a solution cache of this version" << std::endl;
+		return false;
+	}
+
+	std::vector<FileEntry> file_entries(std::min<size_t>(header.count, capacity));
+	if (!in.read(reinterpret_cast<char*>(file_entries.data()), file_entries.size() * sizeof(FileEntry))) {
+		std::cerr << "Warning: " << filename << " is truncated" << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	// Stored most recent first; inserting from the back keeps that order
+	for (auto it = file_entries.rbegin(); it != file_entries.rend(); ++it) {
+		if (it->length > kMaxMoves) continue;
+		std::vector<uint8_t> moves(it->moves, it->moves + it->length);
+		bool valid = true;
+		for (uint8_t move : moves) {
+			if (move >= move::COUNT) valid = false;
+		}
+		if (valid) store({it->corners, it->edges}, std::move(moves), it->search_ms);
+	}
+	return true;
+}
+
+bool SolutionCache::save(const std::string& filename) const {
+	std::vector<FileEntry> file_entries;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		file_entries.reserve(entries.size());
+		for (const Entry& entry : entries) {
+			FileEntry file_entry;
+			std::memset(&file_entry, 0, sizeof(file_entry));
+			file_entry.corners = entry.key.corners;
+			file_entry.edges = entry.key.edges;
+			file_entry.search_ms = entry.search_ms;
+			file_entry.length = static_cast<uint8_t>(entry.moves.size());
+			std::memcpy(file_entry.moves, entry.moves.data(), entry.moves.size());
+			file_entries.push_back(file_entry);
+		}
+	}
+
+	FileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.count = static_cast<uint32_t>(file_entries.size());
+
+	// Write to a temporary and rename, so a starting process never reads half a cache
+	const std::string tmp_path = filename + ".tmp";
+	{
+		std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+		if (!out.is_open()) {
+			std::cerr << "Error: Could not open " << tmp_path << " for writing" << std::endl;
+			return false;
+		}
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(file_entries.data()), file_entries.size() * sizeof(FileEntry));
+		if (!out) {
+			std::cerr << "Error: Could not write " << tmp_path << std::endl;
+			return false;
+		}
+	}
+	if (std::rename(tmp_path.c_str(), filename.c_str()) != 0) {
+		std::cerr << "Error: Could not replace " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+SolutionCache::Stats SolutionCache::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	Stats result = counters;
+	result.entries = entries.size();
+	return result;
+}
+
+void SolutionCache::printStats() const {
+	const Stats s = stats();
+	std::ostringstream line;
+	line << "Solution cache: " << s.lookups << " lookups, " << s.hits << " hits (" << std::fixed << std::setprecision(1)
+		 << (s.lookups > 0 ? 100.0 * s.hits / s.lookups : 0.0) << "%), " << s.saved_ms << " ms of search saved, "
+		 << s.entries << " entries";
+	if (s.rejected > 0) line << ", " << s.rejected << " rejected";
+	std::cout << line.str() << std::endl;
+}
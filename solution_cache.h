@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cubie.h"
+#include "move.h"
+#include "sym.h"
+
+// LRU cache of solutions keyed on the cube state up to symmetry.
+//
+// A state is reduced to the smallest packed encoding among its 48 conjugates S·c·S⁻¹ (the
+// rotations and reflections from sym), so a scramble seen in another orientation, or mirrored,
+// hits the same entry. Entries hold the solution of that canonical state; on a hit the moves are
+// conjugated back with the symmetry that produced the canonical form, and the result is applied
+// to the cube once before it is returned, so a bad entry is dropped instead of answered.
+class SolutionCache {
+public:
+	struct Stats {
+		uint64_t lookups = 0;
+		uint64_t hits = 0;
+		uint64_t rejected = 0; // entries whose conjugated moves did not solve the cube
+		double saved_ms = 0;   // search time of the original solves, minus the lookups themselves
+		size_t entries = 0;
+	};
+
+	// move::init() and sym::init() must have run. Longer solutions than kMaxMoves are not stored.
+	explicit SolutionCache(size_t capacity);
+
+	static constexpr size_t kMaxMoves = 31;
+
+	// Fills `moves` with a solution of `cube` if an equivalent state was solved before
+	bool lookup(const cubie::cube& cube, std::vector<int>& moves);
+	// `search_ms` is what the solve took, credited to every later hit
+	void insert(const cubie::cube& cube, const std::vector<int>& moves, double search_ms);
+
+	// Entries are written most recently used first and read back in that order. A missing file is
+	// not an error; a damaged one is ignored with a warning.
+	bool load(const std::string& filename);
+	bool save(const std::string& filename) const;
+
+	bool usable() const { return conjugates_complete; }
+	Stats stats() const;
+	void printStats() const;
+
+private:
+	struct Key {
+		uint64_t corners; // 8 x (3-bit permutation, 2-bit orientation)
+		uint64_t edges;   // 12 x (4-bit permutation, 1-bit orientation)
+		bool operator==(const Key& other) const { return corners == other.corners && edges == other.edges; }
+	};
+	struct KeyHash {
+		size_t operator()(const Key& key) const { return key.corners * 0x9E3779B97F4A7C15ull ^ key.edges; }
+	};
+	struct Entry {
+		Key key;
+		std::vector<uint8_t> moves; // solution of the canonical state
+		float search_ms;
+	};
+
+	static Key encode(const cubie::cube& cube);
+	// Smallest encoding over the 48 conjugates, and the symmetry S with canonical = S·cube·S⁻¹
+	Key canonical(const cubie::cube& cube, int& symmetry) const;
+	// Caller holds the mutex
+	void store(const Key& key, std::vector<uint8_t> moves, float search_ms);
+
+	const size_t capacity;
+	// conjugate[s][m] is the move S⁻¹·M·S; complete unless sym and move disagree on conventions
+	uint8_t conjugate[sym::COUNT][move::COUNT];
+	bool conjugates_complete = true;
+
+	mutable std::mutex mutex;
+	std::list<Entry> entries; // most recently used first
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+	Stats counters;
+};
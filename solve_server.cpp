@@ -0,0 +1,326 @@
+#include "solve_server.h"
+#include "face.h"
+#include "move.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// Longest request line a client may send before it is disconnected
+static constexpr size_t kMaxLineLength = 4096;
+
+bool solve_server::toCube(const std::string& face_string, cubie::cube& cube, std::string& error) {
+	int face_error = face::to_cubie(face_string, cube);
+	if (face_error != 0) {
+		error = "Invalid face string (error " + std::to_string(face_error) + ")";
+		return false;
+	}
+	int cubie_error = cubie::check(cube);
+	if (cubie_error != 0) {
+		error = "Invalid cube state (error " + std::to_string(cubie_error) + ")";
+		return false;
+	}
+	return true;
+}
+
+void SolveStream::Stats::add(const Stats& other) {
+	// Counts only: the elapsed times of concurrent streams overlap
+	requests += other.requests;
+	solved += other.solved;
+	unsolved += other.unsolved;
+	invalid += other.invalid;
+	search_ms += other.search_ms;
+}
+
+void SolveStream::Stats::print(const char* label) const {
+	std::ostringstream line;
+	line << "✓ " << label << ": " << requests << " face strings, " << solved << " solved, " << unsolved
+		 << " unsolved, " << invalid << " invalid in " << std::fixed << std::setprecision(2) << elapsed_s << " s ("
+		 << solvesPerSecond() << " solves/s, mean search " << (solved > 0 ? search_ms / solved : 0.0) << " ms)";
+	std::cout << line.str() << std::endl;
+}
+
+SolveStream::SolveStream(SolverService& service, int parallelism) :
+	service(service), parallelism(static_cast<size_t>(std::max(1, parallelism))) {}
+
+SolveStream::Stats SolveStream::run(const ReadLine& read_line, const WriteLine& write_line) {
+	struct Pending {
+		uint64_t line = 0;
+		std::string error; // set if the face string was rejected before solving
+		std::future<SolverService::Result> result;
+	};
+
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<Pending> pending;
+	size_t in_flight = 0; // popped by the writer but possibly still queued on the service
+	bool input_done = false;
+	std::chrono::steady_clock::time_point first_request;
+	// Set once the output is gone; queued cubes are then skipped by the service
+	auto cancel = std::make_shared<std::atomic<bool>>(false);
+
+	// Replies are written in input order; everything but `requests` is counted here
+	Stats stats;
+	std::chrono::steady_clock::time_point last_reply;
+	std::thread writer([&] {
+		while (true) {
+			Pending next;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [&] { return input_done || !pending.empty(); });
+				if (pending.empty()) break;
+				next = std::move(pending.front());
+				pending.pop_front();
+				in_flight = next.error.empty() ? 1 : 0;
+			}
+			changed.notify_all();
+
+			std::ostringstream reply;
+			reply << next.line;
+			if (!next.error.empty()) {
+				stats.invalid++;
+				reply << " ERROR " << next.error;
+			} else {
+				const SolverService::Result result = next.result.get();
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					in_flight = 0;
+				}
+				changed.notify_all();
+				if (result.cancelled) continue;
+				if (!result.solved) {
+					stats.unsolved++;
+					reply << " ERROR No solution found";
+				} else {
+					stats.solved++;
+					stats.search_ms += result.search_ms;
+					reply << " OK " << result.moves.size() << std::fixed << std::setprecision(2) << " "
+						  << result.queue_wait_ms << " " << result.search_ms;
+					for (int move : result.moves) {
+						reply << " " << move::names[move];
+					}
+				}
+			}
+			if (!cancel->load(std::memory_order_acquire) && !write_line(reply.str())) {
+				cancel->store(true, std::memory_order_release);
+			}
+			last_reply = std::chrono::steady_clock::now();
+		}
+	});
+
+	uint64_t requests = 0;
+	uint64_t line_number = 0;
+	std::string line;
+	while (!cancel->load(std::memory_order_acquire) && read_line(line)) {
+		line_number++;
+		const size_t begin = line.find_first_not_of(" \t\r");
+		if (begin == std::string::npos || line[begin] == '#') continue;
+		const std::string face_string = line.substr(begin, line.find_last_not_of(" \t\r") + 1 - begin);
+
+		Pending request;
+		request.line = line_number;
+		cubie::cube cube;
+		// Submitting only once there is room keeps at most `parallelism` cubes queued on the service
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [&] { return pending.size() + in_flight < parallelism; });
+		if (requests++ == 0) first_request = std::chrono::steady_clock::now();
+		if (solve_server::toCube(face_string, cube, request.error)) {
+			request.result = service.submit(cube, cancel);
+		}
+		pending.push_back(std::move(request));
+		lock.unlock();
+		changed.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		input_done = true;
+	}
+	changed.notify_all();
+	writer.join();
+	stats.requests = requests;
+	if (stats.solved + stats.unsolved + stats.invalid > 0) {
+		stats.elapsed_s = std::chrono::duration<double>(last_reply - first_request).count();
+	}
+	return stats;
+}
+
+SolveServer::SolveServer(SolverService& service, int parallelism) : service(service), parallelism(parallelism) {}
+
+SolveServer::~SolveServer() {
+	stop();
+}
+
+bool SolveServer::start(const std::string& address, int port) {
+	sockaddr_in socket_address{};
+	socket_address.sin_family = AF_INET;
+	socket_address.sin_port = htons(static_cast<uint16_t>(port));
+	if (inet_pton(AF_INET, address.c_str(), &socket_address.sin_addr) != 1) {
+		std::cerr << "Error: Invalid solve server address " << address << std::endl;
+		return false;
+	}
+
+	// Non-blocking, so a client that resets before accept4() cannot leave the accept thread stuck
+	listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	const int reuse = 1;
+	socklen_t length = sizeof(socket_address);
+	if (listen_fd < 0 || setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+		bind(listen_fd, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) < 0 ||
+		listen(listen_fd, 16) < 0 ||
+		getsockname(listen_fd, reinterpret_cast<sockaddr*>(&socket_address), &length) < 0) {
+		std::cerr << "Error: Could not listen on " << address << ":" << port << " (" << std::strerror(errno) << ")"
+				  << std::endl;
+		if (listen_fd >= 0) close(listen_fd);
+		listen_fd = -1;
+		return false;
+	}
+	bound_port = ntohs(socket_address.sin_port);
+
+	stop_fd = eventfd(0, EFD_CLOEXEC);
+	if (stop_fd < 0) {
+		std::cerr << "Error: Could not create the solve server's stop event" << std::endl;
+		close(listen_fd);
+		listen_fd = -1;
+		return false;
+	}
+	started = std::chrono::steady_clock::now();
+	accept_thread = std::thread(&SolveServer::acceptLoop, this);
+	return true;
+}
+
+void SolveServer::stop() {
+	if (!accept_thread.joinable()) return;
+	const uint64_t one = 1;
+	if (::write(stop_fd, &one, sizeof(one)) < 0) {
+		std::cerr << "Warning: Could not stop the solve server" << std::endl;
+	}
+	accept_thread.join();
+	close(listen_fd);
+	close(stop_fd);
+	listen_fd = stop_fd = -1;
+
+	// A shut-down socket ends the client's stream at its next read or write; cubes it still had
+	// queued are skipped by the service
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (Connection& connection : connections) {
+			shutdown(connection.fd, SHUT_RDWR);
+		}
+	}
+	reapConnections(true);
+}
+
+SolveStream::Stats SolveServer::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	SolveStream::Stats result = totals;
+	result.elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	return result;
+}
+
+void SolveServer::printStats() const {
+	uint64_t client_count;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		client_count = clients;
+	}
+	const std::string label = "Solve server (" + std::to_string(client_count) + " clients)";
+	stats().print(label.c_str());
+}
+
+void SolveServer::acceptLoop() {
+	pollfd fds[2] = {{listen_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+	while (true) {
+		if (poll(fds, 2, -1) < 0) {
+			// revents are left as they were; only read them after a successful poll
+			if (errno == EINTR) continue;
+			return;
+		}
+		if (fds[1].revents & POLLIN) return;
+		if (!(fds[0].revents & POLLIN)) continue;
+
+		const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+		if (fd < 0) continue;
+		reapConnections(false);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		Connection& connection = connections.emplace_back();
+		connection.fd = fd;
+		connection.thread = std::thread(&SolveServer::serve, this, std::ref(connection));
+	}
+}
+
+void SolveServer::serve(Connection& connection) {
+	const int fd = connection.fd;
+	std::string buffer;
+	char chunk[4096];
+	const SolveStream::ReadLine read_line = [&](std::string& line) {
+		while (true) {
+			const size_t newline = buffer.find('\n');
+			if (newline != std::string::npos) {
+				line.assign(buffer, 0, newline);
+				buffer.erase(0, newline + 1);
+				return true;
+			}
+			if (buffer.size() > kMaxLineLength) return false;
+			const ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+			if (received < 0 && errno == EINTR) continue;
+			if (received <= 0) {
+				// A last line without a newline still counts
+				line = std::move(buffer);
+				buffer.clear();
+				return !line.empty();
+			}
+			buffer.append(chunk, static_cast<size_t>(received));
+		}
+	};
+	const SolveStream::WriteLine write_line = [fd](const std::string& line) {
+		const std::string reply = line + "\n";
+		for (size_t sent = 0; sent < reply.size();) {
+			const ssize_t written = send(fd, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+			if (written < 0 && errno == EINTR) continue;
+			if (written <= 0) return false;
+			sent += static_cast<size_t>(written);
+		}
+		return true;
+	};
+
+	SolveStream stream(service, parallelism);
+	const SolveStream::Stats stats = stream.run(read_line, write_line);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		totals.add(stats);
+		clients++;
+	}
+	if (stats.requests > 0) stats.print("Client disconnected");
+	connection.done.store(true, std::memory_order_release);
+}
+
+void SolveServer::reapConnections(bool all) {
+	// Joined outside the lock: a finishing connection takes it to add its totals
+	std::list<Connection> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = connections.begin(); it != connections.end();) {
+			auto next = std::next(it);
+			if (all || it->done.load(std::memory_order_acquire)) {
+				finished.splice(finished.end(), connections, it);
+			}
+			it = next;
+		}
+	}
+	for (Connection& connection : finished) {
+		connection.thread.join();
+		close(connection.fd);
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "cubie.h"
+#include "solver_service.h"
+
+// Non-interactive solving of face strings on the shared solver service: a batch reads them from a
+// file or stdin, the server from TCP clients. Both use the same line protocol.
+//
+// Every input line is one 54-character face string (URFDLB order, as face::to_cubie expects);
+// blank lines and lines starting with '#' are skipped. Every face string gets one reply line, in
+// input order, as soon as it and all lines before it are answered:
+//
+//   <line> OK <move count> <queue ms> <search ms> <moves...>
+//   <line> ERROR <message>
+//
+// where <line> is the 1-based input line number.
+namespace solve_server {
+	// Converts and checks a face string; false with the reason in `error`
+	bool toCube(const std::string& face_string, cubie::cube& cube, std::string& error);
+}
+
+// One input stream of face strings. Up to `parallelism` cubes are queued on the service at once,
+// so the engine is never idle while the reader waits for the next line or a slow reply; replies
+// are written by a second thread, so a client that sends one line and waits for the answer is
+// served as promptly as one that pipelines a whole file.
+class SolveStream {
+public:
+	struct Stats {
+		uint64_t requests = 0; // face strings read
+		uint64_t solved = 0;
+		uint64_t unsolved = 0; // valid cubes the engine found no solution for in its time limit
+		uint64_t invalid = 0;  // rejected by face::to_cubie or cubie::check
+		double search_ms = 0;  // summed over the solved cubes
+		double elapsed_s = 0;  // first line read until the last reply was written
+
+		double solvesPerSecond() const { return elapsed_s > 0 ? solved / elapsed_s : 0; }
+		void add(const Stats& other);
+		void print(const char* label) const;
+	};
+
+	// Reads one line without its newline; false at the end of the input
+	using ReadLine = std::function<bool(std::string& line)>;
+	// Writes one reply line; false once the output is gone (the rest of the stream is cancelled)
+	using WriteLine = std::function<bool(const std::string& line)>;
+
+	SolveStream(SolverService& service, int parallelism);
+
+	// Runs until the input ends or the output fails, then waits for the queued replies
+	Stats run(const ReadLine& read_line, const WriteLine& write_line);
+
+private:
+	SolverService& service;
+	const size_t parallelism;
+};
+
+// Line-protocol TCP server: every connection is a SolveStream on its own thread, sharing the one
+// solver service (and its prepared engine) with all other clients.
+class SolveServer {
+public:
+	SolveServer(SolverService& service, int parallelism);
+	~SolveServer();
+
+	SolveServer(const SolveServer&) = delete;
+	SolveServer& operator=(const SolveServer&) = delete;
+
+	// Listens on address:port (an IPv4 address, port 0 = any free port)
+	bool start(const std::string& address, int port);
+	// Disconnects every client and waits for their streams to finish
+	void stop();
+
+	int port() const { return bound_port; }
+	// Totals of the connections that have closed so far
+	SolveStream::Stats stats() const;
+	void printStats() const;
+
+private:
+	struct Connection {
+		int fd;
+		std::thread thread;
+		std::atomic<bool> done{false};
+	};
+
+	void acceptLoop();
+	void serve(Connection& connection);
+	void reapConnections(bool all);
+
+	SolverService& service;
+	const int parallelism;
+	int listen_fd = -1;
+	int stop_fd = -1; // eventfd that wakes the accept thread for shutdown
+	int bound_port = 0;
+	std::thread accept_thread;
+	std::chrono::steady_clock::time_point started;
+
+	mutable std::mutex mutex;
+	std::list<Connection> connections;
+	SolveStream::Stats totals;
+	uint64_t clients = 0;
+};
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include "solver_service.h"
+#include "solution_cache.h"
+#include "trace.h"
+
+namespace {
+
+// Time limit steps in ms, roughly 1.5x apart
+constexpr int kLadder[] = {1, 2, 3, 5, 8, 12, 18, 27, 40, 60, 90, 135, 200};
+
+} // namespace
+
+SolverService::SolverService(const Settings& settings, SolutionCache* cache) :
+	settings(settings),
+	cache(cache),
+	engine(settings.threads, settings.time_limit_ms, 1, settings.max_length, settings.splits) {
+	thread = std::thread(&SolverService::serviceLoop, this);
+}
+
+SolverService::~SolverService() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+int SolverService::timeLimitFor(int time_limit_ms) const {
+	int step = kLadder[0];
+	for (int candidate : kLadder) {
+		if (candidate <= time_limit_ms) step = candidate;
+	}
+	// The configured engine is always up; use it when it lies between the step and the request
+	if (settings.time_limit_ms > step && settings.time_limit_ms <= time_limit_ms) return settings.time_limit_ms;
+	return step;
+}
+
+std::future<SolverService::Result> SolverService::submit(const cubie::cube& cube, CancelFlag cancel, int time_limit_ms) {
+	if (cache) {
+		Result cached;
+		if (cache->lookup(cube, cached.moves)) {
+			cached.solved = cached.cached = true;
+			std::promise<Result> answered;
+			answered.set_value(std::move(cached));
+			return answered.get_future();
+		}
+	}
+
+	Request request;
+	request.cube = cube;
+	request.cancel = std::move(cancel);
+	request.enqueued = std::chrono::steady_clock::now();
+	request.time_limit_ms = time_limit_ms > 0 ? timeLimitFor(time_limit_ms) : 0;
+	std::future<Result> result = request.promise.get_future();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(std::move(request));
+	}
+	wake.notify_one();
+	return result;
+}
+
+void SolverService::prepareTimeLimit(int time_limit_ms) {
+	Request request;
+	request.enqueued = std::chrono::steady_clock::now();
+	request.time_limit_ms = timeLimitFor(time_limit_ms);
+	request.prepare_only = true;
+	std::future<Result> prepared = request.promise.get_future();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(std::move(request));
+	}
+	wake.notify_one();
+	prepared.wait();
+}
+
+solve::Engine& SolverService::engineFor(int time_limit_ms) {
+	if (time_limit_ms <= 0 || time_limit_ms == settings.time_limit_ms) return engine;
+	for (auto it = limited_engines.begin(); it != limited_engines.end(); ++it) {
+		if (it->first == time_limit_ms) {
+			limited_engines.splice(limited_engines.begin(), limited_engines, it);
+			return *limited_engines.front().second;
+		}
+	}
+
+	// Joining the evicted engine's threads first keeps the thread count bounded
+	if (static_cast<int>(limited_engines.size()) >= std::max(settings.limit_engines, 1)) {
+		limited_engines.back().second->finish();
+		limited_engines.pop_back();
+	}
+	auto limited = std::make_unique<solve::Engine>(settings.threads, time_limit_ms, 1, settings.max_length, settings.splits);
+	limited->prepare();
+	limited_engines.emplace_front(time_limit_ms, std::move(limited));
+	return *limited_engines.front().second;
+}
+
+void SolverService::serviceLoop() {
+	// Search threads start here once and stay up until the service is destroyed
+	engine.prepare();
+	trace::nameThread("solver");
+
+	while (true) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stopping || !queue.empty(); });
+			// Drain what was already queued before shutting down
+			if (queue.empty()) break;
+			request = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		Result result;
+		if (request.prepare_only) {
+			engineFor(request.time_limit_ms);
+			request.promise.set_value(std::move(result));
+			continue;
+		}
+
+		const auto search_start = std::chrono::steady_clock::now();
+		result.queue_wait_ms = std::chrono::duration<double, std::milli>(search_start - request.enqueued).count();
+		if (request.cancel && request.cancel->load(std::memory_order_acquire)) {
+			result.cancelled = true;
+			request.promise.set_value(std::move(result));
+			continue;
+		}
+
+		solve::Engine& searcher = engineFor(request.time_limit_ms);
+		result.time_limit_ms = request.time_limit_ms > 0 ? request.time_limit_ms : settings.time_limit_ms;
+		std::vector<std::vector<int>> solutions;
+		{
+			trace::Scope scope(trace::Stage::Solve);
+			searcher.solve(request.cube, solutions);
+		}
+
+		result.search_ms =
+				std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - search_start).count();
+		if (!solutions.empty()) {
+			result.moves = std::move(solutions[0]);
+			result.solved = true;
+			if (cache) cache->insert(request.cube, result.moves, result.search_ms);
+		}
+		request.promise.set_value(std::move(result));
+	}
+
+	for (auto& [time_limit_ms, limited] : limited_engines) {
+		limited->finish();
+	}
+	engine.finish();
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "cubie.h"
+#include "solve.h"
+
+class SolutionCache;
+
+// Long-lived front end for the rob-twophase engine.
+//
+// One service thread owns the engine: it calls prepare() once at startup, keeps the search
+// threads alive across requests and only calls finish() on shutdown, so a solve no longer pays
+// for spawning and joining them. Requests are queued and answered through futures, and each
+// result separates the time spent waiting in the queue from the search itself.
+//
+// A request can be cancelled through the flag passed to submit(). The engine cannot be
+// interrupted mid-search, so cancelling only skips requests that have not started yet; a search
+// already running ends at the time limit as usual.
+//
+// The engine's time limit is fixed when it is constructed, so a request with its own limit (a
+// deadline's remaining budget) runs on a second engine built for that limit. Limits are rounded
+// down to a short ladder of steps, or to the configured limit when that fits better. At most
+// `limit_engines` such engines are kept prepared, least recently used first out; each holds
+// `threads` search threads. prepareTimeLimit() builds one up front so the first deadline solve
+// does not pay for starting its threads.
+//
+// With a SolutionCache, submit() answers states it has seen before (up to symmetry) at once,
+// without queueing, and every solved search is added to it.
+class SolverService {
+public:
+	struct Settings {
+		int threads = 12;
+		int time_limit_ms = 10;
+		int max_length = -1; // -1 = no limit
+		int splits = 2;
+		int limit_engines = 2; // engines kept for requests with their own time limit
+	};
+
+	struct Result {
+		std::vector<int> moves;
+		bool solved = false;
+		bool cancelled = false;   // skipped because the cancel flag was set before the search started
+		bool cached = false;      // answered from the solution cache without a search
+		double queue_wait_ms = 0; // submit() until the service thread picked the request up
+		double search_ms = 0;     // time inside Engine::solve()
+		int time_limit_ms = 0;    // limit of the engine that searched
+	};
+
+	// Pruning tables (prun::init) must be loaded before constructing the service; the cache, if
+	// any, must outlive it
+	explicit SolverService(const Settings& settings, SolutionCache* cache = nullptr);
+	~SolverService();
+
+	SolverService(const SolverService&) = delete;
+	SolverService& operator=(const SolverService&) = delete;
+
+	using CancelFlag = std::shared_ptr<const std::atomic<bool>>;
+
+	// `time_limit_ms` > 0 searches with timeLimitFor(time_limit_ms) instead of the configured limit
+	std::future<Result> submit(const cubie::cube& cube, CancelFlag cancel = nullptr, int time_limit_ms = 0);
+	Result solve(const cubie::cube& cube) { return submit(cube).get(); }
+
+	// Prepares the engine a request with this limit would use; blocks until it is up
+	void prepareTimeLimit(int time_limit_ms);
+	// Limit a request for `time_limit_ms` runs with: the largest ladder step, or the configured
+	// limit, not above it (at least the smallest step)
+	int timeLimitFor(int time_limit_ms) const;
+
+	const Settings& getSettings() const { return settings; }
+
+private:
+	struct Request {
+		cubie::cube cube;
+		CancelFlag cancel;
+		std::promise<Result> promise;
+		std::chrono::steady_clock::time_point enqueued;
+		int time_limit_ms = 0;          // 0 = the configured engine
+		bool prepare_only = false;      // no cube, just prepare the engine for time_limit_ms
+	};
+
+	void serviceLoop();
+	// Service thread only
+	solve::Engine& engineFor(int time_limit_ms);
+
+	Settings settings;
+	SolutionCache* cache;
+	solve::Engine engine;
+	// Prepared engines with their limits, most recently used first
+	std::list<std::pair<int, std::unique_ptr<solve::Engine>>> limited_engines;
+	std::thread thread;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<Request> queue;
+	bool stopping = false;
+};
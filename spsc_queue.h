@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounded lock-free queue between exactly one producer thread and one consumer thread.
+//
+// All slots are constructed up front and reused: the producer fills slot() in place and publishes
+// it with push(), the consumer reads front() in place and releases it with pop(), so items that
+// own buffers (frames, sticker vectors) keep their allocations. Head and tail live on separate
+// cache lines and are only ever written by their own side. The blocking waits spin briefly and
+// then sleep on a futex (std::atomic::wait) that every push, pop and close() bumps.
+template <class T>
+class SpscQueue {
+public:
+	explicit SpscQueue(size_t capacity) : slots(capacity + 1) {}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	size_t capacity() const { return slots.size() - 1; }
+	size_t size() const {
+		const size_t h = head.load(std::memory_order_acquire), t = tail.load(std::memory_order_acquire);
+		return (h + slots.size() - t) % slots.size();
+	}
+	// Most items that were queued at once
+	size_t highWater() const { return high_water.load(std::memory_order_relaxed); }
+
+	// Producer: the slot to fill next, nullptr while the queue is full
+	T* slot() {
+		const size_t h = head.load(std::memory_order_relaxed);
+		if (next(h) == tail.load(std::memory_order_acquire)) return nullptr;
+		return &slots[h];
+	}
+	void push() {
+		head.store(next(head.load(std::memory_order_relaxed)), std::memory_order_release);
+		const size_t queued = size();
+		if (queued > high_water.load(std::memory_order_relaxed)) high_water.store(queued, std::memory_order_relaxed);
+		signal();
+	}
+
+	// Consumer: the oldest item, nullptr while the queue is empty
+	T* front() {
+		const size_t t = tail.load(std::memory_order_relaxed);
+		if (t == head.load(std::memory_order_acquire)) return nullptr;
+		return &slots[t];
+	}
+	void pop() {
+		tail.store(next(tail.load(std::memory_order_relaxed)), std::memory_order_release);
+		signal();
+	}
+
+	// Block until slot() / front() succeeds; nullptr once the queue is closed
+	T* waitSlot() { return wait([this] { return slot(); }); }
+	T* waitFront() { return wait([this] { return front(); }); }
+
+	// Wakes both sides for good; used to shut a pipeline down
+	void close() {
+		closed.store(true, std::memory_order_release);
+		signal();
+	}
+	bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+private:
+	static constexpr int kSpinIterations = 2000;
+
+	size_t next(size_t index) const { return index + 1 == slots.size() ? 0 : index + 1; }
+
+	void signal() {
+		events.fetch_add(1, std::memory_order_acq_rel);
+		events.notify_all();
+	}
+
+	template <class Ready>
+	T* wait(Ready ready) {
+		while (true) {
+			const uint32_t seen = events.load(std::memory_order_acquire);
+			if (closed.load(std::memory_order_acquire)) return nullptr;
+			if (T* item = ready()) return item;
+			for (int spin = 0; spin < kSpinIterations && events.load(std::memory_order_acquire) == seen; spin++) {
+			}
+			events.wait(seen, std::memory_order_acquire);
+		}
+	}
+
+	std::vector<T> slots;
+	alignas(64) std::atomic<size_t> head{0}; // next slot the producer fills
+	alignas(64) std::atomic<size_t> tail{0}; // next slot the consumer reads
+	alignas(64) std::atomic<uint32_t> events{0};
+	std::atomic<size_t> high_water{0};
+	std::atomic<bool> closed{false};
+};
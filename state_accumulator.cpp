@@ -0,0 +1,78 @@
+#include "state_accumulator.h"
+#include <algorithm>
+#include <utility>
+
+StateAccumulator::StateAccumulator(std::vector<char> expected_colors, size_t stickers, int stable_frames,
+								   float min_confidence) :
+	expected_colors(std::move(expected_colors)), stickers(stickers), stable_frames(std::max(1, stable_frames)),
+	min_confidence(min_confidence) {
+	color_counts.resize(this->expected_colors.size() + 1);
+}
+
+void StateAccumulator::reset() {
+	std::fill(stickers.begin(), stickers.end(), Sticker{});
+	frame_count = 0;
+	is_ready = false;
+}
+
+void StateAccumulator::observe(size_t first, const std::vector<char>& colors, const std::vector<float>& confidence) {
+	for (size_t i = 0; i < colors.size() && i < confidence.size() && first + i < stickers.size(); i++) {
+		if (confidence[i] < min_confidence || colors[i] == 'N') continue;
+
+		Sticker& sticker = stickers[first + i];
+		if (colors[i] == sticker.pending) {
+			sticker.streak++;
+		} else {
+			sticker.pending = colors[i];
+			sticker.streak = 1;
+		}
+
+		if (sticker.streak >= stable_frames) {
+			sticker.locked = true;
+			sticker.color = sticker.pending;
+		} else if (!sticker.locked) {
+			sticker.color = sticker.pending;
+		}
+		if (sticker.color == colors[i]) sticker.confidence = confidence[i];
+	}
+}
+
+bool StateAccumulator::finishFrame() {
+	frame_count++;
+	is_ready = false;
+	if (lockedCount() < stickers.size()) return false;
+	if (countsValid()) {
+		is_ready = true;
+		return true;
+	}
+
+	// Some locked sticker is wrong, and it is one of those whose color shows up too often
+	const int expected = static_cast<int>(stickers.size() / std::max<size_t>(expected_colors.size(), 1));
+	for (Sticker& sticker : stickers) {
+		const auto it = std::find(expected_colors.begin(), expected_colors.end(), sticker.color);
+		const size_t index = it - expected_colors.begin();
+		if (it == expected_colors.end() || color_counts[index] > expected) {
+			sticker.locked = false;
+			sticker.streak = 0;
+		}
+	}
+	return false;
+}
+
+bool StateAccumulator::countsValid() {
+	std::fill(color_counts.begin(), color_counts.end(), 0);
+	for (const Sticker& sticker : stickers) {
+		const auto it = std::find(expected_colors.begin(), expected_colors.end(), sticker.color);
+		color_counts[it - expected_colors.begin()]++;
+	}
+
+	const int expected = static_cast<int>(stickers.size() / std::max<size_t>(expected_colors.size(), 1));
+	for (size_t i = 0; i < expected_colors.size(); i++) {
+		if (color_counts[i] != expected) return false;
+	}
+	return color_counts.back() == 0;
+}
+
+size_t StateAccumulator::lockedCount() const {
+	return std::count_if(stickers.begin(), stickers.end(), [](const Sticker& sticker) { return sticker.locked; });
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Merges per-sticker readings from consecutive frames into one cube state.
+//
+// Every confident reading of a sticker either extends its streak (same color as last time) or
+// starts a new one; once a color has been read stable_frames times in a row the sticker is
+// locked to it. Uncertain readings neither extend nor break a streak. A locked sticker only
+// changes color after a full streak of a different color, so one bad frame cannot undo it.
+// The state is ready as soon as every sticker is locked and each expected color appears equally
+// often; if all stickers are locked but the counts are off, the stickers of over-represented
+// colors are unlocked and read again while the others stay locked.
+class StateAccumulator {
+public:
+	StateAccumulator(std::vector<char> expected_colors, size_t stickers, int stable_frames, float min_confidence);
+
+	// Forgets every reading and lock
+	void reset();
+
+	// Merges one camera's reading into stickers [first, first + colors.size())
+	void observe(size_t first, const std::vector<char>& colors, const std::vector<float>& confidence);
+
+	// Ends the current frame: returns true once the state is ready
+	bool finishFrame();
+
+	bool ready() const { return is_ready; }
+	size_t size() const { return stickers.size(); }
+	size_t lockedCount() const;
+	bool locked(size_t sticker) const { return stickers[sticker].locked; }
+	uint32_t frames() const { return frame_count; }
+
+	// Locked color, or the newest confident reading for stickers that are not locked yet ('N' if none)
+	char color(size_t sticker) const { return stickers[sticker].color; }
+	// Confidence of the newest reading that agreed with color()
+	float confidence(size_t sticker) const { return stickers[sticker].confidence; }
+
+private:
+	struct Sticker {
+		char color = 'N';
+		char pending = 'N'; // color of the current streak
+		uint16_t streak = 0;
+		bool locked = false;
+		float confidence = 0;
+	};
+
+	bool countsValid();
+
+	std::vector<char> expected_colors;
+	std::vector<Sticker> stickers;
+	std::vector<int> color_counts; // per expected color, last element counts everything else
+	int stable_frames;
+	float min_confidence;
+	uint32_t frame_count = 0;
+	bool is_ready = false;
+};
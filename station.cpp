@@ -0,0 +1,706 @@
+#include "station.h"
+#include "arduino_detection.h"
+#include "cube_geometry.h"
+#include "cube_orientation.h"
+#include "cube_repair.h"
+#include "frame_recording.h"
+#include "sticker_state.h"
+#include "trace.h"
+#include "v4l2_capture.h"
+#include "face.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+
+// Expected detected colors, one of each face
+static const char kFaceColors[] = {'R', 'G', 'W', 'O', 'B', 'Y'};
+
+// A reading the ensemble can stop at: no uncertain sticker and 8 of every color. Runs on the
+// ensemble's workers, so it only looks at the reading itself.
+static bool readingPlausible(const FaceletReading& reading) {
+	if (reading.uncertain > 0) return false;
+	sticker_state::Packed stickers;
+	for (int cam = 0; cam < 2; cam++) {
+		for (int i = 0; i < FaceletReading::kStickersPerCamera; i++) {
+			stickers[cam * FaceletReading::kStickersPerCamera + i] =
+					sticker_state::kFaceCode[static_cast<uint8_t>(reading.color[FaceletReading::index(cam, i)])];
+		}
+	}
+	return sticker_state::countsValid(stickers);
+}
+
+// Waits until a streaming camera has a newer frame than the one last handed out
+static void waitForNewFrame(PS3EyeCamera& camera, int timeout_ms) {
+	if (!camera.isStreaming()) return;
+	const uint64_t seen = camera.frameCount();
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+	while (camera.frameCount() == seen && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+}
+
+Station::Station(const Config& config, std::shared_ptr<ColorClassifier> classifier) :
+	config(config), color_classifier(std::move(classifier)) {
+	if (!color_classifier) {
+		color_classifier = std::make_shared<ColorClassifier>();
+		color_classifier->loadDefaults();
+	}
+	for (int cam = 0; cam < 2; cam++) {
+		frames[cam] = cv::Mat::zeros(config.camera_height, config.camera_width, CV_8UC3);
+		sticker_colors[cam].assign(FaceletReading::kStickersPerCamera, 'N');
+		sticker_confidence[cam].assign(FaceletReading::kStickersPerCamera, 0.0f);
+	}
+}
+
+Station::~Station() {
+	// The watcher stages into this station; the ensemble's and the capture workers reference its buffers
+	calibration_watcher.reset();
+	roi_tracker.reset();
+	cube_detector.reset();
+	capture_workers.reset();
+	closeCameras();
+}
+
+void Station::openCameras() {
+	closeCameras();
+
+	try {
+		if (!config.replay_file.empty()) {
+			// Both cameras read from one mapped recording and share the replay start time
+			auto recording = std::make_shared<FrameRecording>();
+			if (!recording->open(config.replay_file)) {
+				throw std::runtime_error("could not open recording " + config.replay_file);
+			}
+			auto clock = std::make_shared<ReplayClock>();
+			cameras[0] = new PS3EyeCamera(
+					std::make_unique<ReplayFrameSource>(recording, 0, config.replay_realtime, clock), config.camera_1_index);
+			cameras[1] = new PS3EyeCamera(
+					std::make_unique<ReplayFrameSource>(recording, 1, config.replay_realtime, clock), config.camera_2_index);
+			std::cout << "Replaying " << recording->frames() << " frame pairs from " << config.replay_file
+					  << (config.replay_realtime ? " at recorded speed" : " as fast as possible") << std::endl;
+		} else if (config.capture_backend == "v4l2") {
+			// Raw YUYV frames from mapped driver buffers; detection samples them without converting
+			for (int cam = 0; cam < 2; cam++) {
+				const int index = cam == 0 ? config.camera_1_index : config.camera_2_index;
+				cameras[cam] = new PS3EyeCamera(
+						std::make_unique<MmapV4L2FrameSource>(index, config.camera_width, config.camera_height,
+															  config.camera_fps, config.capture_buffers),
+						index);
+			}
+		} else {
+			cameras[0] = new PS3EyeCamera(config.camera_height, config.camera_width, config.camera_1_index, 187);
+			cameras[1] = new PS3EyeCamera(config.camera_height, config.camera_width, config.camera_2_index, 187);
+		}
+
+		if (config.streaming_capture) {
+			cameras[0]->startStreaming(config.capture_ring_size);
+			cameras[1]->startStreaming(config.capture_ring_size);
+		}
+	} catch (const std::exception& e) {
+		std::cerr << "Error initializing cameras: " << e.what() << std::endl;
+		closeCameras();
+		throw;
+	}
+}
+
+void Station::closeCameras() {
+	capture_workers.reset();
+	frame_sync.reset();
+	for (PS3EyeCamera*& camera : cameras) {
+		delete camera;
+		camera = nullptr;
+	}
+}
+
+FrameSync& Station::frameSync() {
+	if (!frame_sync) {
+		frame_sync = std::make_unique<FrameSync>(*cameras[0], *cameras[1], config.sync_max_skew_us, config.sync_timeout_ms);
+	}
+	return *frame_sync;
+}
+
+bool Station::loadPositions(const std::string& filename_1, const std::string& filename_2) {
+	const std::string* filenames[2] = {&filename_1, &filename_2};
+	std::vector<cv::Point> points[2];
+	for (int cam = 0; cam < 2; cam++) {
+		std::ifstream in(*filenames[cam]);
+		if (!in.is_open()) {
+			std::cerr << "Could not open position file: " << *filenames[cam] << std::endl;
+			return false;
+		}
+		int x, y;
+		for (int i = 0; i < FaceletReading::kStickersPerCamera && in >> x >> y; i++) { // 8 pieces × 3 faces
+			points[cam].emplace_back(x, y);
+		}
+	}
+	sticker_points[0] = std::move(points[0]);
+	sticker_points[1] = std::move(points[1]);
+	trackCalibratedPoints();
+	return true;
+}
+
+bool Station::compileCalibration() {
+	Calibration calibration;
+	const Calibration::Camera camera{config.camera_width, config.camera_height, config.camera_fps, config.exposure,
+									 config.gain, config.brightness, config.contrast, config.saturation};
+	if (!calibration_bundle::compile(config.position_file_1, config.position_file_2, config.color_range_file, camera,
+									 calibration)) {
+		return false;
+	}
+	applyCalibration(calibration);
+	if (config.calibration_bundle.empty()) return true;
+	if (!calibration_bundle::write(config.calibration_bundle, calibration)) return false;
+	std::cout << "✓ Calibration compiled into " << config.calibration_bundle << std::endl;
+	return true;
+}
+
+bool Station::loadCalibration() {
+	const std::vector<std::string> sources = {config.position_file_1, config.position_file_2, config.color_range_file};
+	Calibration calibration;
+	if (config.calibration_bundle.empty() || calibration_bundle::stale(config.calibration_bundle, sources) ||
+		!calibration_bundle::load(config.calibration_bundle, calibration)) {
+		if (!compileCalibration()) return false;
+	} else {
+		applyCalibration(calibration);
+		std::cout << "✓ Calibration loaded from " << config.calibration_bundle << std::endl;
+	}
+
+	if (config.calibration_hot_reload && !config.calibration_bundle.empty() && !calibration_watcher) {
+		try {
+			calibration_watcher = std::make_unique<CalibrationWatcher>(
+					config.calibration_bundle,
+					[this](std::shared_ptr<const Calibration> next) { stageCalibration(std::move(next)); });
+		} catch (const std::exception& e) {
+			std::cerr << "Warning: No calibration hot reload, " << e.what() << std::endl;
+		}
+	}
+	return true;
+}
+
+void Station::applyCalibration(const Calibration& calibration) {
+	if (calibration.camera.width && (calibration.camera.width != config.camera_width ||
+									 calibration.camera.height != config.camera_height)) {
+		std::cerr << "Warning: Calibration was made at " << calibration.camera.width << "x" << calibration.camera.height
+				  << ", cameras run at " << config.camera_width << "x" << config.camera_height << std::endl;
+	}
+	// Assigned in place: the detectors keep referring to these objects
+	sticker_points[0] = calibration.points[0];
+	sticker_points[1] = calibration.points[1];
+	*color_classifier = calibration.classifier;
+	trackCalibratedPoints();
+}
+
+void Station::stageCalibration(std::shared_ptr<const Calibration> calibration) {
+	staged_calibration.store(std::move(calibration), std::memory_order_release);
+	calibration_staged.store(true, std::memory_order_release);
+}
+
+void Station::swapStagedCalibration() {
+	if (!calibration_staged.load(std::memory_order_relaxed)) return;
+	calibration_staged.store(false, std::memory_order_relaxed);
+	if (std::shared_ptr<const Calibration> calibration = staged_calibration.exchange(nullptr, std::memory_order_acquire)) {
+		applyCalibration(*calibration);
+		station_stats.calibration_reloads++;
+	}
+}
+
+void Station::trackCalibratedPoints() {
+	if (!config.roi_tracking) return;
+	if (!roi_tracker) {
+		RoiTracker::Settings settings;
+		settings.interval_frames = config.roi_track_interval;
+		settings.search_px = config.roi_track_search_px;
+		settings.budget_us = config.roi_track_budget_us;
+		settings.min_score = config.roi_track_min_score;
+		roi_tracker = std::make_unique<RoiTracker>(settings);
+	}
+	roi_tracker->reset(sticker_points[0], sticker_points[1]);
+}
+
+void Station::followTrackedPoints() {
+	if (roi_tracker && roi_tracker->take(sticker_points[0], sticker_points[1])) {
+		station_stats.roi_updates++;
+	}
+}
+
+void Station::printTrackerStats(const char* prefix) const {
+	if (roi_tracker) roi_tracker->printStats(prefix);
+}
+
+void Station::captureCamera(int camera, bool next) {
+	PS3EyeCamera* device = cameras[camera];
+	if (!device) return;
+
+	if (next) waitForNewFrame(*device, config.sync_timeout_ms);
+
+	const auto capture_start = std::chrono::steady_clock::now();
+	device->captureRaw(frames[camera]);
+	last_capture_ms[camera] =
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - capture_start).count();
+}
+
+std::unique_ptr<CubeDetector> Station::makeDetector(const std::string& name) {
+	if (name != "hsv" && !rgb_detection) {
+		rgb_detection = std::make_unique<ArduinoStyleDetection>();
+		rgb_detection->loadColorCalibration("arduino_colors.txt");
+	}
+
+	auto hsv = [this] {
+		auto detector = std::make_unique<HsvPatchDetector>(*color_classifier, sticker_points[0], sticker_points[1],
+														   config.sample_patch_size, config.sample_patch_step,
+														   config.vote_min_confidence);
+		if (config.white_balance) detector->enableWhiteBalance(*color_classifier, config.white_balance_stats);
+		return detector;
+	};
+	auto rgb = [this] {
+		auto detector = std::make_unique<RgbTableDetector>(*rgb_detection, sticker_points[0], sticker_points[1],
+														   config.sample_patch_size, config.sample_patch_step,
+														   config.vote_min_confidence);
+		// The gains come from the HSV ranges; they describe the light, not the classifier
+		if (config.white_balance) detector->enableWhiteBalance(*color_classifier, config.white_balance_stats);
+		return detector;
+	};
+
+	if (name == "rgb") return rgb();
+	if (name == "ensemble") {
+		std::vector<std::unique_ptr<CubeDetector>> members;
+		members.push_back(hsv());
+		members.push_back(rgb());
+		// Not the capture workers' cores: both pools spin before they sleep
+		return std::make_unique<EnsembleDetector>(std::move(members),
+												  std::vector<int>{config.ensemble_cpu_1, config.ensemble_cpu_2},
+												  readingPlausible);
+	}
+	if (name != "hsv") {
+		std::cerr << "Warning: unknown DETECTOR=" << name << ", using hsv" << std::endl;
+	}
+	return hsv();
+}
+
+CubeDetector& Station::detector() {
+	if (!cube_detector) {
+		cube_detector = makeDetector(config.detector);
+		std::cout << "✓ Sticker detector: " << cube_detector->name() << std::endl;
+	}
+	return *cube_detector;
+}
+
+void Station::storeReading(const FaceletReading& reading) {
+	for (int cam = 0; cam < 2; cam++) {
+		sticker_colors[cam].assign(FaceletReading::kStickersPerCamera, 'N');
+		sticker_confidence[cam].assign(FaceletReading::kStickersPerCamera, 0.0f);
+		for (int i = 0; i < FaceletReading::kStickersPerCamera; i++) {
+			sticker_colors[cam][i] = reading.color[FaceletReading::index(cam, i)];
+			sticker_confidence[cam][i] = reading.confidence[FaceletReading::index(cam, i)];
+		}
+	}
+}
+
+void Station::compareWhiteBalance(const FaceletReading& reading) {
+	if (!reading.has_uncorrected) return;
+	std::vector<char> corrected[2], plain[2];
+	for (int cam = 0; cam < 2; cam++) {
+		for (int i = 0; i < FaceletReading::kStickersPerCamera; i++) {
+			corrected[cam].push_back(reading.color[FaceletReading::index(cam, i)]);
+			plain[cam].push_back(reading.uncorrected[FaceletReading::index(cam, i)]);
+		}
+	}
+	const bool valid = colorsFormCube(corrected[0], corrected[1]);
+	const bool valid_without = colorsFormCube(plain[0], plain[1]);
+	station_stats.white_balance_readings++;
+	station_stats.white_balance_rescued += valid && !valid_without;
+	station_stats.white_balance_broken += valid_without && !valid;
+}
+
+void Station::printWhiteBalanceStats() const {
+	if (!config.white_balance || !config.white_balance_stats) return;
+	const Stats& stats = station_stats;
+	std::cout << "White balance: " << stats.white_balance_rescued << " of " << stats.white_balance_readings
+			  << " readings formed a valid cube only with the correction, " << stats.white_balance_broken
+			  << " only without it" << std::endl;
+}
+
+bool Station::capturePair(bool next, double& capture_ms) {
+	trace::Scope scope(trace::Stage::Capture);
+	const auto start = std::chrono::steady_clock::now();
+	bool synced = false;
+	if (config.sync_frames && hasCameras()) {
+		if (next) {
+			waitForNewFrame(*cameras[0], config.sync_timeout_ms);
+			waitForNewFrame(*cameras[1], config.sync_timeout_ms);
+		}
+		synced = frameSync().capturePair(frames[0], frames[1]);
+		if (!synced) {
+			std::cerr << "Warning: no synchronized frame pair, capturing cameras independently" << std::endl;
+		}
+	}
+	if (!synced) {
+		if (!capture_workers) {
+			capture_workers = std::make_unique<DetectionWorkers>(
+					std::vector<DetectionWorkers::Job>{[this] { captureCamera(0, capture_new_frames); },
+													   [this] { captureCamera(1, capture_new_frames); }},
+					std::vector<int>{config.detect_cpu_1, config.detect_cpu_2});
+		}
+		capture_new_frames = next;
+		capture_workers->run();
+	}
+	capture_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return synced;
+}
+
+DetectionWorkers::Timing Station::detect(bool verbose, bool next) {
+	swapStagedCalibration();
+	followTrackedPoints();
+	CubeDetector& cube_detector = detector();
+	const auto start = std::chrono::steady_clock::now();
+
+	double capture_ms = 0;
+	const bool synced = capturePair(next, capture_ms);
+	cube_detector.reset();
+	detectFrames(cube_detector);
+	if (roi_tracker) roi_tracker->offer(frames[0], frames[1]);
+	double detect_ms = reading.detect_us / 1000.0;
+	int frame_count = 1;
+	for (; frame_count < config.vote_max_frames && reading.uncertain > 0; frame_count++) {
+		capturePair(true, capture_ms);
+		detectFrames(cube_detector);
+		detect_ms += reading.detect_us / 1000.0;
+	}
+	storeReading(reading);
+	compareWhiteBalance(reading);
+
+	DetectionWorkers::Timing timing;
+	timing.dispatch_to_result_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	timing.slowest_job_ms = detect_ms;
+	station_stats.detections++;
+	station_stats.frames += frame_count;
+	station_stats.detect_ms += timing.dispatch_to_result_ms;
+	if (!verbose) {
+		return timing;
+	}
+
+	std::cout << "Dual camera time: " << timing.dispatch_to_result_ms << " ms (" << (synced ? "pairing " : "capture ")
+			  << capture_ms << " ms + detection " << detect_ms << " ms, " << cube_detector.name();
+	if (auto* ensemble = dynamic_cast<EnsembleDetector*>(&cube_detector)) {
+		std::cout << " → " << ensemble->lastWinner();
+	}
+	std::cout << ", " << frame_count << (frame_count == 1 ? " frame)" : " frames)") << std::endl;
+	if (synced) {
+		const FrameSync::Stats& stats = frame_sync->getStats();
+		std::cout << "  Frame skew: " << stats.last_skew_us / 1000.0 << " ms (max "
+				  << stats.max_skew_us / 1000.0 << " ms, mean " << stats.mean_skew_us / 1000.0 << " ms over "
+				  << stats.pairs << " pairs, " << stats.out_of_window << " outside window, "
+				  << (stats.device_timestamps ? "V4L2 timestamps" : "host timestamps") << ")" << std::endl;
+		if (stats.last_skew_us > frame_sync->maxSkewUs()) {
+			std::cout << "⚠️  Frame pair outside the " << frame_sync->maxSkewUs() / 1000.0
+					  << " ms sync window" << std::endl;
+		}
+	} else {
+		std::cout << "  Capture: cam1 " << last_capture_ms[0] << " ms, cam2 " << last_capture_ms[1] << " ms" << std::endl;
+	}
+	return timing;
+}
+
+void Station::detectFrames(CubeDetector& cube_detector) {
+	trace::Scope scope(trace::Stage::Detect);
+	cube_detector.detect(frames[0], frames[1], reading);
+}
+
+void Station::detectPair(const cv::Mat& frame_1, const cv::Mat& frame_2) {
+	swapStagedCalibration();
+	followTrackedPoints();
+	CubeDetector& cube_detector = detector();
+	cube_detector.reset();
+	{
+		trace::Scope scope(trace::Stage::Detect);
+		cube_detector.detect(frame_1, frame_2, reading);
+	}
+	if (roi_tracker) roi_tracker->offer(frame_1, frame_2);
+	storeReading(reading);
+	compareWhiteBalance(reading);
+}
+
+// Both cameras' colors as face codes, camera 1 first
+static sticker_state::Packed packStickers(const std::vector<char>& colors_1, const std::vector<char>& colors_2) {
+	sticker_state::Packed stickers;
+	stickers.fill(sticker_state::kUnknown);
+	sticker_state::pack(colors_1.data(), colors_1.size(), 0, stickers);
+	sticker_state::pack(colors_2.data(), colors_2.size(), colors_1.size(), stickers);
+	return stickers;
+}
+
+bool Station::colorsFormCube(const std::vector<char>& colors_1, const std::vector<char>& colors_2) {
+	if (colors_1.size() + colors_2.size() != sticker_state::kStickers) return false;
+	if (!sticker_state::countsValid(packStickers(colors_1, colors_2))) return false;
+
+	std::array<char, 54> facelets;
+	for (size_t o = 0; o < kCubeOrientations.size(); o++) {
+		faceString(colors_1, colors_2, o, facelets);
+		if (cube_geometry::cubeValid(facelets.data())) return true;
+	}
+	return false;
+}
+
+bool Station::validate() const {
+	trace::Scope scope(trace::Stage::Validate);
+	return colorsFormCube(sticker_colors[0], sticker_colors[1]);
+}
+
+// Diagnostics for the current detection: per-face counts, unknown and uncertain stickers, and why
+// no orientation forms a valid cube
+void Station::printValidationReport() const {
+	const uint64_t histogram = sticker_state::histogram(packStickers(sticker_colors[0], sticker_colors[1]));
+	bool is_valid = histogram == sticker_state::kValidHistogram;
+
+	std::cout << "\n=== Cube Validation ===" << std::endl;
+	std::cout << "Detected pieces: 54 total (48 detected + 6 hardcoded centers)" << std::endl;
+	for (int code = 0; code < 6; code++) {
+		const int detected_count = sticker_state::faceCount(histogram, code);
+		std::cout << "Face " << cube_geometry::kFaces[code] << ": " << detected_count << " detected + 1 center = "
+				  << detected_count + 1 << " total" << (detected_count == 8 ? " ✓" : " ✗ (expected 9)") << std::endl;
+	}
+	const int unknown_count = sticker_state::faceCount(histogram, sticker_state::kUnknown);
+	if (unknown_count > 0) {
+		std::cout << "Unknown/Undetected: " << unknown_count << " stickers ✗" << std::endl;
+	}
+	printUncertainStickers();
+
+	if (is_valid) {
+		// Counts are right; the pieces decide. Tally why each orientation fails.
+		std::map<cube_geometry::CubeError, int> errors;
+		std::array<char, 54> facelets;
+		for (size_t o = 0; o < kCubeOrientations.size(); o++) {
+			faceString(o, facelets);
+			errors[cube_geometry::checkFacelets(facelets.data())]++;
+		}
+		is_valid = errors.count(cube_geometry::CubeError::None) > 0;
+		if (is_valid) {
+			std::cout << "Pieces: valid in " << errors[cube_geometry::CubeError::None] << " of 24 orientations ✓"
+					  << std::endl;
+		} else {
+			std::cout << "Pieces: no orientation forms a valid cube ✗ (";
+			const char* separator = "";
+			for (const auto& [error, count] : errors) {
+				std::cout << separator << count << "× " << cube_geometry::cubeErrorName(error);
+				separator = ", ";
+			}
+			std::cout << ")" << std::endl;
+		}
+	}
+
+	if (is_valid) {
+		std::cout << "✓ Cube validation PASSED - All faces detected correctly!" << std::endl;
+	} else {
+		std::cout << "✗ Cube validation FAILED - Face count or piece mismatch!" << std::endl;
+	}
+}
+
+// Lists the stickers whose color is below the confidence threshold
+void Station::printUncertainStickers() const {
+	for (int cam = 0; cam < 2; cam++) {
+		const std::vector<float>& confidence = sticker_confidence[cam];
+		const std::vector<char>& colors = sticker_colors[cam];
+		for (size_t i = 0; i < confidence.size() && i < colors.size(); i++) {
+			if (confidence[i] >= config.vote_min_confidence) continue;
+			std::cout << "  Uncertain: camera " << cam + 1 << " point " << i << " reads " << colors[i] << " with "
+					  << static_cast<int>(confidence[i] * 100 + 0.5f) << "% of the votes" << std::endl;
+		}
+	}
+}
+
+void Station::faceString(const std::vector<char>& colors_1, const std::vector<char>& colors_2, size_t orientation,
+						 std::array<char, 54>& cube_state) {
+	const std::array<uint8_t, 48>& map = kFaceletMaps[orientation];
+	for (int i = 0; i < 24; i++) {
+		// Convert detected color using the standard colorToFace mapping
+		cube_state[map[i]] = sticker_state::faceOf(colors_1[i]);
+		cube_state[map[24 + i]] = sticker_state::faceOf(colors_2[i]);
+	}
+
+	// Fill in center pieces based on orientation (use face letters not colors)
+	const CubeOrientation& o = kCubeOrientations[orientation];
+	cube_state[4] = o.cam1_faces[0];   // Up center
+	cube_state[13] = o.cam1_faces[1];  // Right center
+	cube_state[22] = o.cam1_faces[2];  // Front center
+	cube_state[31] = o.cam2_faces[0];  // Down center
+	cube_state[40] = o.cam2_faces[1];  // Left center
+	cube_state[49] = o.cam2_faces[2];  // Back center
+}
+
+bool Station::repair(const std::vector<bool>& changeable, bool verbose) {
+	trace::Scope scope(trace::Stage::Repair);
+	const size_t count_1 = sticker_colors[0].size();
+	if (config.repair_max_stickers <= 0 || count_1 != 24 || sticker_colors[1].size() != 24 || changeable.size() != 48) {
+		return false;
+	}
+
+	std::array<char, 54> facelets;
+	std::array<float, 54> confidence;
+	std::array<char, 48> repaired{}, candidate{};
+	bool found = false, ambiguous = false;
+	int best_changes = 0;
+	float best_cost = 0;
+	for (size_t o = 0; o < kFaceletMaps.size(); o++) {
+		const std::array<uint8_t, 48>& map = kFaceletMaps[o];
+		faceString(o, facelets);
+		confidence.fill(1.0f);
+		uint64_t mask = 0;
+		for (size_t i = 0; i < 48; i++) {
+			confidence[map[i]] = i < count_1 ? sticker_confidence[0][i] : sticker_confidence[1][i - count_1];
+			if (changeable[i]) mask |= 1ull << map[i];
+		}
+
+		const cube_repair::Result result = cube_repair::repair(facelets, mask, confidence, config.repair_max_stickers);
+		if (!result.repaired && !result.ambiguous) continue;
+		for (size_t i = 0; i < 48; i++) candidate[i] = sticker_state::colorOf(facelets[map[i]]);
+
+		// Orientations that agree on the sticker colors are the same repair
+		const bool better = !found || result.changes < best_changes ||
+							(result.changes == best_changes && result.cost < best_cost - 1e-4f);
+		if (better) {
+			found = true;
+			ambiguous = result.ambiguous;
+			best_changes = result.changes;
+			best_cost = result.cost;
+			repaired = candidate;
+		} else if (result.changes == best_changes && result.cost <= best_cost + 1e-4f) {
+			ambiguous |= result.ambiguous || candidate != repaired;
+		}
+	}
+
+	if (!found || ambiguous) {
+		if (verbose && ambiguous) std::cout << "⚠️  Sticker repair is ambiguous, not applied" << std::endl;
+		return false;
+	}
+	for (size_t i = 0; i < 48; i++) {
+		char& color = i < count_1 ? sticker_colors[0][i] : sticker_colors[1][i - count_1];
+		if (color == repaired[i]) continue;
+		if (verbose) {
+			std::cout << "🔧 Repaired camera " << (i < count_1 ? 1 : 2) << " point " << (i < count_1 ? i : i - count_1)
+					  << ": " << color << " → " << repaired[i] << std::endl;
+		}
+		color = repaired[i];
+	}
+	return true;
+}
+
+void Station::copyAccumulatedState(const StateAccumulator& accumulator) {
+	const size_t count_1 = sticker_colors[0].size();
+	for (size_t i = 0; i < accumulator.size(); i++) {
+		const int cam = i < count_1 ? 0 : 1;
+		const size_t index = cam == 0 ? i : i - count_1;
+		sticker_colors[cam][index] = accumulator.color(i);
+		sticker_confidence[cam][index] = accumulator.confidence(i);
+	}
+}
+
+StateAccumulator Station::makeAccumulator() const {
+	return StateAccumulator(std::vector<char>(std::begin(kFaceColors), std::end(kFaceColors)),
+							sticker_colors[0].size() + sticker_colors[1].size(), config.accumulate_stable_frames,
+							config.vote_min_confidence);
+}
+
+bool Station::absorb(StateAccumulator& accumulator, bool verbose, bool& repaired) {
+	repaired = false;
+	accumulator.observe(0, sticker_colors[0], sticker_confidence[0]);
+	accumulator.observe(sticker_colors[0].size(), sticker_colors[1], sticker_confidence[1]);
+	const bool ready = accumulator.finishFrame();
+	copyAccumulatedState(accumulator);
+
+	if (ready) {
+		if (validate()) {
+			station_stats.states++;
+			return true;
+		}
+		// Right counts but no real cube: some locked sticker is wrong and there is no telling which
+		if (verbose) std::cout << "⚠️  Locked stickers do not form a valid cube, reading all stickers again" << std::endl;
+		accumulator.reset();
+		return false;
+	}
+
+	const size_t unlocked = accumulator.size() - accumulator.lockedCount();
+	if (unlocked > 0 && unlocked <= static_cast<size_t>(config.repair_max_stickers)) {
+		std::vector<bool> changeable(accumulator.size());
+		for (size_t i = 0; i < accumulator.size(); i++) changeable[i] = !accumulator.locked(i);
+		if (repair(changeable, verbose)) {
+			repaired = true;
+			station_stats.states++;
+			station_stats.repaired++;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Station::accumulate(StateAccumulator& accumulator, std::chrono::steady_clock::time_point deadline, bool verbose) {
+	bool complete = false, repaired = false;
+	// Every reading after the first waits for a new pair, so the stability streak counts frames
+	for (bool next = false;; next = true) {
+		detect(false, next);
+		if ((complete = absorb(accumulator, verbose, repaired))) break;
+		if (std::chrono::steady_clock::now() >= deadline) break;
+	}
+
+	station_stats.timeouts += !complete;
+	if (!verbose) return complete;
+
+	if (complete && !repaired) {
+		std::cout << "✓ Cube state converged after " << accumulator.frames() << " frames" << std::endl;
+	} else if (repaired) {
+		std::cout << "✓ Cube state completed by piece repair after " << accumulator.frames() << " frames" << std::endl;
+	} else {
+		std::cout << "⚠️  Cube state did not converge: " << accumulator.lockedCount() << "/" << accumulator.size()
+				  << " stickers locked after " << accumulator.frames() << " frames" << std::endl;
+	}
+	return complete;
+}
+
+// Orientations are first screened with cube_geometry::cubeValid(), which looks every corner
+// triplet and edge pair up in a precomputed table and checks twist, flip and parity, so
+// face::to_cubie/cubie::check only run for orientations they will accept. The screen checks
+// everything cubie::check does, so an orientation it rejects is never worth converting.
+void Station::findCandidates(const std::vector<char>& colors_1, const std::vector<char>& colors_2, int max_candidates,
+							 std::vector<OrientationCandidate>& candidates, bool verbose) {
+	trace::Scope scope(trace::Stage::Orient);
+	candidates.clear();
+
+	std::array<char, 54> facelets;
+	for (size_t i = 0; i < kCubeOrientations.size(); i++) {
+		if (candidates.size() >= static_cast<size_t>(max_candidates)) return;
+		try {
+			// Generate face string for this orientation
+			faceString(colors_1, colors_2, i, facelets);
+			if (!cube_geometry::cubeValid(facelets.data())) {
+				continue; // cubie::check would reject this orientation
+			}
+
+			// Several orientations can produce the same cube; solve it once
+			bool duplicate = false;
+			for (const auto& candidate : candidates) {
+				duplicate |= candidate.facelets == facelets;
+			}
+			if (duplicate) continue;
+
+			// Convert face string to cubie representation
+			cubie::cube c;
+			int face_error = face::to_cubie(std::string(facelets.begin(), facelets.end()), c);
+			if (face_error != 0) {
+				continue; // Try next orientation
+			}
+
+			// Validate cube state
+			int cubie_error = cubie::check(c);
+			if (cubie_error != 0) {
+				continue; // Try next orientation
+			}
+
+			candidates.push_back({i, facelets, c});
+		} catch (const std::exception& e) {
+			// Continue to next orientation on any error
+			continue;
+		}
+	}
+	if (verbose && candidates.empty()) std::cout << "  No orientation passed the piece screen" << std::endl;
+}
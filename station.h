@@ -0,0 +1,284 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include "PS3EyeCamera.h"
+#include "calibration_bundle.h"
+#include "color_lut.h"
+#include "cube_detector.h"
+#include "detection_workers.h"
+#include "frame_sync.h"
+#include "roi_tracker.h"
+#include "state_accumulator.h"
+#include "cubie.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Configuration structure
+struct Config {
+    std::string station_name = "rig"; // Shown in the output of multi-station runs
+    int camera_1_index = 4;
+    int camera_2_index = 5;
+    int camera_width = 320;
+    int camera_height = 240;
+    int camera_fps = 187;
+    int exposure = 15;
+    int gain = 10;
+    int brightness = 15;
+    int contrast = 9;
+    int saturation = 60;
+    std::string position_file_1 = "pos_1.txt"; // Sticker points of camera 1 (written by position calibration)
+    std::string position_file_2 = "pos_2.txt";
+    std::string color_range_file = "range.txt"; // HSV ranges (written by color calibration)
+    std::string calibration_bundle = "calibration.bin"; // Compiled positions + ranges (empty = text files only)
+    bool calibration_hot_reload = true; // Swap in a rewritten bundle while running
+    int detect_cpu_1 = -1; // CPU for the camera 1 detection worker (-1 = not pinned)
+    int detect_cpu_2 = -1; // CPU for the camera 2 detection worker (-1 = not pinned)
+    int ensemble_cpu_1 = -1; // CPUs of the ensemble detector's two members (keep them off DETECT_CPU_*)
+    int ensemble_cpu_2 = -1;
+    std::string capture_backend = "opencv"; // opencv (cv::VideoCapture, BGR) or v4l2 (mapped YUYV buffers)
+    int capture_buffers = 8; // Driver buffers of the v4l2 backend, lent to the ring when > CAPTURE_RING_SIZE + 1
+    bool streaming_capture = true; // Background grab threads keep the newest frame ready
+    int capture_ring_size = 4;
+    bool sync_frames = true; // Pair both cameras' frames by capture timestamp before detection
+    int sync_max_skew_us = 3000; // Largest accepted capture time difference between the two frames
+    int sync_timeout_ms = 100; // Give up waiting for an in-window pair and use the closest one
+    int solver_threads = 12;
+    int solver_time_limit_ms = 10;
+    int solver_max_length = -1; // -1 = no limit
+    int solver_splits = 2;
+    int solver_limit_engines = 2; // Extra engines kept for deadline time limits, SOLVER_THREADS threads each
+    bool solver_table_full_check = false; // Hash the whole table file at startup, not just samples
+    int solver_max_candidates = 1; // Valid orientations solved per cube, back to back; the shortest solution wins
+    int solution_cache_size = 4096; // Solved states remembered up to symmetry (0 = no cache)
+    std::string solution_cache_file; // Keeps the solution cache across runs (empty = memory only)
+    std::string replay_file; // Recorded session to replay instead of the live cameras (empty = live)
+    bool replay_realtime = true; // Replay at the recorded frame rate instead of as fast as possible
+    int sample_patch_size = 3; // Pixels per side of the voting patch around each sticker point (1 = single pixel)
+    int sample_patch_step = 2; // Pixel spacing inside the patch
+    float vote_min_confidence = 0.6f; // Share of the patch votes a sticker's color needs to be kept
+    int vote_max_frames = 3; // Frames one detection may use to resolve uncertain stickers
+    int accumulate_stable_frames = 2; // Consecutive equal readings that lock a sticker's color
+    int accumulate_timeout_ms = 2000; // Give up on a cube state that has not converged by then
+    int repair_max_stickers = 3; // Uncertain stickers the piece-geometry repair may rewrite (0 = off)
+    std::string detector = "hsv"; // Sticker detector: hsv, rgb (Arduino-style RGB table) or ensemble (both)
+    int pipeline_queue_depth = 2; // Items each pipeline stage may run ahead of the next one
+    bool trace = true; // Per-stage spans and latency histograms (see trace.h)
+    std::string trace_metrics_file; // Prometheus text file, rewritten while pipelines run and on exit (empty = off)
+    std::string trace_chrome_file; // Chrome trace JSON of the most recent spans, written on exit (empty = off)
+    int trace_export_interval_ms = 1000;
+    int debug_render_fps = 15; // Rate the display modes (d, v, t) redraw at, on their own render thread
+    bool debug_render_opencl = false; // Convert display frames with OpenCL (cv::UMat) when a device is present
+    bool white_balance = false; // Per-frame channel gains from the face centers, applied to the sampled pixels
+    bool white_balance_stats = false; // Also read every frame uncorrected and count readings the gains rescued
+    bool roi_tracking = false; // Follow cube/camera drift by re-fitting the sticker points to the face grid
+    int roi_track_interval = 10; // Frame pairs between two tracker passes
+    int roi_track_search_px = 12; // How far a face is searched for around its last position
+    int roi_track_budget_us = 2000; // Tracker time per pass before its interval is stretched
+    float roi_track_min_score = 0.6f; // Template correlation a face needs to count as found
+    int solve_parallelism = 8; // Cubes one solve/serve stream keeps queued on the solver service
+    std::string solve_server_address = "127.0.0.1"; // Address the serve subcommand listens on
+    int solve_server_port = 7654;
+    int deadline_ms = 40; // Deadline solve mode (e): trigger until the solution, capture and detection included
+    int deadline_solve_reserve_ms = 3; // Solver time detection may not eat into
+};
+
+// A detected cube state that forms a valid cube in one of the 24 orientations
+struct OrientationCandidate {
+	size_t orientation;
+	std::array<char, 54> facelets;
+	cubie::cube cube;
+};
+
+// One camera rig: its two cameras, calibration, color classifier, frame buffers, detector,
+// detected sticker state and statistics.
+//
+// Everything a rig mutates while detecting lives here, so several stations can run in one
+// process, each driven by its own thread. What is expensive and read-only is shared instead: the
+// color classifier is handed in and may be used by several stations with the same ranges, and
+// solving goes through the process-wide solver service (see StationScheduler).
+//
+// A station is not thread-safe: one thread drives it at a time. The single exception is a running
+// StationPipeline, which splits the station into the member groups marked below and gives each
+// group to one stage thread:
+//   capture: capturePair(), frame(), lastCaptureMs()
+//   detect:  detectPair(), makeAccumulator(), absorb(), colors(), confidence(), and the detection
+//            counters of stats()
+//   solve:   the solve counters of stats() (solved, solve_failures, solve_ms)
+// The orientation stage only calls the static findCandidates() on its own copies. No two groups
+// share a member, and Stats counters are separate memory locations. Everything else (detect(),
+// accumulate(), calibration, validation and repair on the station's own state) needs the pipeline
+// stopped.
+class Station {
+public:
+	// Counters since construction; detect_ms / solve_ms are sums
+	struct Stats {
+		uint64_t detections = 0; // detect() calls
+		uint64_t frames = 0;     // frame pairs run through the detector
+		double detect_ms = 0;
+		uint64_t states = 0;   // cube states that converged or were repaired
+		uint64_t repaired = 0; // ... of which the piece repair completed
+		uint64_t timeouts = 0; // readings that did not converge in time
+		uint64_t solved = 0;
+		uint64_t solve_failures = 0;
+		double solve_ms = 0;
+		uint64_t calibration_reloads = 0;
+		// WHITE_BALANCE_STATS: readings compared, and those that formed a cube only with / only without it
+		uint64_t white_balance_readings = 0;
+		uint64_t white_balance_rescued = 0;
+		uint64_t white_balance_broken = 0;
+		uint64_t roi_updates = 0; // ROI_TRACKING: tracked sticker points taken over
+	};
+
+	Station(const Config& config, std::shared_ptr<ColorClassifier> classifier);
+	~Station();
+
+	Station(const Station&) = delete;
+	Station& operator=(const Station&) = delete;
+
+	const Config& getConfig() const { return config; }
+	const std::string& name() const { return config.station_name; }
+
+	// Cameras (live or replayed, see REPLAY_FILE). openCameras() throws if a camera cannot be opened.
+	void openCameras();
+	void closeCameras();
+	PS3EyeCamera* camera(int index) const { return cameras[index]; }
+	bool hasCameras() const { return cameras[0] && cameras[1]; }
+	FrameSync& frameSync();
+
+	// Calibration: the sticker points replace the current ones
+	bool loadPositions(const std::string& filename_1, const std::string& filename_2);
+	bool loadPositions() { return loadPositions(config.position_file_1, config.position_file_2); }
+	// Points and color ranges together: from CALIBRATION_BUNDLE unless the text files are newer, in
+	// which case they are compiled into a fresh bundle. Starts the hot-reload watcher when enabled.
+	bool loadCalibration();
+	// Compiles the text files into CALIBRATION_BUNDLE, e.g. right after a calibration mode
+	bool compileCalibration();
+	void applyCalibration(const Calibration& calibration);
+	// Thread-safe: the detecting thread swaps the calibration in before its next frame
+	void stageCalibration(std::shared_ptr<const Calibration> calibration);
+	const std::vector<cv::Point>& points(int camera) const { return sticker_points[camera]; }
+	ColorClassifier& classifier() { return *color_classifier; }
+
+	// Frame buffers the pipeline captures into, one per camera
+	cv::Mat& frame(int camera) { return frames[camera]; }
+	double lastCaptureMs(int camera) const { return last_capture_ms[camera]; }
+
+	// The detector selected by DETECTOR, created on first use
+	CubeDetector& detector();
+
+	// Fills both frame buffers: a timestamp-matched pair when SYNC_FRAMES is on, otherwise both
+	// cameras captured concurrently on the workers. `next` waits for frames newer than the last
+	// pair. Adds the time spent to capture_ms; returns true for a synchronized pair.
+	bool capturePair(bool next, double& capture_ms);
+	// Captures a frame pair and runs the detector on it. Stickers the detector is unsure about are
+	// re-read from up to vote_max_frames pairs; the result replaces the sticker colors. `next`
+	// waits for a pair newer than the last one, for callers that detect in a loop.
+	DetectionWorkers::Timing detect(bool verbose, bool next = false);
+	// One fresh detection on a frame pair the caller already has
+	void detectPair(const cv::Mat& frame_1, const cv::Mat& frame_2);
+	// The detector's output of the last detection, with its timings
+	const FaceletReading& lastReading() const { return reading; }
+
+	// Sticker colors (detected color letters) and their confidence, 24 per camera
+	std::vector<char>& colors(int camera) { return sticker_colors[camera]; }
+	const std::vector<char>& colors(int camera) const { return sticker_colors[camera]; }
+	std::vector<float>& confidence(int camera) { return sticker_confidence[camera]; }
+	const std::vector<float>& confidence(int camera) const { return sticker_confidence[camera]; }
+
+	// Silent hot-path check: 8 stickers of every face color (one register compare) and, in at least
+	// one orientation, a cube that cubie::check accepts. printValidationReport() explains failures.
+	bool validate() const;
+	void printValidationReport() const;
+	void printUncertainStickers() const;
+
+	// Writes the face string for kCubeOrientations[orientation] without allocating. Face order: UP,
+	// RIGHT, FRONT, DOWN, LEFT, BACK, 9 positions each in row-major order.
+	void faceString(size_t orientation, std::array<char, 54>& cube_state) const {
+		faceString(sticker_colors[0], sticker_colors[1], orientation, cube_state);
+	}
+	static void faceString(const std::vector<char>& colors_1, const std::vector<char>& colors_2, size_t orientation,
+						   std::array<char, 54>& cube_state);
+	// Valid face counts, and a real cube in at least one orientation (what validate() checks)
+	static bool colorsFormCube(const std::vector<char>& colors_1, const std::vector<char>& colors_2);
+
+	// Rewrites up to REPAIR_MAX_STICKERS of the stickers flagged in `changeable` (camera 1 first,
+	// then camera 2) so that all 48 form real corner and edge pieces, trying every orientation.
+	// Returns true if the sticker colors now hold a valid cube; an ambiguous repair is not applied.
+	bool repair(const std::vector<bool>& changeable, bool verbose);
+
+	StateAccumulator makeAccumulator() const;
+	// One accumulation step: merges the current sticker colors into the accumulator and writes the
+	// accumulated state back. Returns true once that state is a valid cube, possibly completed by
+	// the piece repair (`repaired`). A full state that is no valid cube restarts the accumulator.
+	bool absorb(StateAccumulator& accumulator, bool verbose, bool& repaired);
+	// Reads frames into the accumulator until every sticker is locked and the face counts are
+	// valid, or until the deadline. Once only a few stickers are still unlocked, the piece-geometry
+	// repair gets a chance to finish the state before the next frame. The accumulated colors
+	// replace the sticker colors either way.
+	bool accumulate(StateAccumulator& accumulator, std::chrono::steady_clock::time_point deadline, bool verbose);
+
+	// Collects up to SOLVER_MAX_CANDIDATES distinct orientations that form a valid cube
+	void findCandidates(std::vector<OrientationCandidate>& candidates, bool verbose) const {
+		findCandidates(sticker_colors[0], sticker_colors[1], config.solver_max_candidates, candidates, verbose);
+	}
+	// The same for a copy of the sticker colors, e.g. on another pipeline stage
+	static void findCandidates(const std::vector<char>& colors_1, const std::vector<char>& colors_2,
+							   int max_candidates, std::vector<OrientationCandidate>& candidates, bool verbose);
+
+	Stats& stats() { return station_stats; }
+	const Stats& stats() const { return station_stats; }
+	// How often the white balance turned a failed validation into a valid one, and the reverse
+	void printWhiteBalanceStats() const;
+	// ROI_TRACKING: passes, fits, shift and the tracker's cost
+	void printTrackerStats(const char* prefix = "") const;
+
+private:
+	std::unique_ptr<CubeDetector> makeDetector(const std::string& name);
+	// Runs the detector on the frame buffers into `reading`
+	void detectFrames(CubeDetector& cube_detector);
+	void storeReading(const FaceletReading& reading);
+	void compareWhiteBalance(const FaceletReading& reading);
+	// Applies a staged calibration; one relaxed load when there is none
+	void swapStagedCalibration();
+	// Hands the calibrated points to the tracker (created on first use)
+	void trackCalibratedPoints();
+	// Takes over points the tracker moved since the last detection
+	void followTrackedPoints();
+	void captureCamera(int camera, bool next);
+	void copyAccumulatedState(const StateAccumulator& accumulator);
+
+	Config config; // read-only while a pipeline runs
+
+	// Capture group (the pipeline's capture stage)
+	PS3EyeCamera* cameras[2] = {nullptr, nullptr};
+	// Timestamp pairing across both cameras; holds references, so it is reset with the cameras
+	std::unique_ptr<FrameSync> frame_sync;
+	// Persistent per-camera capture threads, created on first use
+	std::unique_ptr<DetectionWorkers> capture_workers;
+	bool capture_new_frames = false;
+	double last_capture_ms[2] = {0, 0};
+	cv::Mat frames[2];
+
+	// Detect group (the pipeline's detect stage); staged_calibration and calibration_staged are
+	// also written by the calibration watcher, which is why they are atomic
+	std::shared_ptr<ColorClassifier> color_classifier;
+	std::vector<cv::Point> sticker_points[2];
+	std::atomic<std::shared_ptr<const Calibration>> staged_calibration;
+	std::atomic<bool> calibration_staged{false};
+	std::unique_ptr<CalibrationWatcher> calibration_watcher;
+	std::unique_ptr<RoiTracker> roi_tracker;
+
+	// The RGB table detector keeps its reference colors here; it is shared by rgb and ensemble
+	std::unique_ptr<ArduinoStyleDetection> rgb_detection;
+	std::unique_ptr<CubeDetector> cube_detector;
+	FaceletReading reading;
+
+	std::vector<char> sticker_colors[2];
+	std::vector<float> sticker_confidence[2];
+
+	// Detection counters: detect group; solve counters: solve group
+	Stats station_stats;
+};
@@ -0,0 +1,238 @@
+#include "station_pipeline.h"
+#include "trace.h"
+#include <future>
+#include <iostream>
+#include <numeric>
+
+static double msSince(StationPipeline::Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(StationPipeline::Clock::now() - start).count();
+}
+
+StationPipeline::StationPipeline(Station& station, SolverService& solver, size_t queue_depth)
+	: station(station), solver(solver), frame_queue(queue_depth), state_queue(queue_depth), job_queue(queue_depth) {}
+
+void StationPipeline::start() {
+	if (running()) return;
+	stopping.store(false, std::memory_order_release);
+	stats = Stats{};
+	started = Clock::now();
+	threads.emplace_back(&StationPipeline::captureStage, this);
+	threads.emplace_back(&StationPipeline::detectStage, this);
+	threads.emplace_back(&StationPipeline::orientationStage, this);
+	threads.emplace_back(&StationPipeline::solveStage, this);
+}
+
+void StationPipeline::stop() {
+	if (!running()) return;
+	stopping.store(true, std::memory_order_release);
+	frame_queue.close();
+	state_queue.close();
+	job_queue.close();
+	for (auto& t : threads) {
+		t.join();
+	}
+	threads.clear();
+	stats.elapsed_s = std::chrono::duration<double>(Clock::now() - started).count();
+	stats.high_water = {frame_queue.highWater(), state_queue.highWater(), job_queue.highWater()};
+}
+
+void StationPipeline::captureStage() {
+	trace::nameThread(station.name() + " capture");
+	while (!stopping.load(std::memory_order_acquire)) {
+		FramePair* pair = frame_queue.waitSlot();
+		if (!pair) break;
+		const auto start = Clock::now();
+		double capture_ms = 0;
+		// Every pair after the first waits for new frames, so the detector never sees one twice
+		station.capturePair(stats.frames > 0, capture_ms);
+		station.frame(0).copyTo(pair->frames[0]);
+		station.frame(1).copyTo(pair->frames[1]);
+		pair->captured = Clock::now();
+		frame_queue.push();
+		stats.frames++;
+		stats.busy_ms[0] += msSince(start);
+	}
+}
+
+void StationPipeline::detectStage() {
+	trace::nameThread(station.name() + " detect");
+	const Config& config = station.getConfig();
+	Station::Stats& station_stats = station.stats();
+	StateAccumulator accumulator = station.makeAccumulator();
+	auto reading_started = Clock::now();
+
+	while (FramePair* pair = frame_queue.waitFront()) {
+		const auto start = Clock::now();
+		station.detectPair(pair->frames[0], pair->frames[1]);
+		const Clock::time_point captured = pair->captured;
+		frame_queue.pop();
+		station_stats.detections++;
+		station_stats.frames++;
+		station_stats.detect_ms += msSince(start);
+
+		bool repaired = false;
+		const bool complete = station.absorb(accumulator, false, repaired);
+		stats.busy_ms[1] += msSince(start);
+		if (!complete) {
+			if (msSince(reading_started) >= config.accumulate_timeout_ms) {
+				stats.timeouts++;
+				station_stats.timeouts++;
+				accumulator.reset();
+				reading_started = Clock::now();
+			}
+			continue;
+		}
+
+		CubeState* state = state_queue.waitSlot();
+		if (!state) break;
+		float confidence = 0;
+		size_t count = 0;
+		for (int cam = 0; cam < 2; cam++) {
+			state->colors[cam] = station.colors(cam);
+			const std::vector<float>& sticker_confidence = station.confidence(cam);
+			confidence = std::accumulate(sticker_confidence.begin(), sticker_confidence.end(), confidence);
+			count += sticker_confidence.size();
+		}
+		state->confidence = count ? confidence / count : 0.0f;
+		state->captured = captured;
+		state_queue.push();
+		stats.states++;
+
+		accumulator.reset();
+		reading_started = Clock::now();
+	}
+}
+
+void StationPipeline::orientationStage() {
+	trace::nameThread(station.name() + " orientation");
+	const int max_candidates = station.getConfig().solver_max_candidates;
+	while (CubeState* state = state_queue.waitFront()) {
+		SolveJob* job = job_queue.waitSlot();
+		if (!job) break;
+		const auto start = Clock::now();
+		Station::findCandidates(state->colors[0], state->colors[1], max_candidates, job->candidates, false);
+		job->confidence = state->confidence;
+		job->captured = state->captured;
+		state_queue.pop();
+		if (job->candidates.empty()) {
+			stats.unsolvable++;
+		} else {
+			job_queue.push();
+		}
+		stats.busy_ms[2] += msSince(start);
+	}
+}
+
+void StationPipeline::solveStage() {
+	struct Pending {
+		std::vector<std::future<SolverService::Result>> results;
+		std::shared_ptr<std::atomic<bool>> cancel;
+		std::array<char, 54> facelets{};
+		float confidence = 0;
+		Clock::time_point captured, submitted;
+	};
+	trace::nameThread(station.name() + " solve");
+	Station::Stats& station_stats = station.stats();
+	Pending pending;
+	bool has_pending = false;
+	std::array<char, 54> last_submitted{};
+
+	auto finish = [&] {
+		Solution solution;
+		for (auto& future : pending.results) {
+			SolverService::Result result = future.get();
+			if (result.solved && (!solution.solved || result.moves.size() < solution.moves.size())) {
+				solution.moves = std::move(result.moves);
+				solution.search_ms = result.search_ms;
+				solution.solved = true;
+			}
+		}
+		const double solve_ms = msSince(pending.submitted);
+		solution.facelets = pending.facelets;
+		solution.confidence = pending.confidence;
+		solution.latency_ms = msSince(pending.captured);
+		stats.busy_ms[3] += solve_ms;
+		station_stats.solve_ms += solve_ms;
+		if (solution.solved) {
+			stats.solved++;
+			station_stats.solved++;
+			stats.latency_ms += solution.latency_ms;
+		} else {
+			stats.solve_failures++;
+			station_stats.solve_failures++;
+		}
+		has_pending = false;
+		if (solution_callback) solution_callback(solution);
+	};
+
+	while (true) {
+		SolveJob* job = nullptr;
+		if (!has_pending) {
+			if (!(job = job_queue.waitFront())) break;
+		} else if (pending.results.front().wait_for(std::chrono::milliseconds(1)) == std::future_status::ready) {
+			finish();
+			continue;
+		} else if (job_queue.isClosed()) {
+			break;
+		} else if (!(job = job_queue.front())) {
+			continue;
+		}
+
+		// Cube still lying there unchanged: nothing new to solve
+		if (job->candidates.front().facelets == last_submitted) {
+			stats.duplicates++;
+			job_queue.pop();
+			continue;
+		}
+		if (has_pending) {
+			if (job->confidence > pending.confidence) {
+				// Queued candidates are skipped; a search already running finishes unseen
+				pending.cancel->store(true, std::memory_order_release);
+				stats.busy_ms[3] += msSince(pending.submitted);
+				stats.cancelled++;
+				has_pending = false;
+			} else {
+				finish();
+			}
+		}
+
+		pending.results.clear();
+		pending.cancel = std::make_shared<std::atomic<bool>>(false);
+		for (const auto& candidate : job->candidates) {
+			pending.results.push_back(solver.submit(candidate.cube, pending.cancel));
+		}
+		pending.facelets = job->candidates.front().facelets;
+		pending.confidence = job->confidence;
+		pending.captured = job->captured;
+		pending.submitted = Clock::now();
+		last_submitted = pending.facelets;
+		has_pending = true;
+		job_queue.pop();
+	}
+	if (has_pending) finish();
+}
+
+void StationPipeline::printStats() const {
+	const double elapsed_s = stats.elapsed_s;
+	const double seconds = elapsed_s > 0 ? elapsed_s : 1.0;
+	const std::string prefix = "[" + station.name() + "] ";
+
+	std::cout << prefix << "⏱️  " << elapsed_s << " s: " << stats.frames << " frame pairs ("
+			  << stats.frames / seconds << "/s), " << stats.states << " states (" << stats.states / seconds
+			  << "/s), " << stats.solved << " solved (" << stats.solved / seconds << "/s)" << std::endl;
+	std::cout << prefix << "   " << stats.duplicates << " duplicates, " << stats.cancelled << " cancelled, "
+			  << stats.solve_failures << " unsolved, " << stats.unsolvable << " without valid orientation, "
+			  << stats.timeouts << " timed out" << std::endl;
+	if (stats.solved) {
+		std::cout << prefix << "   Latency capture → solution: " << stats.latency_ms / stats.solved << " ms mean"
+				  << std::endl;
+	}
+	std::cout << prefix << "   Stage utilization:";
+	for (size_t i = 0; i < stats.busy_ms.size(); i++) {
+		std::cout << " " << kStageNames[i] << " " << static_cast<int>(stats.busy_ms[i] / (seconds * 10.0) + 0.5) << "%";
+	}
+	std::cout << std::endl;
+	std::cout << prefix << "   Queue high water: frames " << stats.high_water[0] << "/" << frame_queue.capacity()
+			  << ", states " << stats.high_water[1] << "/" << state_queue.capacity() << ", jobs "
+			  << stats.high_water[2] << "/" << job_queue.capacity() << std::endl;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "solver_service.h"
+#include "spsc_queue.h"
+#include "station.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Capture → detect → orientation → solve as four threads joined by bounded SPSC queues.
+//
+// The capture stage fills preallocated frame pairs, the detect stage runs the station's detector
+// and feeds the state accumulator, the orientation stage turns every converged state into its
+// solvable orientations and the solve stage hands those to the shared solver service. While cube
+// N is in the solver, frame pairs for cube N + 1 are already captured and classified. A full
+// queue makes the stage before it wait, so frames are never buffered further than the queue
+// depth behind the cameras.
+//
+// When a new state arrives while a solve is still in flight, the solve is cancelled if the new
+// state is more confident; otherwise the new state waits. A state identical to the one solved
+// last is not solved again.
+class StationPipeline {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Solution {
+		bool solved = false;
+		std::vector<int> moves;
+		std::array<char, 54> facelets{};
+		float confidence = 0;    // mean sticker confidence of the state
+		double latency_ms = 0;   // capture of the state's last frame until the solution
+		double search_ms = 0;
+	};
+
+	// Counters since start(); busy times are summed per stage
+	struct Stats {
+		double elapsed_s = 0;
+		uint64_t frames = 0;       // frame pairs captured
+		uint64_t states = 0;       // valid cube states produced
+		uint64_t timeouts = 0;     // readings abandoned after ACCUMULATE_TIMEOUT_MS
+		uint64_t unsolvable = 0;   // states without a solvable orientation
+		uint64_t duplicates = 0;   // states identical to the one solved last
+		uint64_t solved = 0;
+		uint64_t solve_failures = 0;
+		uint64_t cancelled = 0;    // solves superseded by a more confident state
+		double latency_ms = 0;     // summed over solved states
+		std::array<double, 4> busy_ms{}; // capture, detect, orientation, solve
+		std::array<size_t, 3> high_water{}; // frame, state and job queues
+	};
+
+	static constexpr const char* kStageNames[4] = {"capture", "detect", "orientation", "solve"};
+
+	StationPipeline(Station& station, SolverService& solver, size_t queue_depth);
+	~StationPipeline() { stop(); }
+
+	StationPipeline(const StationPipeline&) = delete;
+	StationPipeline& operator=(const StationPipeline&) = delete;
+
+	// Called on the solve stage for every finished solve, solved or not; set before start()
+	void onSolution(std::function<void(const Solution&)> callback) { solution_callback = std::move(callback); }
+
+	void start();
+	// Closes the queues and joins the stages; work in flight is dropped
+	void stop();
+	bool running() const { return !threads.empty(); }
+
+	Station& getStation() { return station; }
+	// Totals of the last run (complete after stop())
+	const Stats& getStats() const { return stats; }
+	// Only after stop(): the stages update the counters without synchronization while running
+	void printStats() const;
+
+private:
+	struct FramePair {
+		cv::Mat frames[2];
+		Clock::time_point captured;
+	};
+	struct CubeState {
+		std::vector<char> colors[2];
+		float confidence = 0;
+		Clock::time_point captured;
+	};
+	struct SolveJob {
+		std::vector<OrientationCandidate> candidates;
+		float confidence = 0;
+		Clock::time_point captured;
+	};
+
+	void captureStage();
+	void detectStage();
+	void orientationStage();
+	void solveStage();
+
+	Station& station;
+	SolverService& solver;
+	SpscQueue<FramePair> frame_queue;
+	SpscQueue<CubeState> state_queue;
+	SpscQueue<SolveJob> job_queue;
+	std::function<void(const Solution&)> solution_callback;
+
+	std::vector<std::thread> threads;
+	std::atomic<bool> stopping{false};
+	Clock::time_point started;
+	Stats stats; // every field is written by one stage only
+};
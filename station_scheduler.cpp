@@ -0,0 +1,61 @@
+#include "station_scheduler.h"
+#include "move.h"
+#include <iostream>
+
+void StationScheduler::start() {
+	if (running()) return;
+	pipelines.clear();
+	for (Station* station : stations) {
+		auto pipeline = std::make_unique<StationPipeline>(*station, solver, station->getConfig().pipeline_queue_depth);
+		pipeline->onSolution([this, station](const StationPipeline::Solution& solution) {
+			printSolution(*station, solution);
+		});
+		pipeline->start();
+		pipelines.push_back(std::move(pipeline));
+	}
+}
+
+void StationScheduler::stop() {
+	for (auto& pipeline : pipelines) {
+		pipeline->stop();
+	}
+}
+
+void StationScheduler::printSolution(const Station& station, const StationPipeline::Solution& solution) {
+	std::lock_guard<std::mutex> lock(output_mutex);
+	if (!solution.solved) {
+		std::cout << "[" << station.name() << "] ❌ No solution found" << std::endl;
+		return;
+	}
+	std::cout << "[" << station.name() << "] 📋 Solution:";
+	for (int move : solution.moves) {
+		std::cout << " " << move::names[move];
+	}
+	std::cout << " (" << solution.moves.size() << " moves, " << solution.latency_ms << " ms after capture)"
+			  << std::endl;
+}
+
+void StationScheduler::printStats() const {
+	std::lock_guard<std::mutex> lock(output_mutex);
+	for (const Station* station : stations) {
+		const Station::Stats& stats = station->stats();
+		const uint64_t solves = stats.solved + stats.solve_failures;
+		std::cout << "[" << station->name() << "] " << stats.states << " states (" << stats.repaired << " repaired, "
+				  << stats.timeouts << " timed out), " << stats.solved << "/" << solves << " solved, detection "
+				  << (stats.detections ? stats.detect_ms / stats.detections : 0.0) << " ms, solve "
+				  << (solves ? stats.solve_ms / solves : 0.0) << " ms, " << stats.calibration_reloads
+				  << " calibration reloads" << std::endl;
+		if (station->getConfig().white_balance && station->getConfig().white_balance_stats) {
+			std::cout << "[" << station->name() << "] white balance: " << stats.white_balance_rescued << "/"
+					  << stats.white_balance_readings << " readings valid only with it, "
+					  << stats.white_balance_broken << " only without" << std::endl;
+		}
+		if (station->getConfig().roi_tracking) {
+			const std::string prefix = "[" + station->name() + "] ";
+			station->printTrackerStats(prefix.c_str());
+		}
+	}
+	for (const auto& pipeline : pipelines) {
+		pipeline->printStats();
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "solver_service.h"
+#include "station.h"
+#include "station_pipeline.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Drives several stations in one process against one shared solver service.
+//
+// Every station runs its own StationPipeline, so frame N + 1 is captured and classified while
+// cube N is being solved. Each pipeline keeps at most one cube in the solver, which keeps the
+// shared service fair between stations.
+class StationScheduler {
+public:
+	explicit StationScheduler(SolverService& solver) : solver(solver) {}
+	~StationScheduler() { stop(); }
+
+	StationScheduler(const StationScheduler&) = delete;
+	StationScheduler& operator=(const StationScheduler&) = delete;
+
+	// Stations must outlive the scheduler and must not be driven by anyone else while it runs
+	void add(Station& station) { stations.push_back(&station); }
+
+	void start();
+	// Stops every station's pipeline
+	void stop();
+	bool running() const { return !pipelines.empty() && pipelines.front()->running(); }
+
+	// Per station: states, solves, mean detection / solve times and the pipeline's throughput (after stop())
+	void printStats() const;
+
+private:
+	// Reports a finished solve of `station`
+	void printSolution(const Station& station, const StationPipeline::Solution& solution);
+
+	SolverService& solver;
+	std::vector<Station*> stations;
+	// One per station, kept after stop() for printStats()
+	std::vector<std::unique_ptr<StationPipeline>> pipelines;
+	// Keeps the stations' lines apart on stdout
+	mutable std::mutex output_mutex;
+};
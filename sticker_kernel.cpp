@@ -0,0 +1,249 @@
+#include "sticker_kernel.h"
+#include "hsv_convert.h"
+#include <algorithm>
+#include <bit>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STICKER_KERNEL_X86 1
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define STICKER_KERNEL_NEON 1
+#endif
+
+namespace sticker_kernel {
+
+static void runScalar(PixelBatch& batch, const ColorClassifier& classifier, size_t begin) {
+	for (size_t i = begin; i < batch.size(); i++) {
+		const cv::Vec3b hsv = hsv::fromBgr(batch.b[i], batch.g[i], batch.r[i]);
+		batch.h[i] = hsv[0];
+		batch.s[i] = hsv[1];
+		batch.v[i] = hsv[2];
+		batch.color[i] = classifier.classify(hsv[0], hsv[1], hsv[2]);
+	}
+}
+
+#ifdef STICKER_KERNEL_X86
+__attribute__((target("avx2")))
+static size_t runAvx2(PixelBatch& batch, const ColorClassifier& classifier) {
+	const int* sdiv = hsv::kSdivTable.data();
+	const int* hdiv = hsv::kHdivTable180.data();
+	const int* h_bits = reinterpret_cast<const int*>(classifier.hueBits().data());
+	const int* s_bits = reinterpret_cast<const int*>(classifier.satBits().data());
+	const int* v_bits = reinterpret_cast<const int*>(classifier.valBits().data());
+
+	const __m256i round = _mm256_set1_epi32(1 << (hsv::kShift - 1));
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i c180 = _mm256_set1_epi32(180);
+	const __m256i c179 = _mm256_set1_epi32(179);
+	const __m256i c255 = _mm256_set1_epi32(255);
+	const __m256i c126 = _mm256_set1_epi32(126);
+	const __m256i exp_mask = _mm256_set1_epi32(0xFF);
+
+	alignas(32) int32_t h_out[8], s_out[8], v_out[8], width_out[8];
+	const size_t n = batch.size();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256i b = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&batch.b[i])));
+		const __m256i g = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&batch.g[i])));
+		const __m256i r = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&batch.r[i])));
+
+		const __m256i v = _mm256_max_epi32(b, _mm256_max_epi32(g, r));
+		const __m256i vmin = _mm256_min_epi32(b, _mm256_min_epi32(g, r));
+		const __m256i diff = _mm256_sub_epi32(v, vmin);
+		const __m256i vr = _mm256_cmpeq_epi32(v, r);
+		const __m256i vg = _mm256_cmpeq_epi32(v, g);
+
+		const __m256i s = _mm256_srai_epi32(
+				_mm256_add_epi32(_mm256_mullo_epi32(diff, _mm256_i32gather_epi32(sdiv, v, 4)), round), hsv::kShift);
+
+		// Same branchless hue selection as hsv::fromBgr()
+		const __m256i diff2 = _mm256_add_epi32(diff, diff);
+		const __m256i h_r = _mm256_sub_epi32(g, b);
+		const __m256i h_g = _mm256_add_epi32(_mm256_sub_epi32(b, r), diff2);
+		const __m256i h_b = _mm256_add_epi32(_mm256_sub_epi32(r, g), _mm256_add_epi32(diff2, diff2));
+		const __m256i h_gb = _mm256_or_si256(_mm256_and_si256(vg, h_g), _mm256_andnot_si256(vg, h_b));
+		__m256i h = _mm256_add_epi32(_mm256_and_si256(vr, h_r), _mm256_andnot_si256(vr, h_gb));
+		h = _mm256_srai_epi32(
+				_mm256_add_epi32(_mm256_mullo_epi32(h, _mm256_i32gather_epi32(hdiv, diff, 4)), round), hsv::kShift);
+		h = _mm256_add_epi32(h, _mm256_and_si256(_mm256_cmpgt_epi32(zero, h), c180));
+		h = _mm256_min_epi32(h, c255);
+
+		// Classifier masks; the highest set bit picks the color
+		__m256i mask = _mm256_i32gather_epi32(h_bits, _mm256_min_epi32(h, c179), 4);
+		mask = _mm256_and_si256(mask, _mm256_i32gather_epi32(s_bits, s, 4));
+		mask = _mm256_and_si256(mask, _mm256_i32gather_epi32(v_bits, v, 4));
+
+		// Smear the top bit down, keep only it, and read its position from the float exponent.
+		// A single power of two converts exactly (bit 31 becomes -2^31, same exponent).
+		mask = _mm256_or_si256(mask, _mm256_srli_epi32(mask, 1));
+		mask = _mm256_or_si256(mask, _mm256_srli_epi32(mask, 2));
+		mask = _mm256_or_si256(mask, _mm256_srli_epi32(mask, 4));
+		mask = _mm256_or_si256(mask, _mm256_srli_epi32(mask, 8));
+		mask = _mm256_or_si256(mask, _mm256_srli_epi32(mask, 16));
+		const __m256i top = _mm256_xor_si256(mask, _mm256_srli_epi32(mask, 1));
+		const __m256i exponent =
+				_mm256_and_si256(_mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(top)), 23), exp_mask);
+		// exponent is 127 + bit index for a set bit and 0 for an empty mask
+		const __m256i width = _mm256_max_epi32(_mm256_sub_epi32(exponent, c126), zero);
+
+		_mm256_store_si256(reinterpret_cast<__m256i*>(h_out), h);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(s_out), s);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(v_out), v);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(width_out), width);
+		for (int k = 0; k < 8; k++) {
+			batch.h[i + k] = static_cast<uint8_t>(h_out[k]);
+			batch.s[i + k] = static_cast<uint8_t>(s_out[k]);
+			batch.v[i + k] = static_cast<uint8_t>(v_out[k]);
+			batch.color[i + k] = classifier.colorForWidth(width_out[k]);
+		}
+	}
+	return i;
+}
+#endif
+
+#ifdef STICKER_KERNEL_NEON
+// Four lanes of a table lookup; NEON has no gather, so load lane by lane
+static inline int32x4_t lookup4(const int32_t* table, int32x4_t index) {
+	int32x4_t out = vdupq_n_s32(0);
+	out = vsetq_lane_s32(table[vgetq_lane_s32(index, 0)], out, 0);
+	out = vsetq_lane_s32(table[vgetq_lane_s32(index, 1)], out, 1);
+	out = vsetq_lane_s32(table[vgetq_lane_s32(index, 2)], out, 2);
+	out = vsetq_lane_s32(table[vgetq_lane_s32(index, 3)], out, 3);
+	return out;
+}
+
+static inline void neon4(const int32x4_t b, const int32x4_t g, const int32x4_t r, const ColorClassifier& classifier,
+						 int32x4_t& h_out, int32x4_t& s_out, int32x4_t& v_out, int32x4_t& width_out) {
+	const int32x4_t round = vdupq_n_s32(1 << (hsv::kShift - 1));
+
+	const int32x4_t v = vmaxq_s32(b, vmaxq_s32(g, r));
+	const int32x4_t vmin = vminq_s32(b, vminq_s32(g, r));
+	const int32x4_t diff = vsubq_s32(v, vmin);
+	const uint32x4_t vr = vceqq_s32(v, r);
+	const uint32x4_t vg = vceqq_s32(v, g);
+
+	const int32x4_t s = vshrq_n_s32(vmlaq_s32(round, diff, lookup4(hsv::kSdivTable.data(), v)), hsv::kShift);
+
+	const int32x4_t diff2 = vaddq_s32(diff, diff);
+	const int32x4_t h_r = vsubq_s32(g, b);
+	const int32x4_t h_g = vaddq_s32(vsubq_s32(b, r), diff2);
+	const int32x4_t h_b = vaddq_s32(vsubq_s32(r, g), vaddq_s32(diff2, diff2));
+	int32x4_t h = vbslq_s32(vr, h_r, vbslq_s32(vg, h_g, h_b));
+	h = vshrq_n_s32(vmlaq_s32(round, h, lookup4(hsv::kHdivTable180.data(), diff)), hsv::kShift);
+	h = vaddq_s32(h, vandq_s32(vreinterpretq_s32_u32(vcltq_s32(h, vdupq_n_s32(0))), vdupq_n_s32(180)));
+	h = vminq_s32(h, vdupq_n_s32(255));
+
+	const auto* h_bits = reinterpret_cast<const int32_t*>(classifier.hueBits().data());
+	const auto* s_bits = reinterpret_cast<const int32_t*>(classifier.satBits().data());
+	const auto* v_bits = reinterpret_cast<const int32_t*>(classifier.valBits().data());
+	uint32x4_t mask = vreinterpretq_u32_s32(lookup4(h_bits, vminq_s32(h, vdupq_n_s32(179))));
+	mask = vandq_u32(mask, vreinterpretq_u32_s32(lookup4(s_bits, s)));
+	mask = vandq_u32(mask, vreinterpretq_u32_s32(lookup4(v_bits, v)));
+
+	h_out = h;
+	s_out = s;
+	v_out = v;
+	width_out = vsubq_s32(vdupq_n_s32(32), vreinterpretq_s32_u32(vclzq_u32(mask)));
+}
+
+static size_t runNeon(PixelBatch& batch, const ColorClassifier& classifier) {
+	int32_t h_out[8], s_out[8], v_out[8], width_out[8];
+	const size_t n = batch.size();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const uint16x8_t b16 = vmovl_u8(vld1_u8(&batch.b[i]));
+		const uint16x8_t g16 = vmovl_u8(vld1_u8(&batch.g[i]));
+		const uint16x8_t r16 = vmovl_u8(vld1_u8(&batch.r[i]));
+
+		for (int half = 0; half < 2; half++) {
+			const uint16x4_t b4 = half ? vget_high_u16(b16) : vget_low_u16(b16);
+			const uint16x4_t g4 = half ? vget_high_u16(g16) : vget_low_u16(g16);
+			const uint16x4_t r4 = half ? vget_high_u16(r16) : vget_low_u16(r16);
+			int32x4_t h, s, v, width;
+			neon4(vreinterpretq_s32_u32(vmovl_u16(b4)), vreinterpretq_s32_u32(vmovl_u16(g4)),
+				  vreinterpretq_s32_u32(vmovl_u16(r4)), classifier, h, s, v, width);
+			vst1q_s32(h_out + half * 4, h);
+			vst1q_s32(s_out + half * 4, s);
+			vst1q_s32(v_out + half * 4, v);
+			vst1q_s32(width_out + half * 4, width);
+		}
+		for (int k = 0; k < 8; k++) {
+			batch.h[i + k] = static_cast<uint8_t>(h_out[k]);
+			batch.s[i + k] = static_cast<uint8_t>(s_out[k]);
+			batch.v[i + k] = static_cast<uint8_t>(v_out[k]);
+			batch.color[i + k] = classifier.colorForWidth(width_out[k]);
+		}
+	}
+	return i;
+}
+#endif
+
+Isa detectIsa() {
+#ifdef STICKER_KERNEL_X86
+	if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+#endif
+#ifdef STICKER_KERNEL_NEON
+	return Isa::NEON; // Advanced SIMD is mandatory on AArch64
+#endif
+	return Isa::Scalar;
+}
+
+const char* isaName(Isa isa) {
+	switch (isa) {
+		case Isa::AVX2: return "AVX2";
+		case Isa::NEON: return "NEON";
+		default: return "scalar";
+	}
+}
+
+void run(PixelBatch& batch, const ColorClassifier& classifier, Isa isa) {
+	size_t done = 0;
+#ifdef STICKER_KERNEL_X86
+	if (isa == Isa::AVX2) done = runAvx2(batch, classifier);
+#endif
+#ifdef STICKER_KERNEL_NEON
+	if (isa == Isa::NEON) done = runNeon(batch, classifier);
+#endif
+	runScalar(batch, classifier, done);
+}
+
+void run(PixelBatch& batch, const ColorClassifier& classifier) {
+	static const Isa isa = detectIsa();
+	run(batch, classifier, isa);
+}
+
+size_t selfTest(const ColorClassifier& classifier) {
+	const Isa isa = detectIsa();
+	PixelBatch simd, scalar;
+	simd.resize(1 << 16);
+	scalar.resize(1 << 16);
+
+	size_t mismatches = 0;
+	for (int b = 0; b < 256; b++) {
+		// One batch holds every (g, r) combination for a fixed b
+		for (int gr = 0; gr < (1 << 16); gr++) {
+			simd.b[gr] = scalar.b[gr] = static_cast<uint8_t>(b);
+			simd.g[gr] = scalar.g[gr] = static_cast<uint8_t>(gr >> 8);
+			simd.r[gr] = scalar.r[gr] = static_cast<uint8_t>(gr & 0xFF);
+		}
+		run(simd, classifier, isa);
+		run(scalar, classifier, Isa::Scalar);
+		for (size_t i = 0; i < simd.size(); i++) {
+			if (simd.h[i] != scalar.h[i] || simd.s[i] != scalar.s[i] || simd.v[i] != scalar.v[i] ||
+				simd.color[i] != scalar.color[i]) {
+				if (mismatches < 10) {
+					std::cerr << "Mismatch at BGR(" << b << "," << int(simd.g[i]) << "," << int(simd.r[i]) << ")"
+							  << std::endl;
+				}
+				mismatches++;
+			}
+		}
+	}
+	return mismatches;
+}
+
+}
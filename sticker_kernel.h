@@ -0,0 +1,41 @@
+#pragma once
+#include "color_lut.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sampled sticker pixels in structure-of-arrays layout, so the kernel can load the same channel
+// of 8 pixels at once. Inputs are b/g/r, outputs h/s/v and the color class.
+struct PixelBatch {
+	std::vector<uint8_t> b, g, r;
+	std::vector<uint8_t> h, s, v;
+	std::vector<char> color;
+
+	void resize(size_t n) {
+		for (auto* channel : {&b, &g, &r, &h, &s, &v}) channel->resize(n);
+		color.resize(n);
+	}
+	size_t size() const { return b.size(); }
+};
+
+// BGR -> HSV -> color class for a whole batch in one pass, bit-exact with hsv::fromBgr()
+// followed by ColorClassifier::classify().
+//
+// The AVX2 path handles 8 pixels per iteration with gathers for the reciprocal tables and the
+// classifier masks; the NEON path (AArch64) handles 8 per iteration with lane loads instead of
+// gathers. Both fall back to the scalar loop for the tail. The path is chosen once at runtime.
+namespace sticker_kernel {
+	enum class Isa { Scalar, AVX2, NEON };
+
+	// Best path supported by this CPU and build
+	Isa detectIsa();
+	const char* isaName(Isa isa);
+
+	// Runs the detected path
+	void run(PixelBatch& batch, const ColorClassifier& classifier);
+	// Runs a specific path; unsupported paths fall back to scalar
+	void run(PixelBatch& batch, const ColorClassifier& classifier, Isa isa);
+
+	// Compares the active path against the scalar one over all 2^24 BGR values
+	size_t selfTest(const ColorClassifier& classifier);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "cube_geometry.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Packed form of the 48 detected stickers for the validation hot path.
+//
+// Every sticker is one byte holding its face code (0-5 in cube_geometry::kFaces order, 6 for an
+// unknown color). The per-face histogram lives in a single 64-bit register, one byte lane per
+// code, so checking "8 stickers of every face and none unknown" is one compare with no map and
+// no branches per sticker.
+namespace sticker_state {
+	constexpr uint8_t kUnknown = 6;
+	constexpr size_t kStickers = 48;
+
+	// Detected color -> face code: W=U, B=R, R=F, Y=D, G=L, O=B, everything else unknown
+	inline constexpr std::array<uint8_t, 256> kFaceCode = [] {
+		std::array<uint8_t, 256> t{};
+		t.fill(kUnknown);
+		t['W'] = 0;
+		t['B'] = 1;
+		t['R'] = 2;
+		t['Y'] = 3;
+		t['G'] = 4;
+		t['O'] = 5;
+		return t;
+	}();
+
+	constexpr char faceOf(char color) {
+		const uint8_t code = kFaceCode[static_cast<uint8_t>(color)];
+		return code == kUnknown ? 'N' : cube_geometry::kFaces[code];
+	}
+
+	// Inverse of faceOf(): the detected color of a face's stickers, 'N' for anything else
+	constexpr char colorOf(char face) {
+		const int code = cube_geometry::faceIndex(face);
+		if (code < 0) return 'N';
+		for (int c = 0; c < 256; c++) {
+			if (kFaceCode[c] == code) return static_cast<char>(c);
+		}
+		return 'N';
+	}
+
+	using Packed = std::array<uint8_t, kStickers>;
+
+	inline void pack(const char* colors, size_t count, size_t first, Packed& stickers) {
+		for (size_t i = 0; i < count && first + i < kStickers; i++) {
+			stickers[first + i] = kFaceCode[static_cast<uint8_t>(colors[i])];
+		}
+	}
+
+	// Byte lane c counts the stickers with face code c (48 fits in a lane)
+	inline uint64_t histogram(const Packed& stickers) {
+		uint64_t counts = 0;
+		for (uint8_t code : stickers) counts += 1ull << (code * 8);
+		return counts;
+	}
+
+	constexpr int faceCount(uint64_t histogram, int code) { return static_cast<int>((histogram >> (code * 8)) & 0xff); }
+
+	// 8 of each of the six faces, nothing unknown
+	constexpr uint64_t kValidHistogram = 0x0000080808080808ull;
+
+	inline bool countsValid(const Packed& stickers) { return histogram(stickers) == kValidHistogram; }
+}
@@ -0,0 +1,125 @@
+#include "sticker_vote.h"
+#include "yuyv.h"
+#include <algorithm>
+#include <iostream>
+
+PatchVoter::PatchVoter(int patch_size, int patch_step, float min_confidence) {
+	configure(patch_size, patch_step, min_confidence);
+}
+
+void PatchVoter::configure(int patch_size, int patch_step, float min_confidence) {
+	this->patch_size = std::max(1, patch_size | 1); // even sizes have no center pixel
+	this->patch_step = std::max(1, patch_step);
+	this->min_confidence = min_confidence;
+
+	const int radius = this->patch_size / 2;
+	offsets.assign(1, cv::Point(0, 0));
+	for (int dy = -radius; dy <= radius; dy++) {
+		for (int dx = -radius; dx <= radius; dx++) {
+			if (dx != 0 || dy != 0) offsets.emplace_back(dx * this->patch_step, dy * this->patch_step);
+		}
+	}
+}
+
+void PatchVoter::reset(size_t stickers) {
+	tallies.assign(stickers, Tally{});
+	colors.assign(stickers, 'N');
+	confidence.assign(stickers, 0.0f);
+}
+
+size_t PatchVoter::sample(const cv::Mat& frame, const std::vector<cv::Point>& points,
+						  const ColorClassifier& classifier, int camera_number) {
+	if (frame.empty()) {
+		std::cerr << "Error: Camera " << camera_number << " frame is empty" << std::endl;
+		return uncertainCount();
+	}
+	gather(frame, points, camera_number);
+	classify(classifier);
+	return vote();
+}
+
+size_t PatchVoter::gather(const cv::Mat& frame, const std::vector<cv::Point>& points, int camera_number) {
+	if (tallies.size() != points.size()) reset(points.size());
+
+	batch.resize(points.size() * offsets.size());
+	lane_sticker.resize(batch.size());
+	// Raw camera frames are sampled in place, converting only the patch pixels
+	const bool yuyv_frame = yuyv::isYuyv(frame);
+	const bool corrected = !gains.identity();
+	size_t lanes = 0;
+	for (size_t i = 0; i < points.size(); i++) {
+		if (confident(i)) continue;
+
+		const int x = points[i].x;
+		const int y = points[i].y;
+		if (x < 0 || x >= frame.cols || y < 0 || y >= frame.rows) {
+			std::cerr << "Warning: Point " << i << " (" << x << "," << y << ") is out of bounds for camera "
+					  << camera_number << " frame (" << frame.cols << "x" << frame.rows << ")" << std::endl;
+			continue;
+		}
+
+		// Patch pixels past the frame edge are clamped, so a sticker near the border still gets k x k votes
+		for (const cv::Point& offset : offsets) {
+			const int px = std::clamp(x + offset.x, 0, frame.cols - 1);
+			const int py = std::clamp(y + offset.y, 0, frame.rows - 1);
+			if (yuyv_frame) {
+				yuyv::pixelBgr(frame, px, py, batch.b[lanes], batch.g[lanes], batch.r[lanes]);
+			} else {
+				const cv::Vec3b& bgr = frame.at<cv::Vec3b>(py, px);
+				batch.b[lanes] = bgr[0];
+				batch.g[lanes] = bgr[1];
+				batch.r[lanes] = bgr[2];
+			}
+			if (corrected) gains.apply(batch.b[lanes], batch.g[lanes], batch.r[lanes]);
+			lane_sticker[lanes] = static_cast<uint32_t>(i);
+			lanes++;
+		}
+	}
+	batch.resize(lanes);
+	lane_sticker.resize(lanes);
+	return lanes;
+}
+
+size_t PatchVoter::vote() {
+	for (size_t lane = 0; lane < batch.size(); lane++) {
+		tallies[lane_sticker[lane]].add(batch.color[lane]);
+	}
+
+	size_t uncertain = 0;
+	for (size_t i = 0; i < tallies.size(); i++) {
+		const Tally& tally = tallies[i];
+		int best = -1;
+		for (int c = 0; c < tally.colors; c++) {
+			// 'N' only wins by default: a patch half in glare still reads as the sticker's color
+			if (tally.color[c] != 'N' && (best < 0 || tally.count[c] > tally.count[best])) best = c;
+		}
+		colors[i] = best < 0 ? 'N' : tally.color[best];
+		confidence[i] = best < 0 || tally.total == 0 ? 0.0f : static_cast<float>(tally.count[best]) / tally.total;
+		if (!confident(i)) uncertain++;
+	}
+	return uncertain;
+}
+
+size_t PatchVoter::uncertainCount() const {
+	size_t uncertain = 0;
+	for (size_t i = 0; i < confidence.size(); i++) {
+		if (!confident(i)) uncertain++;
+	}
+	return uncertain;
+}
+
+void PatchVoter::Tally::add(char c) {
+	total++;
+	for (int i = 0; i < colors; i++) {
+		if (color[i] == c) {
+			count[i]++;
+			return;
+		}
+	}
+	// A full tally only counts the vote against the others
+	if (colors < kMaxColors) {
+		color[colors] = c;
+		count[colors] = 1;
+		colors++;
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include "color_lut.h"
+#include "sticker_kernel.h"
+#include "white_balance.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Per-sticker patch sampling with a majority vote and a confidence score.
+//
+// Instead of one pixel per sticker, a k x k grid of pixels around every calibrated point goes
+// through the sticker kernel, and each sticker takes the most frequent known color of its patch.
+// The confidence is the winner's share of all votes the sticker has collected. Votes accumulate
+// across frames until reset(), so a sticker that was uncertain on one frame (glare, noise, motion)
+// is re-sampled from the next one while stickers that are already confident keep their color and
+// are skipped.
+class PatchVoter {
+public:
+	// patch_size pixels per side (odd, 1 = single pixel), patch_step pixels between samples
+	explicit PatchVoter(int patch_size = 3, int patch_step = 2, float min_confidence = 0.6f);
+
+	void configure(int patch_size, int patch_step, float min_confidence);
+
+	// Starts a new reading of `stickers` stickers: drops all votes, everything is uncertain
+	void reset(size_t stickers);
+
+	// Samples, classifies and votes every uncertain sticker from one frame, BGR (CV_8UC3) or raw
+	// YUYV (CV_8UC2). Returns the number of stickers that are still uncertain afterwards.
+	size_t sample(const cv::Mat& frame, const std::vector<cv::Point>& points, const ColorClassifier& classifier,
+				  int camera_number);
+
+	// The three steps of sample(), separately for timing. gather() returns the number of lanes.
+	size_t gather(const cv::Mat& frame, const std::vector<cv::Point>& points, int camera_number);
+	void classify(const ColorClassifier& classifier) { sticker_kernel::run(batch, classifier); }
+	// Any other per-pixel classifier, called as classify(r, g, b) -> color
+	template <class Classify>
+	void classifyWith(Classify&& classify) {
+		for (size_t lane = 0; lane < batch.size(); lane++) {
+			batch.color[lane] = classify(batch.r[lane], batch.g[lane], batch.b[lane]);
+		}
+	}
+	size_t vote();
+
+	// Channel gains gather() applies to every sampled pixel (identity = none)
+	void setGains(const WhiteBalance::Gains& channel_gains) { gains = channel_gains; }
+
+	size_t size() const { return tallies.size(); }
+	size_t uncertainCount() const;
+	bool confident(size_t sticker) const { return confidence[sticker] >= min_confidence; }
+	float minConfidence() const { return min_confidence; }
+	int patchSize() const { return patch_size; }
+
+	// Winning color ('N' while no known color was seen) and its share of the votes, per sticker
+	const std::vector<char>& getColors() const { return colors; }
+	const std::vector<float>& getConfidence() const { return confidence; }
+
+private:
+	// Votes per color, a handful of entries since a patch rarely sees more than two or three colors
+	struct Tally {
+		static constexpr int kMaxColors = 8;
+		std::array<char, kMaxColors> color{};
+		std::array<uint16_t, kMaxColors> count{};
+		uint8_t colors = 0;
+		uint16_t total = 0;
+
+		void add(char c);
+	};
+
+	int patch_size;
+	int patch_step;
+	float min_confidence;
+	std::vector<cv::Point> offsets; // center first, so ties go to the center pixel's color
+	WhiteBalance::Gains gains;
+
+	PixelBatch batch;
+	std::vector<uint32_t> lane_sticker; // sticker index of each lane; out-of-frame points get no lanes
+	std::vector<Tally> tallies;
+	std::vector<char> colors;
+	std::vector<float> confidence;
+};
@@ -0,0 +1,156 @@
+#include "table_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr char kManifestMagic[8] = {'R', 'C', 'T', 'B', 'L', 'M', 'F', '1'};
+static constexpr uint32_t kManifestVersion = 1;
+static constexpr int kSampleBlocks = 64;
+static constexpr size_t kSampleBlockSize = 64 * 1024;
+
+struct Manifest {
+	char magic[8];
+	uint32_t manifest_version;
+	uint32_t table_format;
+	uint64_t table_size;
+	uint64_t sampled_hash;
+	uint64_t full_hash;
+	uint64_t checksum; // over all fields above, catches a corrupted manifest
+};
+
+// Word-at-a-time multiplicative hash; fast enough to run over the whole table file
+static uint64_t hashBytes(const unsigned char* data, size_t size, uint64_t h) {
+	constexpr uint64_t kMul = 0x9E3779B97F4A7C15ull;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		std::memcpy(&word, data + i, 8);
+		h = (h ^ word) * kMul;
+		h ^= h >> 29;
+	}
+	for (; i < size; i++) {
+		h = (h ^ data[i]) * kMul;
+	}
+	return h;
+}
+
+static uint64_t manifestChecksum(const Manifest& m) {
+	return hashBytes(reinterpret_cast<const unsigned char*>(&m), offsetof(Manifest, checksum), 0);
+}
+
+TableCache::TableCache(std::string table_path) :
+	table_path(std::move(table_path)), manifest_path(this->table_path + ".manifest") {}
+
+bool TableCache::hashFile(bool full, Hashes& hashes, uint64_t& size) {
+	int fd = open(table_path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st{};
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	size = static_cast<uint64_t>(st.st_size);
+	const size_t file_size = static_cast<size_t>(st.st_size);
+
+	// The sampled check only touches 64 blocks, so pages are faulted in as the hash reaches them
+	void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		std::cerr << "Warning: Could not map " << table_path << ": " << std::strerror(errno) << std::endl;
+		return false;
+	}
+	const auto* data = static_cast<const unsigned char*>(mapped);
+
+	hashes.sampled = hashBytes(reinterpret_cast<const unsigned char*>(&size), sizeof(size), 0);
+	const size_t block = std::min(kSampleBlockSize, file_size);
+	for (int i = 0; i < kSampleBlocks; i++) {
+		const size_t offset = (file_size - block) / (kSampleBlocks - 1) * i;
+		hashes.sampled = hashBytes(data + offset, block, hashes.sampled);
+	}
+
+	hashes.full = full ? hashBytes(data, file_size, 0) : 0;
+	munmap(mapped, file_size);
+	return true;
+}
+
+TableCache::State TableCache::check(bool full_check) {
+	struct stat st{};
+	if (stat(table_path.c_str(), &st) != 0) return State::Missing;
+
+	Manifest m{};
+	std::ifstream in(manifest_path, std::ios::binary);
+	if (!in.read(reinterpret_cast<char*>(&m), sizeof(m))) {
+		std::cerr << "Warning: " << manifest_path << " missing or truncated" << std::endl;
+		return State::Stale;
+	}
+	if (std::memcmp(m.magic, kManifestMagic, sizeof(kManifestMagic)) != 0 || m.checksum != manifestChecksum(m) ||
+		m.manifest_version != kManifestVersion) {
+		std::cerr << "Warning: " << manifest_path << " is corrupted or from another version" << std::endl;
+		return State::Stale;
+	}
+	if (m.table_format != kTableFormat) {
+		std::cerr << "Warning: " << table_path << " was built for table format " << m.table_format
+				  << ", expected " << kTableFormat << std::endl;
+		return State::Stale;
+	}
+	if (static_cast<uint64_t>(st.st_size) != m.table_size) {
+		std::cerr << "Warning: " << table_path << " is " << st.st_size << " bytes, expected " << m.table_size
+				  << " (truncated?)" << std::endl;
+		return State::Stale;
+	}
+
+	Hashes hashes;
+	uint64_t size = 0;
+	if (!hashFile(full_check, hashes, size) || hashes.sampled != m.sampled_hash ||
+		(full_check && hashes.full != m.full_hash)) {
+		std::cerr << "Warning: " << table_path << " content does not match its manifest" << std::endl;
+		return State::Stale;
+	}
+	return State::Valid;
+}
+
+void TableCache::discard() {
+	std::remove(table_path.c_str());
+	std::remove(manifest_path.c_str());
+}
+
+bool TableCache::writeManifest() {
+	Hashes hashes;
+	uint64_t size = 0;
+	if (!hashFile(true, hashes, size)) {
+		std::cerr << "Warning: Could not read " << table_path << " to write its manifest" << std::endl;
+		return false;
+	}
+
+	Manifest m{};
+	std::memcpy(m.magic, kManifestMagic, sizeof(kManifestMagic));
+	m.manifest_version = kManifestVersion;
+	m.table_format = kTableFormat;
+	m.table_size = size;
+	m.sampled_hash = hashes.sampled;
+	m.full_hash = hashes.full;
+	m.checksum = manifestChecksum(m);
+
+	// Write to a temporary and rename, so a concurrent reader never sees half a manifest
+	const std::string tmp_path = manifest_path + ".tmp";
+	{
+		std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+		if (!out.write(reinterpret_cast<const char*>(&m), sizeof(m))) {
+			std::cerr << "Warning: Could not write " << tmp_path << std::endl;
+			return false;
+		}
+	}
+	if (std::rename(tmp_path.c_str(), manifest_path.c_str()) != 0) {
+		std::cerr << "Warning: Could not replace " << manifest_path << std::endl;
+		return false;
+	}
+	return true;
+}
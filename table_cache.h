@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Integrity checking for rob-twophase's table file.
+//
+// prun::init(true) loads every move, symmetry and pruning table from a single file (building
+// and writing it when it is missing), but trusts whatever it finds on disk. TableCache keeps a
+// small versioned manifest next to that file with its size and content hashes. A stale or
+// truncated table file is detected and removed before the solver reads it, so it is rebuilt.
+// prun::init reads the file into its own tables, so the cache only looks at it while hashing.
+class TableCache {
+public:
+	enum class State { Valid, Missing, Stale };
+
+	// Bump whenever the rob-twophase submodule changes its table layout
+	static constexpr uint32_t kTableFormat = 1;
+
+	explicit TableCache(std::string table_path);
+
+	TableCache(const TableCache&) = delete;
+	TableCache& operator=(const TableCache&) = delete;
+
+	// Compares the table file against its manifest. The sampled check reads 64 blocks spread
+	// over the file; full_check hashes every byte.
+	State check(bool full_check);
+	// Deletes the table file and its manifest so the next prun::init(true) rebuilds them
+	void discard();
+	// Writes the manifest for the current table file (after prun::init(true) built it)
+	bool writeManifest();
+
+	const std::string& manifestPath() const { return manifest_path; }
+
+private:
+	struct Hashes {
+		uint64_t sampled = 0;
+		uint64_t full = 0;
+	};
+	// Maps the table file read-only for the duration of the hash
+	bool hashFile(bool full, Hashes& hashes, uint64_t& size);
+
+	std::string table_path;
+	std::string manifest_path;
+};
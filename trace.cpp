@@ -0,0 +1,301 @@
+#include "trace.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace trace {
+
+namespace {
+
+// One thread's spans and histograms. Only the owning thread writes; every field is atomic so
+// exporters may read concurrently, and relaxed single-writer stores compile to plain moves.
+struct ThreadBuffer {
+	struct Span {
+		std::atomic<uint64_t> start_ns{0};
+		std::atomic<uint64_t> end_ns{0};
+		std::atomic<uint8_t> stage{0};
+	};
+	struct Histogram {
+		std::array<std::atomic<uint64_t>, kBuckets> buckets{};
+		std::atomic<uint64_t> count{0};
+		std::atomic<uint64_t> sum_ns{0};
+		std::atomic<uint64_t> max_ns{0};
+	};
+
+	int tid = 0;
+	std::string name;
+	std::atomic<uint64_t> written{0}; // spans ever recorded; the ring holds the last kRingSize
+	std::array<Span, kRingSize> ring;
+	std::array<Histogram, kStages> histograms;
+};
+
+// Single-writer increment without a locked instruction
+inline void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+	counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+size_t bucketOf(uint64_t duration_ns) {
+	const uint64_t us = duration_ns / 1000;
+	size_t bucket = 0;
+	while (bucket < kBuckets - 1 && us > kBucketBoundsUs[bucket]) bucket++;
+	return bucket;
+}
+
+// Buffers are never freed, so the spans of threads that have exited are still exported
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+ThreadBuffer& threadBuffer() {
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (!buffer) {
+		auto created = std::make_unique<ThreadBuffer>();
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		created->tid = static_cast<int>(registry.size()) + 1;
+		created->name = "thread " + std::to_string(created->tid);
+		buffer = created.get();
+		registry.push_back(std::move(created));
+	}
+	return *buffer;
+}
+
+struct SpanCopy {
+	uint64_t start_ns, end_ns;
+	uint8_t stage;
+};
+
+// The spans of one ring that were not overwritten while copying them
+std::vector<SpanCopy> copyRing(const ThreadBuffer& buffer) {
+	const uint64_t written = buffer.written.load(std::memory_order_acquire);
+	const uint64_t first = written > kRingSize ? written - kRingSize : 0;
+	std::vector<SpanCopy> spans;
+	spans.reserve(written - first);
+	for (uint64_t i = first; i < written; i++) {
+		const ThreadBuffer::Span& span = buffer.ring[i % kRingSize];
+		spans.push_back({span.start_ns.load(std::memory_order_relaxed), span.end_ns.load(std::memory_order_relaxed),
+						 span.stage.load(std::memory_order_relaxed)});
+	}
+	// The owner kept recording meanwhile: drop what it may have overwritten under us. It fills
+	// slot `written` before bumping the count, so the oldest span still in the ring may be half
+	// replaced as well. The fence keeps the span loads above from moving below this count load
+	// (it pairs with the one in record()), as in a seqlock reader.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64_t now_written = buffer.written.load(std::memory_order_relaxed);
+	const uint64_t overwritten = now_written + 1 > kRingSize ? now_written + 1 - kRingSize : 0;
+	if (overwritten > first) {
+		spans.erase(spans.begin(), spans.begin() + std::min<uint64_t>(overwritten - first, spans.size()));
+	}
+	return spans;
+}
+
+double percentile(std::vector<uint64_t>& sorted_ns, double p) {
+	if (sorted_ns.empty()) return 0;
+	const size_t rank = std::clamp<size_t>(static_cast<size_t>(p / 100.0 * sorted_ns.size() + 0.5), 1, sorted_ns.size());
+	return sorted_ns[rank - 1] / 1e6;
+}
+
+// Runs `f(buffer)` for every registered buffer under the registry lock
+template <class F>
+void forEachBuffer(F&& f) {
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	for (const auto& buffer : registry) {
+		f(*buffer);
+	}
+}
+
+} // namespace
+
+void record(Stage stage, uint64_t start_ns, uint64_t end_ns) {
+	ThreadBuffer& buffer = threadBuffer();
+	const uint64_t index = buffer.written.load(std::memory_order_relaxed);
+	ThreadBuffer::Span& span = buffer.ring[index % kRingSize];
+	// A reader that sees any of the stores below also sees the count published before them
+	std::atomic_thread_fence(std::memory_order_release);
+	span.start_ns.store(start_ns, std::memory_order_relaxed);
+	span.end_ns.store(end_ns, std::memory_order_relaxed);
+	span.stage.store(static_cast<uint8_t>(stage), std::memory_order_relaxed);
+	buffer.written.store(index + 1, std::memory_order_release);
+
+	const uint64_t duration_ns = end_ns - start_ns;
+	ThreadBuffer::Histogram& histogram = buffer.histograms[static_cast<size_t>(stage)];
+	bump(histogram.buckets[bucketOf(duration_ns)]);
+	bump(histogram.count);
+	bump(histogram.sum_ns, duration_ns);
+	if (duration_ns > histogram.max_ns.load(std::memory_order_relaxed)) {
+		histogram.max_ns.store(duration_ns, std::memory_order_relaxed);
+	}
+}
+
+void nameThread(const std::string& name) {
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	buffer.name = name;
+}
+
+std::vector<Summary> summarize() {
+	std::array<Summary, kStages> totals{};
+	std::array<uint64_t, kStages> sum_ns{}, max_ns{};
+	std::array<std::vector<uint64_t>, kStages> recent_ns;
+	forEachBuffer([&](const ThreadBuffer& buffer) {
+		for (size_t s = 0; s < kStages; s++) {
+			const ThreadBuffer::Histogram& histogram = buffer.histograms[s];
+			totals[s].count += histogram.count.load(std::memory_order_relaxed);
+			sum_ns[s] += histogram.sum_ns.load(std::memory_order_relaxed);
+			max_ns[s] = std::max(max_ns[s], histogram.max_ns.load(std::memory_order_relaxed));
+		}
+		for (const SpanCopy& span : copyRing(buffer)) {
+			recent_ns[span.stage].push_back(span.end_ns - span.start_ns);
+		}
+	});
+
+	std::vector<Summary> summaries;
+	for (size_t s = 0; s < kStages; s++) {
+		Summary& summary = totals[s];
+		if (!summary.count) continue;
+		summary.stage = static_cast<Stage>(s);
+		summary.mean_ms = sum_ns[s] / 1e6 / summary.count;
+		summary.max_ms = max_ns[s] / 1e6;
+		std::sort(recent_ns[s].begin(), recent_ns[s].end());
+		summary.p50_ms = percentile(recent_ns[s], 50);
+		summary.p99_ms = percentile(recent_ns[s], 99);
+		summaries.push_back(summary);
+	}
+	return summaries;
+}
+
+void printSummary() {
+	const std::vector<Summary> summaries = summarize();
+	if (summaries.empty()) return;
+	std::cout << std::left << std::setw(12) << "stage" << std::right << std::setw(10) << "count" << std::setw(11)
+			  << "mean ms" << std::setw(11) << "p50 ms" << std::setw(11) << "p99 ms" << std::setw(11) << "max ms"
+			  << std::endl;
+	std::cout << std::fixed << std::setprecision(4);
+	for (const Summary& s : summaries) {
+		std::cout << std::left << std::setw(12) << kStageNames[static_cast<size_t>(s.stage)] << std::right
+				  << std::setw(10) << s.count << std::setw(11) << s.mean_ms << std::setw(11) << s.p50_ms
+				  << std::setw(11) << s.p99_ms << std::setw(11) << s.max_ms << std::endl;
+	}
+	std::cout << std::defaultfloat;
+}
+
+bool writePrometheus(const std::string& filename) {
+	struct Totals {
+		std::array<uint64_t, kBuckets> buckets{};
+		uint64_t count = 0, sum_ns = 0, max_ns = 0;
+	};
+	std::array<Totals, kStages> totals{};
+	forEachBuffer([&](const ThreadBuffer& buffer) {
+		for (size_t s = 0; s < kStages; s++) {
+			const ThreadBuffer::Histogram& histogram = buffer.histograms[s];
+			for (size_t b = 0; b < kBuckets; b++) {
+				totals[s].buckets[b] += histogram.buckets[b].load(std::memory_order_relaxed);
+			}
+			totals[s].count += histogram.count.load(std::memory_order_relaxed);
+			totals[s].sum_ns += histogram.sum_ns.load(std::memory_order_relaxed);
+			totals[s].max_ns = std::max(totals[s].max_ns, histogram.max_ns.load(std::memory_order_relaxed));
+		}
+	});
+
+	const std::string temp_file = filename + ".tmp";
+	{
+		std::ofstream out(temp_file);
+		if (!out.is_open()) {
+			std::cerr << "Error: Could not open " << temp_file << " for writing" << std::endl;
+			return false;
+		}
+		out << std::setprecision(9);
+		out << "# HELP cube_stage_duration_seconds Latency of the detection and solving stages\n";
+		out << "# TYPE cube_stage_duration_seconds histogram\n";
+		for (size_t s = 0; s < kStages; s++) {
+			uint64_t cumulative = 0;
+			for (size_t b = 0; b < kBuckets; b++) {
+				cumulative += totals[s].buckets[b];
+				out << "cube_stage_duration_seconds_bucket{stage=\"" << kStageNames[s] << "\",le=\"";
+				if (b + 1 < kBuckets) {
+					out << kBucketBoundsUs[b] / 1e6;
+				} else {
+					out << "+Inf";
+				}
+				out << "\"} " << cumulative << "\n";
+			}
+			out << "cube_stage_duration_seconds_sum{stage=\"" << kStageNames[s] << "\"} " << totals[s].sum_ns / 1e9 << "\n";
+			out << "cube_stage_duration_seconds_count{stage=\"" << kStageNames[s] << "\"} " << totals[s].count << "\n";
+		}
+		out << "# HELP cube_stage_duration_max_seconds Slowest span of each stage since startup\n";
+		out << "# TYPE cube_stage_duration_max_seconds gauge\n";
+		for (size_t s = 0; s < kStages; s++) {
+			out << "cube_stage_duration_max_seconds{stage=\"" << kStageNames[s] << "\"} " << totals[s].max_ns / 1e9 << "\n";
+		}
+		if (!out) {
+			std::cerr << "Error: Could not write " << temp_file << std::endl;
+			return false;
+		}
+	}
+	if (std::rename(temp_file.c_str(), filename.c_str()) != 0) {
+		std::cerr << "Error: Could not replace " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool writeChromeTrace(const std::string& filename) {
+	std::ofstream out(filename);
+	if (!out.is_open()) {
+		std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+		return false;
+	}
+
+	struct ThreadSpans {
+		int tid;
+		std::string name;
+		std::vector<SpanCopy> spans;
+	};
+	std::vector<ThreadSpans> threads;
+	uint64_t origin_ns = UINT64_MAX;
+	forEachBuffer([&](const ThreadBuffer& buffer) {
+		threads.push_back({buffer.tid, buffer.name, copyRing(buffer)});
+		for (const SpanCopy& span : threads.back().spans) origin_ns = std::min(origin_ns, span.start_ns);
+	});
+
+	// Timestamps in microseconds relative to the oldest span
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	bool first = true;
+	for (const ThreadSpans& thread : threads) {
+		out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread.tid
+			<< ", \"args\": {\"name\": \"" << thread.name << "\"}}";
+		first = false;
+		for (const SpanCopy& span : thread.spans) {
+			out << ",\n{\"name\": \"" << kStageNames[span.stage] << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+				<< thread.tid << ", \"ts\": " << (span.start_ns - origin_ns) / 1e3
+				<< ", \"dur\": " << (span.end_ns - span.start_ns) / 1e3 << "}";
+		}
+	}
+	out << "\n]}\n";
+	return static_cast<bool>(out);
+}
+
+PeriodicExport::PeriodicExport(std::string filename, std::chrono::milliseconds interval)
+	: filename(std::move(filename)) {
+	thread = std::thread([this, interval] {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+			writePrometheus(this->filename);
+		}
+	});
+}
+
+PeriodicExport::~PeriodicExport() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	thread.join();
+	writePrometheus(filename);
+}
+
+} // namespace trace
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Low-overhead hot-path instrumentation.
+//
+// A trace::Scope around a stage takes two steady_clock readings and appends one span to a ring
+// buffer owned by the calling thread, plus one count to that thread's latency histogram. Nothing
+// is locked, allocated or printed on the way: a thread's buffer is registered once, on its first
+// span, and only ever written by that thread. Exporters read all buffers from any thread, so the
+// metrics of a running pipeline can be scraped while it works.
+//
+// The histograms count every span since startup; the rings keep the most recent kRingSize spans
+// per thread for percentiles and for the Chrome trace (chrome://tracing, Perfetto), where tail
+// latency spikes show up next to what the other threads were doing at the time.
+namespace trace {
+
+enum class Stage : uint8_t { Capture, Detect, Sample, Classify, Validate, Orient, Repair, Solve, Track, Count };
+
+constexpr size_t kStages = static_cast<size_t>(Stage::Count);
+constexpr const char* kStageNames[kStages] = {"capture", "detect", "sample", "classify",
+											  "validate", "orient", "repair", "solve", "track"};
+
+// Spans kept per thread
+constexpr size_t kRingSize = 8192;
+// Histogram bucket upper bounds in microseconds, the last bucket is +Inf
+constexpr uint32_t kBucketBoundsUs[] = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+										250000, 1000000};
+constexpr size_t kBuckets = sizeof(kBucketBoundsUs) / sizeof(kBucketBoundsUs[0]) + 1;
+
+inline std::atomic<bool> enabled_flag{true};
+inline bool enabled() { return enabled_flag.load(std::memory_order_relaxed); }
+inline void setEnabled(bool enabled) { enabled_flag.store(enabled, std::memory_order_relaxed); }
+
+inline uint64_t nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+			.count();
+}
+
+// Appends a finished span to the calling thread's ring and histogram
+void record(Stage stage, uint64_t start_ns, uint64_t end_ns);
+// Name of the calling thread in the Chrome trace (default "thread N")
+void nameThread(const std::string& name);
+
+class Scope {
+public:
+	explicit Scope(Stage stage) : stage(stage), start_ns(enabled() ? nowNs() : 0) {}
+	~Scope() {
+		if (start_ns) record(stage, start_ns, nowNs());
+	}
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+	Stage stage;
+	uint64_t start_ns;
+};
+
+struct Summary {
+	Stage stage;
+	uint64_t count = 0;     // all spans since startup
+	double mean_ms = 0;
+	double max_ms = 0;
+	double p50_ms = 0, p99_ms = 0; // over the spans still in the rings
+};
+
+// Stages that recorded at least one span, in Stage order
+std::vector<Summary> summarize();
+void printSummary();
+
+// Prometheus text exposition format (node_exporter textfile collector); the file is replaced
+// atomically so a scrape never sees half of it
+bool writePrometheus(const std::string& filename);
+// Chrome trace event JSON of the spans still in the rings
+bool writeChromeTrace(const std::string& filename);
+
+// Rewrites a Prometheus file every interval on its own thread until destroyed
+class PeriodicExport {
+public:
+	PeriodicExport(std::string filename, std::chrono::milliseconds interval);
+	~PeriodicExport();
+
+	PeriodicExport(const PeriodicExport&) = delete;
+	PeriodicExport& operator=(const PeriodicExport&) = delete;
+
+private:
+	std::string filename;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	std::thread thread;
+};
+
+} // namespace trace
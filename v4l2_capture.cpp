@@ -0,0 +1,214 @@
+#include "v4l2_capture.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static int64_t steadyNowUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ioctl() that is retried when a signal interrupts it
+static int xioctl(int fd, unsigned long request, void* arg) {
+	int result;
+	do {
+		result = ioctl(fd, request, arg);
+	} while (result == -1 && errno == EINTR);
+	return result;
+}
+
+MmapV4L2FrameSource::MmapV4L2FrameSource(int index, int width, int height, int fps, int buffer_count) : index(index) {
+	const std::string device = "/dev/video" + std::to_string(index);
+	auto fail = [&](const std::string& what) {
+		const std::string message = device + ": " + what + " (" + std::strerror(errno) + ")";
+		if (fd >= 0) {
+			for (Buffer& buffer : buffers) {
+				if (buffer.start) munmap(buffer.start, buffer.length);
+			}
+			close(fd);
+			fd = -1;
+		}
+		throw std::runtime_error(message);
+	};
+
+	fd = open(device.c_str(), O_RDWR | O_NONBLOCK);
+	if (fd < 0) fail("could not be opened");
+
+	v4l2_capability capability{};
+	if (xioctl(fd, VIDIOC_QUERYCAP, &capability) == -1) fail("not a V4L2 device");
+	const uint32_t caps = (capability.capabilities & V4L2_CAP_DEVICE_CAPS) ? capability.device_caps : capability.capabilities;
+	if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+		errno = ENOTSUP;
+		fail("does not support streaming capture");
+	}
+
+	v4l2_format format{};
+	format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	format.fmt.pix.width = width;
+	format.fmt.pix.height = height;
+	format.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+	format.fmt.pix.field = V4L2_FIELD_ANY;
+	if (xioctl(fd, VIDIOC_S_FMT, &format) == -1) fail("could not set the YUYV format");
+	if (format.fmt.pix.pixelformat != V4L2_PIX_FMT_YUYV) {
+		errno = ENOTSUP;
+		fail("does not deliver YUYV");
+	}
+	frame_width = static_cast<int>(format.fmt.pix.width);
+	frame_height = static_cast<int>(format.fmt.pix.height);
+	bytes_per_line = format.fmt.pix.bytesperline ? format.fmt.pix.bytesperline : static_cast<size_t>(frame_width) * 2;
+
+	// The driver picks the closest rate it supports; a failure here only means the default rate
+	v4l2_streamparm parm{};
+	parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	parm.parm.capture.timeperframe.numerator = 1;
+	parm.parm.capture.timeperframe.denominator = fps;
+	if (xioctl(fd, VIDIOC_S_PARM, &parm) == -1) {
+		std::cerr << "Warning: " << device << " does not accept " << fps << " fps" << std::endl;
+	}
+
+	v4l2_requestbuffers request{};
+	request.count = buffer_count;
+	request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	request.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(fd, VIDIOC_REQBUFS, &request) == -1) fail("could not allocate capture buffers");
+	if (request.count < 2) {
+		errno = ENOMEM;
+		fail("needs at least 2 capture buffers");
+	}
+
+	buffers.resize(request.count);
+	for (uint32_t i = 0; i < request.count; i++) {
+		v4l2_buffer buf{};
+		buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_MMAP;
+		buf.index = i;
+		if (xioctl(fd, VIDIOC_QUERYBUF, &buf) == -1) fail("could not query capture buffer");
+		void* start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset);
+		if (start == MAP_FAILED) fail("could not map capture buffer");
+		buffers[i] = {start, buf.length};
+		if (!requeue(static_cast<int>(i))) fail("could not queue capture buffer");
+	}
+
+	v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if (xioctl(fd, VIDIOC_STREAMON, &type) == -1) fail("could not start streaming");
+
+	std::cout << "Camera " << index << ": V4L2 " << frame_width << "x" << frame_height << " YUYV, "
+			  << buffers.size() << " mapped buffers" << std::endl;
+
+	// Warmup with 5 frames to stabilize
+	int64_t timestamp_us;
+	for (int i = 0; i < 5; i++) {
+		grab(timestamp_us);
+	}
+}
+
+MmapV4L2FrameSource::~MmapV4L2FrameSource() {
+	if (fd < 0) return;
+	v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	xioctl(fd, VIDIOC_STREAMOFF, &type);
+	for (Buffer& buffer : buffers) {
+		munmap(buffer.start, buffer.length);
+	}
+	close(fd);
+}
+
+bool MmapV4L2FrameSource::requeue(int buffer) {
+	v4l2_buffer buf{};
+	buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	buf.memory = V4L2_MEMORY_MMAP;
+	buf.index = static_cast<uint32_t>(buffer);
+	return xioctl(fd, VIDIOC_QBUF, &buf) != -1;
+}
+
+bool MmapV4L2FrameSource::dequeue(int& buffer, size_t& bytes_used, int64_t& timestamp_us, int timeout_ms) {
+	pollfd poll_fd{fd, POLLIN, 0};
+	if (poll(&poll_fd, 1, timeout_ms) <= 0) return false;
+
+	v4l2_buffer buf{};
+	buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	buf.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(fd, VIDIOC_DQBUF, &buf) == -1) return false;
+
+	buffer = static_cast<int>(buf.index);
+	bytes_used = buf.bytesused;
+	// Monotonic buffer timestamps are on the clock behind steady_clock and comparable across cameras
+	device_timestamps = (buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC &&
+						(buf.timestamp.tv_sec || buf.timestamp.tv_usec);
+	timestamp_us = device_timestamps ? static_cast<int64_t>(buf.timestamp.tv_sec) * 1000000 + buf.timestamp.tv_usec
+									 : steadyNowUs();
+	return true;
+}
+
+bool MmapV4L2FrameSource::grab(int64_t& timestamp_us) {
+	if (latched >= 0) {
+		requeue(latched);
+		latched = -1;
+	}
+
+	int buffer;
+	size_t bytes_used;
+	if (!dequeue(buffer, bytes_used, timestamp_us, 1000)) return false;
+	// Frames that piled up behind it are older than the newest one: keep only the newest
+	int newer;
+	size_t newer_bytes;
+	int64_t newer_timestamp_us;
+	while (dequeue(newer, newer_bytes, newer_timestamp_us, 0)) {
+		requeue(buffer);
+		buffer = newer;
+		bytes_used = newer_bytes;
+		timestamp_us = newer_timestamp_us;
+	}
+
+	latched = buffer;
+	latched_bytes = bytes_used;
+	return true;
+}
+
+bool MmapV4L2FrameSource::latchedComplete() const {
+	const size_t row_bytes = static_cast<size_t>(frame_width) * 2;
+	return latched >= 0 && latched_bytes >= bytes_per_line * (frame_height - 1) + row_bytes;
+}
+
+bool MmapV4L2FrameSource::retrieve(cv::Mat& frame) {
+	if (!latchedComplete()) return false; // nothing latched, or a short (corrupt) frame
+
+	const size_t row_bytes = static_cast<size_t>(frame_width) * 2;
+	frame.create(frame_height, frame_width, CV_8UC2);
+	const uint8_t* pixels = static_cast<const uint8_t*>(buffers[latched].start);
+	for (int y = 0; y < frame_height; y++) {
+		std::memcpy(frame.ptr<uint8_t>(y), pixels + y * bytes_per_line, row_bytes);
+	}
+	return true;
+}
+
+bool MmapV4L2FrameSource::lend(cv::Mat& frame, int& buffer) {
+	if (!latchedComplete()) return false; // the buffer goes back to the driver on the next grab()
+
+	frame = cv::Mat(frame_height, frame_width, CV_8UC2, buffers[latched].start, bytes_per_line);
+	buffer = latched;
+	latched = -1; // no longer ours to requeue in grab()
+	return true;
+}
+
+void MmapV4L2FrameSource::giveBack(int buffer) {
+	requeue(buffer);
+}
+
+void MmapV4L2FrameSource::minimizeLatency() {
+	// Hand everything that is already filled back to the driver
+	int buffer;
+	size_t bytes_used;
+	int64_t timestamp_us;
+	while (dequeue(buffer, bytes_used, timestamp_us, 0)) {
+		requeue(buffer);
+	}
+}
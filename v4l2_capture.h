@@ -0,0 +1,59 @@
+#pragma once
+#include "frame_source.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Live camera straight through the V4L2 streaming API, without cv::VideoCapture.
+//
+// The driver fills `buffer_count` memory-mapped YUYV buffers; grab() dequeues the newest filled
+// one and hands the previously latched buffer back to the driver. Frames stay CV_8UC2 YUYV as
+// the driver wrote them: no decode and no BGR conversion, two bytes per pixel instead of three.
+//
+// While streaming, lend() gives the latched buffer itself to the camera's ring, which keeps it
+// out of the driver queue until the slot is recycled, so a frame is never copied on the capture
+// side. retrieve() is the copying path for direct capture, where the buffer goes back to the
+// driver on the next grab(). The sticker voter samples either directly (see yuyv.h); display
+// code converts them with yuyv::toBgr().
+//
+// Timestamps are the driver's buffer timestamps when it reports them on CLOCK_MONOTONIC.
+class MmapV4L2FrameSource : public FrameSource {
+public:
+	// Throws if the device cannot be opened or does not stream YUYV at this size
+	MmapV4L2FrameSource(int index, int width, int height, int fps, int buffer_count);
+	~MmapV4L2FrameSource() override;
+
+	MmapV4L2FrameSource(const MmapV4L2FrameSource&) = delete;
+	MmapV4L2FrameSource& operator=(const MmapV4L2FrameSource&) = delete;
+
+	bool grab(int64_t& timestamp_us) override;
+	bool retrieve(cv::Mat& frame) override;
+	bool hasDeviceTimestamps() const override { return device_timestamps; }
+	void minimizeLatency() override;
+	bool deliversYuyv() const override { return true; }
+	size_t lendableBuffers() const override { return buffers.size(); }
+	bool lend(cv::Mat& frame, int& buffer) override;
+	void giveBack(int buffer) override;
+
+	int width() const { return frame_width; }
+	int height() const { return frame_height; }
+
+private:
+	struct Buffer {
+		void* start = nullptr;
+		size_t length = 0;
+	};
+
+	bool requeue(int buffer);
+	bool latchedComplete() const;
+	bool dequeue(int& buffer, size_t& bytes_used, int64_t& timestamp_us, int timeout_ms);
+
+	int index;
+	int fd = -1;
+	int frame_width = 0, frame_height = 0;
+	size_t bytes_per_line = 0;
+	std::vector<Buffer> buffers;
+	int latched = -1; // buffer held by the application since the last grab()
+	size_t latched_bytes = 0;
+	bool device_timestamps = false;
+};
@@ -0,0 +1,108 @@
+#include "white_balance.h"
+#include "hsv_convert.h"
+#include "yuyv.h"
+#include <cmath>
+
+// OpenCV's 8-bit HSV (H in 0-179) back to BGR, for range midpoints only
+static void hsvToBgr(float h, float s, float v, float bgr[3]) {
+	const float hue = h * 2.0f / 60.0f; // sector 0-6
+	const float saturation = s / 255.0f;
+	const int sector = static_cast<int>(hue) % 6;
+	const float f = hue - std::floor(hue);
+	const float p = v * (1 - saturation);
+	const float q = v * (1 - saturation * f);
+	const float t = v * (1 - saturation * (1 - f));
+	float r, g, b;
+	switch (sector) {
+		case 0: r = v; g = t; b = p; break;
+		case 1: r = q; g = v; b = p; break;
+		case 2: r = p; g = v; b = t; break;
+		case 3: r = p; g = q; b = v; break;
+		case 4: r = t; g = p; b = v; break;
+		default: r = v; g = p; b = q; break;
+	}
+	bgr[0] = b;
+	bgr[1] = g;
+	bgr[2] = r;
+}
+
+void WhiteBalance::faceCenters(const std::vector<cv::Point>& points, std::vector<cv::Point>& centers) {
+	centers.clear();
+	if (points.size() != 24) return;
+	// Per face: TL, T, TR, L, R, BL, B, BR; the edges are T, L, R and B
+	for (int face = 0; face < 3; face++) {
+		const cv::Point* p = points.data() + face * 8;
+		centers.emplace_back((p[1].x + p[3].x + p[4].x + p[6].x + 2) / 4, (p[1].y + p[3].y + p[4].y + p[6].y + 2) / 4);
+	}
+}
+
+bool WhiteBalance::referenceColor(char color, float bgr[3]) const {
+	const std::vector<ColorClassifier::Rule>& rules = classifier.getRules();
+	for (auto rule = rules.rbegin(); rule != rules.rend(); ++rule) {
+		if (rule->color != color) continue;
+		float h = (rule->h_min + rule->h_max) / 2.0f;
+		if (rule->hue_wrap) h = std::fmod((rule->h_min + rule->h_max + 180) / 2.0f, 180.0f);
+		float s = (std::clamp(rule->s_min, 0, 255) + std::clamp(rule->s_max, 0, 255)) / 2.0f;
+		// A range over every hue (white) has no hue of its own: its reference is neutral
+		if (!rule->hue_wrap && rule->h_min <= 0 && rule->h_max >= 179) s = std::clamp(rule->s_min, 0, 255);
+		hsvToBgr(h, s, (std::clamp(rule->v_min, 0, 255) + std::clamp(rule->v_max, 0, 255)) / 2.0f, bgr);
+		return true;
+	}
+	return false;
+}
+
+int WhiteBalance::update(const cv::Mat& frame, const std::vector<cv::Point>& centers, Gains& gains) const {
+	if (frame.empty() || centers.empty()) return 0;
+	const bool yuyv_frame = yuyv::isYuyv(frame);
+
+	double reference_dot[3] = {0, 0, 0}; // sum of reference * observed per channel
+	double observed_sq[3] = {0, 0, 0};   // sum of observed^2 per channel
+	int used = 0;
+	for (const cv::Point& center : centers) {
+		// Mean over a 3x3 patch with the voter's default spacing
+		int sum[3] = {0, 0, 0};
+		for (int dy = -2; dy <= 2; dy += 2) {
+			for (int dx = -2; dx <= 2; dx += 2) {
+				const int x = std::clamp(center.x + dx, 0, frame.cols - 1);
+				const int y = std::clamp(center.y + dy, 0, frame.rows - 1);
+				uint8_t b, g, r;
+				if (yuyv_frame) {
+					yuyv::pixelBgr(frame, x, y, b, g, r);
+				} else {
+					const cv::Vec3b& bgr = frame.at<cv::Vec3b>(y, x);
+					b = bgr[0];
+					g = bgr[1];
+					r = bgr[2];
+				}
+				sum[0] += b;
+				sum[1] += g;
+				sum[2] += r;
+			}
+		}
+		const uint8_t observed[3] = {static_cast<uint8_t>(sum[0] / 9), static_cast<uint8_t>(sum[1] / 9),
+									 static_cast<uint8_t>(sum[2] / 9)};
+
+		// Identify the center the way detection would see it now
+		uint8_t corrected[3] = {observed[0], observed[1], observed[2]};
+		gains.apply(corrected[0], corrected[1], corrected[2]);
+		const cv::Vec3b hsv = hsv::fromBgr(corrected[0], corrected[1], corrected[2]);
+		const char color = classifier.classify(hsv[0], hsv[1], hsv[2]);
+		float reference[3];
+		if (color == 'N' || !referenceColor(color, reference)) continue;
+
+		for (int c = 0; c < 3; c++) {
+			reference_dot[c] += reference[c] * observed[c];
+			observed_sq[c] += static_cast<double>(observed[c]) * observed[c];
+		}
+		used++;
+	}
+	if (used < 2) return used;
+
+	uint16_t* channels[3] = {&gains.b, &gains.g, &gains.r};
+	for (int c = 0; c < 3; c++) {
+		if (observed_sq[c] <= 0) continue;
+		const float estimate = std::clamp(static_cast<float>(reference_dot[c] / observed_sq[c]), kMinGain, kMaxGain);
+		*channels[c] = static_cast<uint16_t>((*channels[c] + std::lround(estimate * 256)) / 2);
+	}
+	return used;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include "color_lut.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Per-frame illumination compensation from the face centers.
+//
+// The centers are not calibrated points, but each one sits in the middle of its face's eight
+// stickers and always shows one of the six known colors. Per camera the three centers are
+// sampled, identified with the classifier, and compared against the middle of that color's
+// calibrated HSV range; a per-channel gain (von Kries diagonal model, least squares over the
+// centers) maps what the camera sees back onto the calibrated colors. The gains are applied to
+// the sampled sticker pixels only, before classification, so the frame itself is never touched.
+class WhiteBalance {
+public:
+	// Channel gains in 8.8 fixed point (256 = 1.0)
+	struct Gains {
+		uint16_t b = 256, g = 256, r = 256;
+
+		bool identity() const { return b == 256 && g == 256 && r == 256; }
+		void apply(uint8_t& blue, uint8_t& green, uint8_t& red) const {
+			blue = static_cast<uint8_t>(std::min(255, (blue * b + 128) >> 8));
+			green = static_cast<uint8_t>(std::min(255, (green * g + 128) >> 8));
+			red = static_cast<uint8_t>(std::min(255, (red * r + 128) >> 8));
+		}
+	};
+
+	static constexpr float kMinGain = 0.5f;
+	static constexpr float kMaxGain = 2.0f;
+
+	// Reads the reference colors from `classifier` on every update, so a reloaded calibration
+	// applies to the next frame
+	explicit WhiteBalance(const ColorClassifier& classifier) : classifier(classifier) {}
+
+	// Face centers of one camera from its 24 sticker points: the mean of each face's four edge
+	// stickers. Empty if the points are not three faces of eight.
+	static void faceCenters(const std::vector<cv::Point>& points, std::vector<cv::Point>& centers);
+
+	// Updates `gains` from one frame (BGR or YUYV). The centers are identified under the current
+	// gains, so the estimate follows gradual drift; with fewer than two identified centers the
+	// gains are kept. New estimates are averaged with the previous gains to damp flicker.
+	// Returns the number of centers used.
+	int update(const cv::Mat& frame, const std::vector<cv::Point>& centers, Gains& gains) const;
+
+private:
+	// Middle of the highest-priority range of `color`, as BGR; false if there is none
+	bool referenceColor(char color, float bgr[3]) const;
+
+	const ColorClassifier& classifier;
+};
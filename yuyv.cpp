@@ -0,0 +1,42 @@
+#include "yuyv.h"
+#include <iostream>
+
+namespace yuyv {
+
+size_t selfTest() {
+	// One row per (U, V) pair; its 256 pixel pairs carry Y = 2k and 2k + 1
+	cv::Mat frame(256 * 256, 256, CV_8UC2);
+	for (int row = 0; row < frame.rows; row++) {
+		uint8_t* p = frame.ptr<uint8_t>(row);
+		for (int pair = 0; pair < frame.cols / 2; pair++) {
+			p[pair * 4 + 0] = static_cast<uint8_t>(pair * 2);
+			p[pair * 4 + 1] = static_cast<uint8_t>(row >> 8);
+			p[pair * 4 + 2] = static_cast<uint8_t>(pair * 2 + 1);
+			p[pair * 4 + 3] = static_cast<uint8_t>(row & 255);
+		}
+	}
+	cv::Mat bgr;
+	cv::cvtColor(frame, bgr, cv::COLOR_YUV2BGR_YUYV);
+
+	size_t mismatches = 0;
+	for (int row = 0; row < frame.rows; row++) {
+		for (int x = 0; x < frame.cols; x++) {
+			uint8_t b, g, r;
+			pixelBgr(frame, x, row, b, g, r);
+			const cv::Vec3b& expected = bgr.at<cv::Vec3b>(row, x);
+			if (expected[0] != b || expected[1] != g || expected[2] != r) {
+				if (mismatches < 10) {
+					const uint8_t* p = frame.ptr<uint8_t>(row) + (x & ~1) * 2;
+					std::cout << "  YUV (" << int(p[(x & 1) * 2]) << "," << int(p[1]) << "," << int(p[3])
+							  << "): BGR (" << int(b) << "," << int(g) << "," << int(r) << "), cvtColor ("
+							  << int(expected[0]) << "," << int(expected[1]) << "," << int(expected[2]) << ")"
+							  << std::endl;
+				}
+				mismatches++;
+			}
+		}
+	}
+	return mismatches;
+}
+
+} // namespace yuyv
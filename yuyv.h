@@ -0,0 +1,79 @@
+#pragma once
+#include "opencv2/opencv.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+// Packed YUYV (4:2:2) frames as the cameras deliver them: CV_8UC2 Mats with Y0 U Y1 V per pixel
+// pair. Detection samples sticker pixels straight out of these, so the full frame is never
+// converted; display and calibration convert whole frames with toBgr().
+//
+// The per-pixel conversion uses the fixed-point BT.601 limited-range arithmetic of OpenCV's
+// COLOR_YUV2BGR_YUYV, so a sampled pixel has exactly the BGR value cvtColor would give it and
+// the HSV ranges calibrated on converted frames apply unchanged (menu option l checks this). The
+// products are precomputed per channel value into five 256-entry tables (5 KB).
+namespace yuyv {
+
+constexpr int kShift = 20;
+constexpr int kCY = 1220542;
+constexpr int kCUB = 2116026;
+constexpr int kCUG = -409993;
+constexpr int kCVG = -852492;
+constexpr int kCVR = 1673527;
+
+struct Tables {
+	std::array<int32_t, 256> y;   // max(0, Y - 16) * CY
+	std::array<int32_t, 256> r_v; // rounding + CVR * (V - 128)
+	std::array<int32_t, 256> g_u; // rounding + CUG * (U - 128)
+	std::array<int32_t, 256> g_v; // CVG * (V - 128)
+	std::array<int32_t, 256> b_u; // rounding + CUB * (U - 128)
+};
+
+constexpr Tables makeTables() {
+	Tables t{};
+	constexpr int round = 1 << (kShift - 1);
+	for (int i = 0; i < 256; i++) {
+		t.y[i] = std::max(0, i - 16) * kCY;
+		t.r_v[i] = round + kCVR * (i - 128);
+		t.g_u[i] = round + kCUG * (i - 128);
+		t.g_v[i] = kCVG * (i - 128);
+		t.b_u[i] = round + kCUB * (i - 128);
+	}
+	return t;
+}
+
+inline constexpr Tables kTables = makeTables();
+
+inline uint8_t saturate(int32_t value) {
+	return static_cast<uint8_t>(std::clamp(value >> kShift, 0, 255));
+}
+
+inline void toBgr(uint8_t y, uint8_t u, uint8_t v, uint8_t& b, uint8_t& g, uint8_t& r) {
+	const int32_t luma = kTables.y[y];
+	b = saturate(luma + kTables.b_u[u]);
+	g = saturate(luma + kTables.g_u[u] + kTables.g_v[v]);
+	r = saturate(luma + kTables.r_v[v]);
+}
+
+// BGR value of pixel (x, y) of a YUYV frame; the pixel pair shares U and V
+inline void pixelBgr(const cv::Mat& frame, int x, int y, uint8_t& b, uint8_t& g, uint8_t& r) {
+	const uint8_t* pair = frame.ptr<uint8_t>(y) + (x & ~1) * 2;
+	toBgr(pair[(x & 1) * 2], pair[1], pair[3], b, g, r);
+}
+
+inline bool isYuyv(const cv::Mat& frame) { return frame.type() == CV_8UC2; }
+
+// Whole-frame conversion for display; BGR frames are copied as they are
+inline void toBgr(const cv::Mat& frame, cv::Mat& bgr) {
+	if (isYuyv(frame)) {
+		cv::cvtColor(frame, bgr, cv::COLOR_YUV2BGR_YUYV);
+	} else {
+		frame.copyTo(bgr);
+	}
+}
+
+// Compares pixelBgr() against cv::cvtColor over every (Y, U, V) combination and returns the
+// number of mismatching pixels
+size_t selfTest();
+
+} // namespace yuyv